@@ -1,9 +1,23 @@
+#ifdef STR_STATS
+#define _POSIX_C_SOURCE 200809L
+#endif /* STR_STATS */
+
 #include <assert.h>
 #include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "str.h"
+#include "str_private.h"
+#include "str_simd.h"
+
+#ifdef STR_STATS
+#include <pthread.h>
+#include <stdatomic.h>
+#endif /* STR_STATS */
 
 static const size_t STR_DEFAULT_SIZE = 8;
 static const size_t STR_RESIZE_SIZE = 32;
@@ -11,16 +25,204 @@ static const size_t STR_RESIZE_SIZE = 32;
 struct str {
     char* data;
     size_t used;
+    /* 0 for literals made by STR_LIT, which are never written */
     size_t max;
 };
 
+_Static_assert(sizeof (struct str) == sizeof (struct str_literal)
+        && offsetof(struct str, data) == offsetof(struct str_literal, data)
+        && offsetof(struct str, used) == offsetof(struct str_literal, used)
+        && offsetof(struct str, max) == offsetof(struct str_literal, max),
+        "struct str_literal must mirror struct str");
+
+/* -- Statistics -- */
+
+/* counters of a thread, laid out as a flat array */
+enum {
+    STAT_ALLOCATIONS,
+    STAT_REALLOCATIONS,
+    STAT_FREES,
+    STAT_REQUESTED,
+    STAT_LIVE,
+    STAT_USED,
+    STAT_OPS,
+    STAT_SIZES = STAT_OPS + STR_STATS_OPS,
+    STAT_COUNT = STAT_SIZES + STR_STATS_BUCKETS,
+};
+
+#ifdef STR_STATS
+
+struct stats_block {
+    /* only the owning thread writes, other threads read
+     * while merging, hence relaxed atomics without RMW */
+    _Atomic size_t counters[STAT_COUNT];
+    struct stats_block* prev;
+    struct stats_block* next;
+};
+
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t stats_once = PTHREAD_ONCE_INIT;
+static pthread_key_t stats_key;
+
+/* blocks of running threads and sums of exited ones, under stats_lock */
+static struct stats_block* stats_blocks;
+static size_t stats_retired[STAT_COUNT];
+
+static _Thread_local struct stats_block* stats_local;
+
+static void stats_retire(void* arg) {
+    struct stats_block* block = arg;
+
+    pthread_mutex_lock(&stats_lock);
+
+    for (size_t i = 0; i < STAT_COUNT; ++i) {
+        stats_retired[i] += atomic_load_explicit(&block->counters[i],
+                memory_order_relaxed);
+    }
+
+    if (block->prev) {
+        block->prev->next = block->next;
+    } else {
+        stats_blocks = block->next;
+    }
+
+    if (block->next) {
+        block->next->prev = block->prev;
+    }
+
+    pthread_mutex_unlock(&stats_lock);
+
+    /* calls from later destructors of the thread register a new block,
+     * which the next round of destructors retires */
+    stats_local = (void*) 0;
+    free(block);
+}
+
+static void stats_init(void) {
+    pthread_key_create(&stats_key, stats_retire);
+}
+
+static struct stats_block* stats_block(void) {
+    if (stats_local) {
+        return stats_local;
+    }
+
+    pthread_once(&stats_once, stats_init);
+
+    struct stats_block* block = calloc(1, sizeof (struct stats_block));
+
+    if (!block) {
+        return (void*) 0;
+    }
+
+    pthread_mutex_lock(&stats_lock);
+
+    block->next = stats_blocks;
+
+    if (stats_blocks) {
+        stats_blocks->prev = block;
+    }
+
+    stats_blocks = block;
+
+    pthread_mutex_unlock(&stats_lock);
+
+    /* retires the block when the thread exits */
+    pthread_setspecific(stats_key, block);
+    stats_local = block;
+
+    return block;
+}
+
+static void stats_add(size_t counter, size_t value) {
+    struct stats_block* block = stats_block();
+
+    if (!block) {
+        return;
+    }
+
+    _Atomic size_t* c = &block->counters[counter];
+
+    atomic_store_explicit(c,
+            atomic_load_explicit(c, memory_order_relaxed) + value,
+            memory_order_relaxed);
+}
+
+static size_t stats_bucket(size_t len) {
+    size_t bucket = 0;
+
+    for (; len; len >>= 1) {
+        bucket++;
+    }
+
+    return bucket;
+}
+
+#define STATS_ADD(counter, value) stats_add((counter), (value))
+#define STATS_OP(op) stats_add(STAT_OPS + (op), 1)
+#define STATS_SIZE(len) stats_add(STAT_SIZES + stats_bucket(len), 1)
+
+#else
+
+#define STATS_ADD(counter, value) ((void) 0)
+#define STATS_OP(op) ((void) 0)
+#define STATS_SIZE(len) ((void) 0)
+
+#endif /* STR_STATS */
+
 /* -- Private Interface -- */
 
+static void* allocate(size_t size) {
+    void* p = malloc(size);
+
+    if (p) {
+        STATS_ADD(STAT_ALLOCATIONS, 1);
+        STATS_ADD(STAT_REQUESTED, size);
+        STATS_ADD(STAT_LIVE, size);
+    }
+
+    return p;
+}
+
+static void* reallocate(void* p, size_t old_size, size_t size) {
+    void* q = realloc(p, size);
+
+    if (q) {
+        STATS_ADD(STAT_REALLOCATIONS, 1);
+        STATS_ADD(STAT_REQUESTED, size);
+
+        /* wraps around when shrinking, which the merged sum undoes */
+        STATS_ADD(STAT_LIVE, size - old_size);
+    }
+
+    (void) old_size;
+
+    return q;
+}
+
+static void release(void* p, size_t size) {
+    if (p) {
+        STATS_ADD(STAT_FREES, 1);
+        STATS_ADD(STAT_LIVE, -size);
+    }
+
+    (void) size;
+
+    free(p);
+}
+
+static bool is_literal(struct str* self) {
+    assert(self != (void*) 0);
+
+    return self->max == 0;
+}
+
 static bool is_full(struct str* self) {
     assert(self != (void*) 0);
     assert(self->data != (void*) 0);
 
-    if (self->used >= self->max) {
+    /* + 1 for the \0 byte */
+    if (self->used + 1 >= self->max) {
         return true;
     }
 
@@ -30,7 +232,11 @@ static bool is_full(struct str* self) {
 static bool resize(struct str* self, size_t value) {
     assert(self != (void*) 0);
     assert(self->data != (void*) 0);
-    assert(self->used + value >= self->max);
+    assert(self->used + value + 1 >= self->max);
+
+    if (is_literal(self)) {
+        return false;
+    }
 
     if (!value) {
         value = STR_RESIZE_SIZE;
@@ -43,191 +249,770 @@ static bool resize(struct str* self, size_t value) {
 
     self->max += value;
 
-    char* data = realloc(self->data, self->max);
+    char* data = reallocate(self->data, self->max - value, self->max);
 
     if (!data) {
         self->max -= value;
         return false;
     }
 
-    self->data = data;
+    self->data = data;
+
+    return true;
+}
+
+static bool reserve(struct str* self, size_t value) {
+    assert(self != (void*) 0);
+    assert(self->data != (void*) 0);
+
+    /* + 1 for the \0 byte */
+    size_t needed = self->used + value + 1;
+
+    /* overflow */
+    if (needed <= self->used || is_literal(self)) {
+        return false;
+    }
+
+    if (needed <= self->max) {
+        return true;
+    }
+
+    /* at least doubles, so appends in a loop reallocate log n times */
+    size_t max = self->max > SIZE_MAX / 2 ? needed : self->max * 2;
+
+    if (max < needed) {
+        max = needed;
+    }
+
+    char* data = reallocate(self->data, self->max, max);
+
+    if (!data) {
+        return false;
+    }
+
+    self->data = data;
+    self->max = max;
+
+    return true;
+}
+
+static str_view rebase(struct str* self, char const* old_data,
+        size_t old_max, str_view v) {
+    assert(self != (void*) 0);
+
+    uintptr_t begin = (uintptr_t) old_data;
+    uintptr_t p = (uintptr_t) v.data;
+
+    /* v pointed into self, whose buffer might have moved */
+    if (p >= begin && p < begin + old_max) {
+        v.data = self->data + (p - begin);
+    }
+
+    return v;
+}
+
+bool str_reserve_view(struct str* self, str_view* v, size_t n) {
+    assert(v != (void*) 0);
+
+    if (!self) {
+        return false;
+    }
+
+    STATS_OP(STR_STATS_RESERVE);
+
+    char const* old_data = self->data;
+    size_t old_max = self->max;
+
+    if (!reserve(self, n)) {
+        return false;
+    }
+
+    *v = rebase(self, old_data, old_max, *v);
+
+    return true;
+}
+
+static void append_view(struct str* self, str_view v) {
+    assert(self != (void*) 0);
+    assert(self->used + v.len < self->max);
+
+    if (v.len) {
+        memcpy(self->data + self->used, v.data, v.len);
+        self->used += v.len;
+
+        STATS_ADD(STAT_USED, v.len);
+    }
+}
+
+static bool append(struct str* self, str_view v) {
+    assert(self != (void*) 0);
+    assert(self->data != (void*) 0);
+
+    if (!v.len) {
+        return true;
+    }
+
+    char const* old_data = self->data;
+    size_t old_max = self->max;
+
+    if (!reserve(self, v.len)) {
+        return false;
+    }
+
+    append_view(self, rebase(self, old_data, old_max, v));
+
+    return true;
+}
+
+/* appends n copies of c */
+static bool fill(struct str* self, char c, size_t n) {
+    assert(self != (void*) 0);
+
+    if (!reserve(self, n)) {
+        return false;
+    }
+
+    memset(self->data + self->used, c, n);
+    self->used += n;
+
+    STATS_ADD(STAT_USED, n);
+
+    return true;
+}
+
+/* pads self up to width with left characters of c on the left and the
+ * rest on the right */
+static bool pad(struct str* self, size_t width, size_t left, char c) {
+    assert(self != (void*) 0);
+    assert(self->used + left <= width);
+
+    size_t n = width - self->used;
+
+    if (!reserve(self, n)) {
+        return false;
+    }
+
+    memmove(self->data + left, self->data, self->used);
+    memset(self->data, c, left);
+    memset(self->data + left + self->used, c, n - left);
+    self->used += n;
+
+    STATS_ADD(STAT_USED, n);
+
+    return true;
+}
+
+#ifdef STR_SIMD_X86
+
+STR_SIMD_TARGET("avx2")
+static size_t mismatch_avx2(char const* a, char const* b, size_t n) {
+    size_t i = 0;
+
+    /* 64 bytes a round, which of the halves differs is sorted out
+     * after the loop */
+    for (; i + 64 <= n; i += 64) {
+        __m256i low = _mm256_cmpeq_epi8(
+                _mm256_loadu_si256((__m256i const*) (a + i)),
+                _mm256_loadu_si256((__m256i const*) (b + i)));
+        __m256i high = _mm256_cmpeq_epi8(
+                _mm256_loadu_si256((__m256i const*) (a + i + 32)),
+                _mm256_loadu_si256((__m256i const*) (b + i + 32)));
+
+        if (~(uint32_t) _mm256_movemask_epi8(_mm256_and_si256(low, high))) {
+            break;
+        }
+    }
+
+    for (; i + 32 <= n; i += 32) {
+        uint32_t mask = ~(uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(
+                    _mm256_loadu_si256((__m256i const*) (a + i)),
+                    _mm256_loadu_si256((__m256i const*) (b + i))));
+
+        if (mask) {
+            return i + (size_t) __builtin_ctz(mask);
+        }
+    }
+
+    return i;
+}
+
+/* two 16 byte compares make up a 32 bit mask */
+static size_t mismatch_sse2(char const* a, char const* b, size_t i,
+        size_t n) {
+    for (; i + 32 <= n; i += 32) {
+        uint32_t low = (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(
+                    _mm_loadu_si128((__m128i const*) (a + i)),
+                    _mm_loadu_si128((__m128i const*) (b + i))));
+        uint32_t high = (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(
+                    _mm_loadu_si128((__m128i const*) (a + i + 16)),
+                    _mm_loadu_si128((__m128i const*) (b + i + 16))));
+        uint32_t mask = ~(low | high << 16);
+
+        if (mask) {
+            return i + (size_t) __builtin_ctz(mask);
+        }
+    }
+
+    if (i + 16 <= n) {
+        uint32_t mask = ~(uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(
+                    _mm_loadu_si128((__m128i const*) (a + i)),
+                    _mm_loadu_si128((__m128i const*) (b + i)))) & 0xffff;
+
+        if (mask) {
+            return i + (size_t) __builtin_ctz(mask);
+        }
+
+        i += 16;
+    }
+
+    return i;
+}
+
+#endif /* STR_SIMD_X86 */
+
+/* returns index of the first byte a and b differ at, or n */
+static size_t mismatch(char const* a, char const* b, size_t n) {
+    size_t i = 0;
+
+#ifdef STR_SIMD_X86
+    /* the kernels stop at a difference, which the next one finds
+     * again right away */
+    if (n >= 64 && str_simd_detect() == STR_SIMD_AVX2) {
+        i = mismatch_avx2(a, b, n);
+    }
+
+    i = mismatch_sse2(a, b, i, n);
+#endif /* STR_SIMD_X86 */
+
+    for (; i + 8 <= n; i += 8) {
+        uint64_t x;
+        uint64_t y;
+
+        memcpy(&x, a + i, 8);
+        memcpy(&y, b + i, 8);
+
+        if (x != y) {
+            break;
+        }
+    }
+
+    while (i < n && a[i] == b[i]) {
+        i++;
+    }
+
+    return i;
+}
+
+static struct str* create(void) {
+    struct str* str = allocate(sizeof (struct str));
+
+    if (!str) {
+        return (void*) 0;
+    }
+
+    str->used = 0;
+    str->max = STR_DEFAULT_SIZE;
+
+    str->data = allocate(str->max);
+
+    if (!str->data) {
+        release(str, sizeof (struct str));
+        return (void*) 0;
+    }
+
+    return str;
+}
+
+static void destroy(struct str* self) {
+    assert(self != (void*) 0);
+
+    STATS_SIZE(self->used);
+    STATS_ADD(STAT_USED, -self->used);
+
+    release(self->data, self->max);
+    release(self, sizeof (struct str));
+}
+
+static struct str* from_view(str_view v) {
+    struct str* s = create();
+
+    if (!s) {
+        return (void*) 0;
+    }
+
+    if (!reserve(s, v.len)) {
+        destroy(s);
+        return (void*) 0;
+    }
+
+    append_view(s, v);
+
+    return s;
+}
+
+static struct str* join(str_view const* parts, size_t n, str_view sep) {
+    struct str* s = create();
+
+    if (!s) {
+        return (void*) 0;
+    }
+
+    if (!n) {
+        return s;
+    }
+
+    /* overflow */
+    if (n > 1 && sep.len > SIZE_MAX / (n - 1)) {
+        destroy(s);
+        return (void*) 0;
+    }
+
+    size_t total = sep.len * (n - 1);
+
+    for (size_t i = 0; i < n; ++i) {
+        if (total + parts[i].len < total) {
+            destroy(s);
+            return (void*) 0;
+        }
+
+        total += parts[i].len;
+    }
+
+    if (!reserve(s, total)) {
+        destroy(s);
+        return (void*) 0;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        if (i) {
+            append_view(s, sep);
+        }
+
+        append_view(s, parts[i]);
+    }
+
+    return s;
+}
+
+static bool append_number(struct str* out, char const* format,
+        char const* name, size_t value) {
+    char buffer[96];
+    int len = snprintf(buffer, sizeof buffer, format, name, value);
+
+    if (len < 0 || (size_t) len >= sizeof buffer) {
+        return false;
+    }
+
+    return append(out, (str_view) { buffer, (size_t) len });
+}
+
+/* -- Public Interface Implementation -- */
+
+struct str* str_new(void) {
+    STATS_OP(STR_STATS_NEW);
+
+    return create();
+}
+
+void str_del(str* self) {
+    if (!self || is_literal(self)) {
+        return;
+    }
+
+    STATS_OP(STR_STATS_DEL);
+
+    destroy(self);
+}
+
+struct str* str_from_char(char c) {
+    STATS_OP(STR_STATS_FROM);
+
+    return from_view((str_view) { &c, 1 });
+}
+
+struct str* str_from_cstr(char const* s) {
+    STATS_OP(STR_STATS_FROM);
+
+    return from_view(str_view_from_cstr(s));
+}
+
+struct str* str_from_str(struct str* s) {
+    STATS_OP(STR_STATS_FROM);
+
+    return from_view(str_view_from_str(s));
+}
+
+struct str* str_from_view(str_view v) {
+    STATS_OP(STR_STATS_FROM);
+
+    return from_view(v);
+}
+
+char const* str_cstr(struct str* self) {
+    if (!self) {
+        return "";
+    }
+
+    assert(self->data != (void*) 0);
+
+    if (is_literal(self)) {
+        /* literals are null terminated already */
+        return self->data;
+    }
+
+    /* makes sure cstr is null terminated */
+    self->data[self->used] = 0;
+
+    return self->data;
+}
+
+str_view str_view_from_str(struct str* s) {
+    if (!s) {
+        return (str_view) { "", 0 };
+    }
+
+    assert(s->data != (void*) 0);
+
+    return (str_view) { s->data, s->used };
+}
+
+str_view str_view_from_cstr(char const* s) {
+    if (!s) {
+        return (str_view) { "", 0 };
+    }
+
+    return (str_view) { s, strlen(s) };
+}
+
+str_view str_view_from_view(str_view v) {
+    return v;
+}
+
+size_t str_len(struct str* self) {
+    if (!self) {
+        return 0;
+    }
+
+    assert(self->data != (void*) 0);
+
+    return self->used;
+}
+
+bool str_empty(struct str* self) {
+    if (!self) {
+        return false;
+    }
+
+    assert(self->data != (void*) 0);
+
+    return self->used == 0;
+}
+
+bool str_append_char(struct str* self, char c) {
+    if (!self) {
+        return false;
+    }
+
+    assert(self->data != (void*) 0);
+
+    STATS_OP(STR_STATS_APPEND);
+
+    if (is_full(self)) {
+        if (!resize(self, 0)) {
+            return false;
+        }
+    }
+
+    self->data[self->used] = c;
+    self->used++;
+
+    STATS_ADD(STAT_USED, 1);
+
+    return true;
+}
+
+bool str_append_cstr(struct str* self, char const* s) {
+    if (!self || !s) {
+        return false;
+    }
+
+    assert(self->data != (void*) 0);
+
+    STATS_OP(STR_STATS_APPEND);
+
+    return append(self, str_view_from_cstr(s));
+}
+
+bool str_append_str(struct str* self, struct str* s) {
+    if (!self || !s) {
+        return false;
+    }
+
+    assert(self->data != (void*) 0);
+    assert(s->data != (void*) 0);
+
+    STATS_OP(STR_STATS_APPEND);
+
+    return append(self, (str_view) { s->data, s->used });
+}
+
+bool str_append_view(struct str* self, str_view v) {
+    if (!self) {
+        return false;
+    }
+
+    assert(self->data != (void*) 0);
+
+    STATS_OP(STR_STATS_APPEND);
+
+    return append(self, v);
+}
+
+bool str_append_views(struct str* self, str_view const* views, size_t n) {
+    if (!self || (!views && n)) {
+        return false;
+    }
+
+    assert(self->data != (void*) 0);
+
+    STATS_OP(STR_STATS_APPEND);
+
+    size_t total = 0;
+
+    for (size_t i = 0; i < n; ++i) {
+        /* overflow */
+        if (total + views[i].len < total) {
+            return false;
+        }
+
+        total += views[i].len;
+    }
+
+    char const* old_data = self->data;
+    size_t old_max = self->max;
+
+    if (!reserve(self, total)) {
+        return false;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        append_view(self, rebase(self, old_data, old_max, views[i]));
+    }
+
+    return true;
+}
+
+bool str_reserve(struct str* self, size_t n) {
+    if (!self) {
+        return false;
+    }
+
+    STATS_OP(STR_STATS_RESERVE);
+
+    return reserve(self, n);
+}
+
+bool str_fill(str* self, char c, size_t n) {
+    if (!self) {
+        return false;
+    }
+
+    assert(self->data != (void*) 0);
+
+    STATS_OP(STR_STATS_APPEND);
+
+    return fill(self, c, n);
+}
+
+bool str_pad_left(str* self, size_t width, char c) {
+    if (!self) {
+        return false;
+    }
+
+    assert(self->data != (void*) 0);
+
+    STATS_OP(STR_STATS_INSERT);
+
+    if (self->used >= width) {
+        return true;
+    }
+
+    return pad(self, width, width - self->used, c);
+}
+
+bool str_pad_right(str* self, size_t width, char c) {
+    if (!self) {
+        return false;
+    }
+
+    assert(self->data != (void*) 0);
 
-    return true;
-}
+    STATS_OP(STR_STATS_APPEND);
 
-/* -- Public Interface Implementation -- */
+    if (self->used >= width) {
+        return true;
+    }
 
-struct str* str_new(void) {
-    struct str* str = malloc(sizeof (struct str));
+    return fill(self, c, width - self->used);
+}
 
-    if (!str) {
-        return (void*) 0;
+bool str_center(str* self, size_t width, char c) {
+    if (!self) {
+        return false;
     }
 
-    str->used = 0;
-    str->max = STR_DEFAULT_SIZE;
+    assert(self->data != (void*) 0);
 
-    str->data = malloc(str->max);
+    STATS_OP(STR_STATS_INSERT);
 
-    if (!str->data) {
-        free(str);
-        return (void*) 0;
+    if (self->used >= width) {
+        return true;
     }
 
-    return str;
+    return pad(self, width, (width - self->used) / 2, c);
 }
 
-void str_del(str* self) {
-    if (!self) {
-        return;
+struct str* str_repeat(str_view v, size_t n) {
+    if (!v.data && v.len) {
+        return (void*) 0;
     }
 
-    if (self->data) {
-        free(self->data);
-    }
+    STATS_OP(STR_STATS_FROM);
 
-    free(self);
-}
+    /* overflow */
+    if (v.len && n > SIZE_MAX / v.len) {
+        return (void*) 0;
+    }
 
-struct str* str_from_char(char c) {
-    struct str* s = str_new();
+    size_t total = v.len * n;
+    struct str* s = create();
 
     if (!s) {
         return (void*) 0;
     }
 
-    if (!str_append_char(s, c)) {
-        str_del(s);
+    if (!reserve(s, total)) {
+        destroy(s);
         return (void*) 0;
     }
 
-    return s;
-}
+    if (total) {
+        memcpy(s->data, v.data, v.len);
+    }
 
-struct str* str_from_cstr(char const* s) {
-    struct str* snew = str_new();
+    /* doubles what is there until it's long enough */
+    for (size_t done = v.len; done < total;) {
+        size_t k = done < total - done ? done : total - done;
 
-    if (!snew) {
-        return (void*) 0;
+        memcpy(s->data + done, s->data, k);
+        done += k;
     }
 
-    if (!s) {
-        return snew;
-    }
+    s->used = total;
+
+    STATS_ADD(STAT_USED, total);
 
-    if (!str_append_cstr(snew, s)) {
-        str_del(snew);
+    return s;
+}
+
+struct str* str_join_views(str_view const* parts, size_t n, str_view sep) {
+    if (!parts && n) {
         return (void*) 0;
     }
 
-    return snew;
-}
+    STATS_OP(STR_STATS_JOIN);
 
-struct str* str_from_str(struct str* s) {
-    return str_clone(s);
+    return join(parts, n, sep);
 }
 
-char const* str_cstr(struct str* self) {
-    if (!self) {
-        return "";
+struct str* str_join_strs(struct str* const* parts, size_t n, str_view sep) {
+    if (!parts && n) {
+        return (void*) 0;
     }
 
-    assert(self->data != (void*) 0);
+    STATS_OP(STR_STATS_JOIN);
 
-    /* makes sure cstr is null terminated */
-    self->data[self->used] = 0;
+    str_view* views = allocate((n ? n : 1) * sizeof (str_view));
 
-    return self->data;
-}
+    if (!views) {
+        return (void*) 0;
+    }
 
-size_t str_len(struct str* self) {
-    if (!self) {
-        return 0;
+    for (size_t i = 0; i < n; ++i) {
+        views[i] = str_view_from_str(parts[i]);
     }
 
-    assert(self->data != (void*) 0);
+    struct str* s = join(views, n, sep);
 
-    return self->used;
+    release(views, (n ? n : 1) * sizeof (str_view));
+
+    return s;
 }
 
-bool str_empty(struct str* self) {
-    if (!self) {
-        return false;
+struct str* str_join_cstrs(char const* const* parts, size_t n, str_view sep) {
+    if (!parts && n) {
+        return (void*) 0;
     }
 
-    assert(self->data != (void*) 0);
+    STATS_OP(STR_STATS_JOIN);
 
-    return self->used == 0;
-}
+    str_view* views = allocate((n ? n : 1) * sizeof (str_view));
 
-bool str_append_char(struct str* self, char c) {
-    if (!self) {
-        return false;
+    if (!views) {
+        return (void*) 0;
     }
 
-    assert(self->data != (void*) 0);
-
-    if (is_full(self)) {
-        if (!resize(self, 0)) {
-            return false;
-        }
+    for (size_t i = 0; i < n; ++i) {
+        views[i] = str_view_from_cstr(parts[i]);
     }
 
-    self->data[self->used] = c;
-    self->used++;
+    struct str* s = join(views, n, sep);
 
-    return true;
+    release(views, (n ? n : 1) * sizeof (str_view));
+
+    return s;
 }
 
-bool str_append_cstr(struct str* self, char const* s) {
-    if (!self || !s) {
+struct str* str_join_mutable_cstrs(char* const* parts, size_t n,
+        str_view sep) {
+    return str_join_cstrs((char const* const*) parts, n, sep);
+}
+
+bool str_clear(struct str* self) {
+    if (!self) {
         return false;
     }
 
-    for (char const* c = s; *c; ++c) {
-        if (!str_append_char(self, *c)) return false;
-    }
+    assert(self->data != (void*) 0);
 
-    return true;
+    STATS_OP(STR_STATS_CLEAR);
+
+    return str_remove(self, 0, self->used);
 }
 
-bool str_append_str(struct str* self, struct str* s) {
-    if (!self || !s) {
+bool str_truncate(str* self, size_t len) {
+    if (!self) {
         return false;
     }
 
     assert(self->data != (void*) 0);
-    assert(s->data != (void*) 0);
 
-    size_t new_used = self->used + s->used;
+    STATS_OP(STR_STATS_REMOVE);
 
-    /* overflow */
-    if (new_used < self->used) {
+    if (is_literal(self)) {
         return false;
     }
 
-    if (new_used > self->max) {
-        if (!resize(self, new_used)) {
-            return false;
-        }
-    }
-
-    for (size_t i = 0; i < s->used; ++i) {
-        self->data[self->used] = s->data[i];
-        self->used++;
+    if (len >= self->used) {
+        return true;
     }
 
-    return true;
-}
-
-bool str_clear(struct str* self) {
-    if (!self) {
-        return false;
-    }
+    STATS_ADD(STAT_USED, -(self->used - len));
 
-    assert(self->data != (void*) 0);
+    self->used = len;
+    self->data[len] = 0;
 
-    return str_remove(self, 0, self->used);
+    return true;
 }
 
 void str_reverse(str* self) {
@@ -237,7 +1022,9 @@ void str_reverse(str* self) {
 
     assert(self->data != (void*) 0);
 
-    if (self->used < 1) {
+    STATS_OP(STR_STATS_REVERSE);
+
+    if (self->used < 1 || is_literal(self)) {
         return;
     }
 
@@ -255,6 +1042,12 @@ bool str_remove(str* self, size_t start, size_t end) {
         return false;
     }
 
+    STATS_OP(STR_STATS_REMOVE);
+
+    if (is_literal(self)) {
+        return false;
+    }
+
     if (start > self->used) {
         /* there is nothing to remove */
         return true;
@@ -269,6 +1062,10 @@ bool str_remove(str* self, size_t start, size_t end) {
 
     assert(start + delta <= self->used);
 
+    size_t old_max = self->max;
+
+    STATS_ADD(STAT_USED, -delta);
+
     if (start + delta == self->used) {
         self->used -= delta;
 
@@ -276,7 +1073,7 @@ bool str_remove(str* self, size_t start, size_t end) {
         self->max = self->used + 1;
         self->data[start] = 0;
 
-        char* new_data = realloc(self->data, self->max);
+        char* new_data = reallocate(self->data, old_max, self->max);
 
         if (!new_data) {
             return false;
@@ -293,9 +1090,9 @@ bool str_remove(str* self, size_t start, size_t end) {
 
     /* + 1 for the \0 byte */
     self->max = self->used + 1;
-    self->data[self->max] = 0;
+    self->data[self->used] = 0;
 
-    char* new_data = realloc(self->data, self->max);
+    char* new_data = reallocate(self->data, old_max, self->max);
 
     if (!new_data) {
         return false;
@@ -306,39 +1103,139 @@ bool str_remove(str* self, size_t start, size_t end) {
     return true;
 }
 
+bool str_insert(str* self, size_t pos, str_view v) {
+    if (!self || (!v.data && v.len)) {
+        return false;
+    }
+
+    assert(self->data != (void*) 0);
+
+    STATS_OP(STR_STATS_INSERT);
+
+    if (pos > self->used || is_literal(self)) {
+        return false;
+    }
+
+    char const* old_data = self->data;
+    size_t old_max = self->max;
+
+    if (!reserve(self, v.len)) {
+        return false;
+    }
+
+    v = rebase(self, old_data, old_max, v);
+
+    uintptr_t begin = (uintptr_t) self->data;
+    uintptr_t p = (uintptr_t) v.data;
+    char* at = self->data + pos;
+
+    memmove(at + v.len, at, self->used - pos);
+
+    if (p >= begin && p < begin + self->used) {
+        /* v pointed into self, its part past pos moved along */
+        size_t start = p - begin;
+        size_t before = start >= pos ? 0
+            : pos - start < v.len ? pos - start : v.len;
+
+        memcpy(at, self->data + start, before);
+        memcpy(at + before, self->data + start + before + v.len,
+                v.len - before);
+    } else if (v.len) {
+        memcpy(at, v.data, v.len);
+    }
+
+    self->used += v.len;
+
+    STATS_ADD(STAT_USED, v.len);
+
+    return true;
+}
+
 struct str* str_slice(struct str* self, size_t start, size_t end) {
     if (!self) {
         return (void*) 0;
     }
 
-    if (start > self->used) {
-        return str_new();
-    }
+    assert(self->data != (void*) 0);
+
+    STATS_OP(STR_STATS_SLICE);
 
     if (!end || end > self->used) {
         end = self->used;
     }
 
-    struct str* s = str_new();
+    if (start > end) {
+        return create();
+    }
 
-    for (; start < end; start++) {
-        if (!str_append_char(s, self->data[start])) {
-            str_del(s);
-            return (void*) 0;
+    return from_view((str_view) { self->data + start, end - start });
+}
+
+struct str* str_clone(struct str* self) {
+    STATS_OP(STR_STATS_CLONE);
+
+    return from_view(str_view_from_str(self));
+}
+
+size_t str_view_find(str_view haystack, str_view needle, size_t from) {
+    if (from > haystack.len || needle.len > haystack.len - from) {
+        return STR_NPOS;
+    }
+
+    if (!needle.len) {
+        return from;
+    }
+
+    char const* cursor = haystack.data + from;
+
+    /* last position where the needle still fits */
+    char const* last = haystack.data + haystack.len - needle.len;
+
+    /* memchr skips to the candidates, it is vectorized by the libc */
+    while (cursor <= last) {
+        cursor = memchr(cursor, needle.data[0], (size_t) (last - cursor) + 1);
+
+        if (!cursor) {
+            return STR_NPOS;
+        }
+
+        if (memcmp(cursor + 1, needle.data + 1, needle.len - 1) == 0) {
+            return (size_t) (cursor - haystack.data);
         }
+
+        cursor++;
     }
 
-    return s;
+    return STR_NPOS;
 }
 
-struct str* str_clone(struct str* self) {
+size_t str_find(struct str* self, str_view needle, size_t from) {
     if (!self) {
-        return str_new();
+        return STR_NPOS;
     }
 
-    assert(self->data != (void*) 0);
+    STATS_OP(STR_STATS_FIND);
+
+    return str_view_find(str_view_from_str(self), needle, from);
+}
+
+size_t str_count(struct str* self, str_view needle) {
+    if (!self || !needle.len) {
+        return 0;
+    }
+
+    STATS_OP(STR_STATS_COUNT);
+
+    str_view haystack = str_view_from_str(self);
+    size_t count = 0;
 
-    return str_slice(self, 0, str_len(self));
+    for (size_t i = str_view_find(haystack, needle, 0);
+            i != STR_NPOS;
+            i = str_view_find(haystack, needle, i + needle.len)) {
+        count++;
+    }
+
+    return count;
 }
 
 int str_cmp(struct str* s1, struct str* s2) {
@@ -349,6 +1246,8 @@ int str_cmp(struct str* s1, struct str* s2) {
     assert(s1->data != (void*) 0);
     assert(s2->data != (void*) 0);
 
+    STATS_OP(STR_STATS_CMP);
+
     return strcmp(str_cstr(s1), str_cstr(s2));
 }
 
@@ -357,6 +1256,8 @@ bool str_equal(struct str* s1, struct str* s2) {
         return false;
     }
 
+    STATS_OP(STR_STATS_EQUAL);
+
     if (str_len(s1) != str_len(s2)) {
         return false;
     }
@@ -366,3 +1267,175 @@ bool str_equal(struct str* s1, struct str* s2) {
 
     return memcmp(s1->data, s2->data, str_len(s1)) == 0;
 }
+
+int str_compare(str_view a, str_view b) {
+    size_t n = a.len < b.len ? a.len : b.len;
+    size_t i = mismatch(a.data, b.data, n);
+
+    if (i < n) {
+        return (unsigned char) a.data[i] - (unsigned char) b.data[i];
+    }
+
+    return (a.len > b.len) - (a.len < b.len);
+}
+
+size_t str_mismatch(str_view a, str_view b) {
+    size_t n = a.len < b.len ? a.len : b.len;
+    size_t i = mismatch(a.data, b.data, n);
+
+    if (i == n && a.len == b.len) {
+        return STR_NPOS;
+    }
+
+    return i;
+}
+
+size_t str_common_prefix_len(str_view a, str_view b) {
+    return mismatch(a.data, b.data, a.len < b.len ? a.len : b.len);
+}
+
+bool str_starts_with(str_view v, str_view prefix) {
+    if (prefix.len > v.len) {
+        return false;
+    }
+
+    return !prefix.len || memcmp(v.data, prefix.data, prefix.len) == 0;
+}
+
+bool str_ends_with(str_view v, str_view suffix) {
+    if (suffix.len > v.len) {
+        return false;
+    }
+
+    return !suffix.len
+        || memcmp(v.data + v.len - suffix.len, suffix.data, suffix.len) == 0;
+}
+
+bool str_stats_snapshot(str_stats* out) {
+    if (!out) {
+        return false;
+    }
+
+    size_t counters[STAT_COUNT] = { 0 };
+
+#ifdef STR_STATS
+    pthread_mutex_lock(&stats_lock);
+
+    for (size_t i = 0; i < STAT_COUNT; ++i) {
+        counters[i] = stats_retired[i];
+    }
+
+    for (struct stats_block* b = stats_blocks; b; b = b->next) {
+        for (size_t i = 0; i < STAT_COUNT; ++i) {
+            counters[i] += atomic_load_explicit(&b->counters[i],
+                    memory_order_relaxed);
+        }
+    }
+
+    pthread_mutex_unlock(&stats_lock);
+#endif /* STR_STATS */
+
+    out->allocations = counters[STAT_ALLOCATIONS];
+    out->reallocations = counters[STAT_REALLOCATIONS];
+    out->frees = counters[STAT_FREES];
+    out->bytes_requested = counters[STAT_REQUESTED];
+    out->bytes_live = counters[STAT_LIVE];
+    out->bytes_used = counters[STAT_USED];
+    out->bytes_wasted = out->bytes_live - out->bytes_used;
+
+    for (size_t i = 0; i < STR_STATS_OPS; ++i) {
+        out->ops[i] = counters[STAT_OPS + i];
+    }
+
+    for (size_t i = 0; i < STR_STATS_BUCKETS; ++i) {
+        out->sizes[i] = counters[STAT_SIZES + i];
+    }
+
+#ifdef STR_STATS
+    return true;
+#else
+    return false;
+#endif /* STR_STATS */
+}
+
+char const* str_stats_op_name(str_stats_op op) {
+    static char const* const names[STR_STATS_OPS] = {
+        "new", "del", "from", "clone", "append", "reserve", "join",
+        "clear", "remove", "slice", "reverse", "find", "count", "cmp",
+        "equal", "insert",
+    };
+
+    if ((size_t) op >= STR_STATS_OPS) {
+        return "";
+    }
+
+    return names[op];
+}
+
+bool str_stats_dump_text(str_stats const* stats, struct str* out) {
+    if (!stats || !out) {
+        return false;
+    }
+
+    char const* format = "%-16s %zu\n";
+
+    bool ok = append_number(out, format, "allocations", stats->allocations)
+        && append_number(out, format, "reallocations", stats->reallocations)
+        && append_number(out, format, "frees", stats->frees)
+        && append_number(out, format, "bytes_requested",
+                stats->bytes_requested)
+        && append_number(out, format, "bytes_live", stats->bytes_live)
+        && append_number(out, format, "bytes_used", stats->bytes_used)
+        && append_number(out, format, "bytes_wasted", stats->bytes_wasted);
+
+    for (size_t i = 0; ok && i < STR_STATS_OPS; ++i) {
+        ok = append_number(out, "op %-13s %zu\n",
+                str_stats_op_name((str_stats_op) i), stats->ops[i]);
+    }
+
+    for (size_t i = 0; ok && i < STR_STATS_BUCKETS; ++i) {
+        if (!stats->sizes[i]) {
+            continue;
+        }
+
+        char bucket[32];
+        snprintf(bucket, sizeof bucket, "< 2^%zu", i);
+
+        ok = append_number(out, "size %-11s %zu\n", bucket, stats->sizes[i]);
+    }
+
+    return ok;
+}
+
+bool str_stats_dump_json(str_stats const* stats, struct str* out) {
+    if (!stats || !out) {
+        return false;
+    }
+
+    char const* format = "\"%s\":%zu,";
+
+    bool ok = append(out, str_view_from_cstr("{"))
+        && append_number(out, format, "allocations", stats->allocations)
+        && append_number(out, format, "reallocations", stats->reallocations)
+        && append_number(out, format, "frees", stats->frees)
+        && append_number(out, format, "bytes_requested",
+                stats->bytes_requested)
+        && append_number(out, format, "bytes_live", stats->bytes_live)
+        && append_number(out, format, "bytes_used", stats->bytes_used)
+        && append_number(out, format, "bytes_wasted", stats->bytes_wasted)
+        && append(out, str_view_from_cstr("\"ops\":{"));
+
+    for (size_t i = 0; ok && i < STR_STATS_OPS; ++i) {
+        ok = append_number(out, i + 1 < STR_STATS_OPS ? format : "\"%s\":%zu",
+                str_stats_op_name((str_stats_op) i), stats->ops[i]);
+    }
+
+    ok = ok && append(out, str_view_from_cstr("},\"sizes\":["));
+
+    for (size_t i = 0; ok && i < STR_STATS_BUCKETS; ++i) {
+        ok = append_number(out, i + 1 < STR_STATS_BUCKETS ? "%s%zu," : "%s%zu",
+                "", stats->sizes[i]);
+    }
+
+    return ok && append(out, str_view_from_cstr("]}"));
+}
@@ -13,6 +13,52 @@ extern "C" {
 /** Opaque str Structure */
 typedef struct str str;
 
+/** Storage of a str literal, it mirrors the layout of str.
+ * @warning    Don't use it directly, use STR_LIT instead.
+ *
+ * @see STR_LIT */
+struct str_literal {
+    /** Pointer to the string literal. */
+    char* data;
+    /** Length of the string literal. */
+    size_t used;
+    /** Always 0, which marks the str as a literal. */
+    size_t max;
+};
+
+/** Creates immutable str from string literal.
+ * @warning    S must be a string literal, its length is computed
+ *             at compile time with sizeof.
+ *
+ * @note       Nothing is allocated nor copied. At file scope the
+ *             str has static storage duration, at block scope it
+ *             lives until the end of the enclosing block.
+ *
+ * @note       It can be passed to every function that only reads a
+ *             str, functions modifying it fail and str_del ignores it.
+ *
+ * @param S    A string literal.
+ *
+ * @return     A pointer to a str object. */
+#define STR_LIT(S) \
+    ((str*) &(struct str_literal) { "" S, sizeof (S) - 1, 0 })
+
+/** Read-only view over a sequence of characters.
+ * @warning    A view doesn't own its data. It is only valid
+ *             while the underlying storage is alive and
+ *             unmodified, e.g. appending to a str may move
+ *             its buffer and invalidate views taken from it.
+ *
+ * @note       The data is not guaranteed to be null terminated.
+ *
+ * @see str_view_of */
+typedef struct str_view {
+    /** Pointer to the first character. */
+    char const* data;
+    /** Number of characters. */
+    size_t len;
+} str_view;
+
 /** Creates empty str.
  * @warning The user has to free the object after usage with
  *          str_del.
@@ -67,6 +113,17 @@ str* str_from_cstr(char const* s);
  * @see str_from str_from_char str_from_cstr str_clone str_del */
 str* str_from_str(str* s);
 
+/** Creates str from view.
+ * @warning The user has to free the object after usage with
+ *          str_del.
+ *
+ * @param v A view.
+ *
+ * @return  A pointer to a str object containing the characters of v.
+ *
+ * @see str_from str_from_cstr str_from_str str_del */
+str* str_from_view(str_view v);
+
 /** Generic for str_from_*.
  * @note       If T is a character literal, e.g. 'a',
  *             it will suffer from integral promotion in C,
@@ -80,13 +137,14 @@ str* str_from_str(str* s);
  *
  * @return     Newly created str object.
  *
- * @see str_from_char str_from_cstr str_from_str str_del */
+ * @see str_from_char str_from_cstr str_from_str str_from_view str_del */
 #define str_from(T) _Generic((T),   \
         int:         str_from_char, \
         char:        str_from_char, \
         char*:       str_from_cstr, \
         char const*: str_from_cstr, \
-        str*:        str_from_str   \
+        str*:        str_from_str,  \
+        str_view:    str_from_view  \
         )(T)
 
 /** Clones the str object.
@@ -103,6 +161,56 @@ str* str_from_str(str* s);
  * @see str_del */
 str* str_clone(str* self);
 
+/** Creates view over the contents of a str object.
+ * @note       Unlike str_cstr, this doesn't write the null
+ *             terminator into the str object.
+ *
+ * @note       If the str s is null, it returns an empty view.
+ *
+ * @param s    A pointer to a str object.
+ *
+ * @return     A view over the characters of s.
+ *
+ * @see str_view_of str_cstr */
+str_view str_view_from_str(str* s);
+
+/** Creates view over a null terminated C string.
+ * @warning    The C string needs to be null terminated!
+ *
+ * @note       If the C string s is null, it returns an empty view.
+ *
+ * @param s    A pointer to a C string.
+ *
+ * @return     A view over the characters of s.
+ *
+ * @see str_view_of */
+str_view str_view_from_cstr(char const* s);
+
+/** Returns the view itself.
+ * @note       It only exists so str_view_of can accept views.
+ *
+ * @param v    A view.
+ *
+ * @return     The same view.
+ *
+ * @see str_view_of */
+str_view str_view_from_view(str_view v);
+
+/** Generic for str_view_from_*.
+ * @note       If T is a null pointer, it returns an empty view.
+ *
+ * @param T    Generic Object.
+ *
+ * @return     A view over T.
+ *
+ * @see str_view_from_str str_view_from_cstr str_view_from_view */
+#define str_view_of(T) _Generic((T),      \
+        char*:       str_view_from_cstr,  \
+        char const*: str_view_from_cstr,  \
+        str*:        str_view_from_str,   \
+        str_view:    str_view_from_view   \
+        )(T)
+
 /** Returns null terminated C string.
  *
  * @param self A pointer to a str object.
@@ -135,6 +243,19 @@ bool str_empty(str* self);
  * @see str_remove */
 bool str_clear(str* self);
 
+/** Shortens str to a length.
+ * @note       Unlike str_clear and str_remove, it keeps the capacity,
+ *             so a str refilled again and again allocates only while
+ *             it grows.
+ *
+ * @param self A pointer to a str object.
+ * @param len  New length, a longer one leaves str as it is.
+ *
+ * @return     true if successful.
+ *
+ * @see str_clear */
+bool str_truncate(str* self, size_t len);
+
 /** Reverses str.
  * @param self A pointer to a str object. */
 void str_reverse(str* self);
@@ -174,6 +295,17 @@ bool str_append_cstr(str* self, char const* s);
  * @see str_append str_append_char str_append_cstr */
 bool str_append_str(str* self, str* s);
 
+/** Appends a view to str.
+ * @note       The view may point into self.
+ *
+ * @param self A pointer to a str object.
+ * @param v    A view.
+ *
+ * @return     true if successful.
+ *
+ * @see str_append str_append_str str_append_many */
+bool str_append_view(str* self, str_view v);
+
 /** Generic for str_append_*.
  * @note       If T is a character literal, e.g. 'a',
  *             it will suffer from integral promotion in C,
@@ -187,15 +319,263 @@ bool str_append_str(str* self, str* s);
  *
  * @return     true if successful.
  *
- * @see str_append_char str_append_cstr str_append_str */
+ * @see str_append_char str_append_cstr str_append_str str_append_view */
 #define str_append(self, T) _Generic((T), \
         int:         str_append_char,     \
         char:        str_append_char,     \
         char*:       str_append_cstr,     \
         char const*: str_append_cstr,     \
-        str*:        str_append_str       \
+        str*:        str_append_str,      \
+        str_view:    str_append_view      \
         )(self, T)
 
+/** Appends an array of views to str with a single allocation.
+ * @note       The views may point into self.
+ *
+ * @param self  A pointer to a str object.
+ * @param views A pointer to an array of n views.
+ * @param n     Number of views.
+ *
+ * @return      true if successful.
+ *
+ * @see str_append_many str_join_views */
+bool str_append_views(str* self, str_view const* views, size_t n);
+
+/* str_append_many helpers, counting and wrapping up to 16 pieces */
+#define STR_ARGC_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, \
+        _13, _14, _15, _16, n, ...) n
+#define STR_ARGC(...) STR_ARGC_(__VA_ARGS__, \
+        16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define STR_CAT_(a, b) a##b
+#define STR_CAT(a, b) STR_CAT_(a, b)
+#define STR_VIEWS_1(x) str_view_of(x)
+#define STR_VIEWS_2(x, ...) str_view_of(x), STR_VIEWS_1(__VA_ARGS__)
+#define STR_VIEWS_3(x, ...) str_view_of(x), STR_VIEWS_2(__VA_ARGS__)
+#define STR_VIEWS_4(x, ...) str_view_of(x), STR_VIEWS_3(__VA_ARGS__)
+#define STR_VIEWS_5(x, ...) str_view_of(x), STR_VIEWS_4(__VA_ARGS__)
+#define STR_VIEWS_6(x, ...) str_view_of(x), STR_VIEWS_5(__VA_ARGS__)
+#define STR_VIEWS_7(x, ...) str_view_of(x), STR_VIEWS_6(__VA_ARGS__)
+#define STR_VIEWS_8(x, ...) str_view_of(x), STR_VIEWS_7(__VA_ARGS__)
+#define STR_VIEWS_9(x, ...) str_view_of(x), STR_VIEWS_8(__VA_ARGS__)
+#define STR_VIEWS_10(x, ...) str_view_of(x), STR_VIEWS_9(__VA_ARGS__)
+#define STR_VIEWS_11(x, ...) str_view_of(x), STR_VIEWS_10(__VA_ARGS__)
+#define STR_VIEWS_12(x, ...) str_view_of(x), STR_VIEWS_11(__VA_ARGS__)
+#define STR_VIEWS_13(x, ...) str_view_of(x), STR_VIEWS_12(__VA_ARGS__)
+#define STR_VIEWS_14(x, ...) str_view_of(x), STR_VIEWS_13(__VA_ARGS__)
+#define STR_VIEWS_15(x, ...) str_view_of(x), STR_VIEWS_14(__VA_ARGS__)
+#define STR_VIEWS_16(x, ...) str_view_of(x), STR_VIEWS_15(__VA_ARGS__)
+
+/** Appends many pieces to str with a single allocation.
+ * @note       Pieces may be str objects, C strings or views, mixed
+ *             freely, each passed through str_view_of, so other types
+ *             don't compile.
+ *
+ * @note       The pieces may point into self.
+ *
+ * @param self A pointer to a str object.
+ * @param ...  1 to 16 str objects, C strings or views.
+ *
+ * @return     true if successful.
+ *
+ * @see str_append_views str_append str_view_of str_join */
+#define str_append_many(self, ...) str_append_views((self),     \
+        (str_view const[]) {                                    \
+            STR_CAT(STR_VIEWS_, STR_ARGC(__VA_ARGS__))(__VA_ARGS__) \
+        }, STR_ARGC(__VA_ARGS__))
+
+/** Reserves room for more characters.
+ * @note       After reserving, appending up to n characters
+ *             doesn't allocate.
+ *
+ * @param self A pointer to a str object.
+ * @param n    Number of characters to reserve beyond the length.
+ *
+ * @return     true if successful.
+ *
+ * @see str_append_many */
+bool str_reserve(str* self, size_t n);
+
+/** Appends copies of a character to str.
+ * @param self A pointer to a str object.
+ * @param c    A character.
+ * @param n    Number of copies.
+ *
+ * @return     true if successful.
+ *
+ * @see str_pad_right str_repeat */
+bool str_fill(str* self, char c, size_t n);
+
+/** Pads str on the left up to a width.
+ * @note       A str as wide or wider is left as it is.
+ *
+ * @param self  A pointer to a str object.
+ * @param width Length to pad to.
+ * @param c     Character to pad with.
+ *
+ * @return      true if successful.
+ *
+ * @see str_pad_right str_center */
+bool str_pad_left(str* self, size_t width, char c);
+
+/** Pads str on the right up to a width.
+ * @note       A str as wide or wider is left as it is.
+ *
+ * @param self  A pointer to a str object.
+ * @param width Length to pad to.
+ * @param c     Character to pad with.
+ *
+ * @return      true if successful.
+ *
+ * @see str_pad_left str_center */
+bool str_pad_right(str* self, size_t width, char c);
+
+/** Pads str on both sides up to a width.
+ * @note       When the padding is odd, the right side gets the extra
+ *             character. A str as wide or wider is left as it is.
+ *
+ * @param self  A pointer to a str object.
+ * @param width Length to pad to.
+ * @param c     Character to pad with.
+ *
+ * @return      true if successful.
+ *
+ * @see str_pad_left str_pad_right */
+bool str_center(str* self, size_t width, char c);
+
+/** Creates new str repeating a view.
+ * @warning    The user has to free the object after usage with
+ *             str_del.
+ *
+ * @param v    A view.
+ * @param n    Number of repetitions.
+ *
+ * @return     A pointer to a str object.
+ *
+ * @see str_fill str_del */
+str* str_repeat(str_view v, size_t n);
+
+/** Joins views with a separator.
+ * @warning    The user has to free the object after usage with
+ *             str_del.
+ *
+ * @param parts A pointer to an array of views.
+ * @param n     Number of views.
+ * @param sep   Separator placed between the views.
+ *
+ * @return      A pointer to a new str containing the joined views.
+ *
+ * @see str_join str_del */
+str* str_join_views(str_view const* parts, size_t n, str_view sep);
+
+/** Joins str objects with a separator.
+ * @warning    The user has to free the object after usage with
+ *             str_del.
+ *
+ * @note       Null str objects are joined as empty strings.
+ *
+ * @param parts A pointer to an array of str objects.
+ * @param n     Number of str objects.
+ * @param sep   Separator placed between the str objects.
+ *
+ * @return      A pointer to a new str containing the joined strings.
+ *
+ * @see str_join str_del */
+str* str_join_strs(str* const* parts, size_t n, str_view sep);
+
+/** Joins null terminated C strings with a separator.
+ * @warning    The user has to free the object after usage with
+ *             str_del.
+ *
+ * @note       Null C strings are joined as empty strings.
+ *
+ * @param parts A pointer to an array of C strings.
+ * @param n     Number of C strings.
+ * @param sep   Separator placed between the C strings.
+ *
+ * @return      A pointer to a new str containing the joined strings.
+ *
+ * @see str_join str_del */
+str* str_join_cstrs(char const* const* parts, size_t n, str_view sep);
+
+/** Joins null terminated C strings held as char* with a separator.
+ * @note       Same as str_join_cstrs, which C doesn't let an array
+ *             of char* convert to implicitly.
+ *
+ * @param parts A pointer to an array of C strings.
+ * @param n     Number of C strings.
+ * @param sep   Separator placed between the C strings.
+ *
+ * @return      A pointer to a new str containing the joined strings.
+ *
+ * @see str_join_cstrs str_join str_del */
+str* str_join_mutable_cstrs(char* const* parts, size_t n, str_view sep);
+
+/** Generic for str_join_*.
+ * @note       The total length is computed first, so the
+ *             resulting str is allocated only once.
+ *
+ * @param parts An array of str objects, C strings or views.
+ * @param n     Number of elements in parts.
+ * @param sep   A str object, C string or view.
+ *
+ * @return      A pointer to a new str containing the joined strings.
+ *
+ * @see str_join_views str_join_strs str_join_cstrs str_join_mutable_cstrs
+ *      str_del */
+#define str_join(parts, n, sep) _Generic((parts),   \
+        str**:              str_join_strs,          \
+        str* const*:        str_join_strs,          \
+        char**:             str_join_mutable_cstrs, \
+        char* const*:       str_join_mutable_cstrs, \
+        char const**:       str_join_cstrs,         \
+        char const* const*: str_join_cstrs,         \
+        str_view*:          str_join_views,         \
+        str_view const*:    str_join_views          \
+        )(parts, n, str_view_of(sep))
+
+/** Position returned by the search functions when nothing is found. */
+#define STR_NPOS ((size_t) -1)
+
+/** Finds the first occurrence of a needle in a view.
+ * @note       An empty needle is found at from, as long as
+ *             from is not past the end of the haystack.
+ *
+ * @param haystack A view to search in.
+ * @param needle   A view to search for.
+ * @param from     Index where the search starts.
+ *
+ * @return     Index of the occurrence or STR_NPOS.
+ *
+ * @see str_find */
+size_t str_view_find(str_view haystack, str_view needle, size_t from);
+
+/** Finds the first occurrence of a needle in str.
+ * @note       An empty needle is found at from, as long as
+ *             from is not past the end of the string.
+ *
+ * @param self   A pointer to a str object.
+ * @param needle A view to search for.
+ * @param from   Index where the search starts.
+ *
+ * @return       Index of the occurrence or STR_NPOS.
+ *
+ * @see str_view_find str_count */
+size_t str_find(str* self, str_view needle, size_t from);
+
+/** Counts non-overlapping occurrences of a needle in str.
+ * @note       Occurrences are matched greedily from the left, so
+ *             "aaaa" contains two occurrences of "aa".
+ *
+ * @note       An empty needle has no occurrences.
+ *
+ * @param self   A pointer to a str object.
+ * @param needle A view to search for.
+ *
+ * @return       Number of occurrences.
+ *
+ * @see str_find */
+size_t str_count(str* self, str_view needle);
+
 /** Compares two strings loosely.
  * @warning    Comparisons in this function are done in
  *             the same way as strcmp, meaning that if str A contains
@@ -208,7 +588,7 @@ bool str_append_str(str* self, str* s);
  *
  * @return     The same as strcmp would return.
  *
- * @see str_equal */
+ * @see str_equal str_compare */
 int str_cmp(str* self, str* s);
 
 /** Compares two strings strictly.
@@ -218,9 +598,65 @@ int str_cmp(str* self, str* s);
  *
  * @return     true if they are strictly equal or false otherwise.
  *
- * @see str_cmp */
+ * @see str_cmp str_compare */
 bool str_equal(str* self, str* s);
 
+/** Compares two views.
+ * @note       Unlike str_cmp, bytes are compared as unsigned chars
+ *             up to the shorter length, \0 included, and a view
+ *             sorts before those it is a prefix of.
+ *
+ * @param a    A view.
+ * @param b    A view.
+ *
+ * @return     Less than, equal to or greater than zero if a sorts
+ *             before, with or after b.
+ *
+ * @see str_mismatch str_cmp */
+int str_compare(str_view a, str_view b);
+
+/** Finds the first position two views differ at.
+ * @note       Bytes are compared 32 at a time.
+ *
+ * @param a    A view.
+ * @param b    A view.
+ *
+ * @return     Index of the first differing byte, the shorter length
+ *             if one is a prefix of the other, or STR_NPOS if they
+ *             are equal.
+ *
+ * @see str_common_prefix_len str_compare */
+size_t str_mismatch(str_view a, str_view b);
+
+/** Returns length of the common prefix of two views.
+ * @param a    A view.
+ * @param b    A view.
+ *
+ * @return     Number of leading bytes a and b share.
+ *
+ * @see str_mismatch */
+size_t str_common_prefix_len(str_view a, str_view b);
+
+/** Checks whether view starts with a prefix.
+ * @param v      A view.
+ * @param prefix A view.
+ *
+ * @return       true if v starts with prefix, always so if prefix
+ *               is empty.
+ *
+ * @see str_ends_with */
+bool str_starts_with(str_view v, str_view prefix);
+
+/** Checks whether view ends with a suffix.
+ * @param v      A view.
+ * @param suffix A view.
+ *
+ * @return       true if v ends with suffix, always so if suffix is
+ *               empty.
+ *
+ * @see str_starts_with */
+bool str_ends_with(str_view v, str_view suffix);
+
 /** Removes characters within range from str.
  * @note        The range is closed on start and open on end,
  *              which means it includes the character pointed
@@ -236,6 +672,18 @@ bool str_equal(str* self, str* s);
  * @see str_clear */
 bool str_remove(str* self, size_t start, size_t end);
 
+/** Inserts view into str.
+ * @note       The view may point into self.
+ *
+ * @param self A pointer to a str object.
+ * @param pos  Index to insert at, str's length appends.
+ * @param v    A view.
+ *
+ * @return     true if successful, false if pos is past the end.
+ *
+ * @see str_remove str_append_view */
+bool str_insert(str* self, size_t pos, str_view v);
+
 /** Creates new str from str slice.
  * @warning     The user has to free the object after usage with
  *              str_del.
@@ -254,6 +702,102 @@ bool str_remove(str* self, size_t start, size_t end);
  * @see str_remove str_del */
 str* str_slice(str* self, size_t start, size_t end);
 
+/** Operations counted by str_stats.
+ * @note       Every public function falls under one operation,
+ *             e.g. all the str_append_* functions are counted
+ *             as STR_STATS_APPEND. */
+typedef enum str_stats_op {
+    STR_STATS_NEW,
+    STR_STATS_DEL,
+    STR_STATS_FROM,
+    STR_STATS_CLONE,
+    STR_STATS_APPEND,
+    STR_STATS_RESERVE,
+    STR_STATS_JOIN,
+    STR_STATS_CLEAR,
+    STR_STATS_REMOVE,
+    STR_STATS_SLICE,
+    STR_STATS_REVERSE,
+    STR_STATS_FIND,
+    STR_STATS_COUNT,
+    STR_STATS_CMP,
+    STR_STATS_EQUAL,
+    STR_STATS_INSERT,
+    /** Number of operations. */
+    STR_STATS_OPS
+} str_stats_op;
+
+/** Number of buckets of the size histogram. */
+#define STR_STATS_BUCKETS 65
+
+/** Allocation and operation statistics.
+ * @note       The statistics are only recorded if the library is
+ *             built with STR_STATS defined, e.g.
+ *             make CPPFLAGS=-DSTR_STATS.
+ *
+ * @see str_stats_snapshot */
+typedef struct str_stats {
+    /** Number of malloc calls. */
+    size_t allocations;
+    /** Number of realloc calls. */
+    size_t reallocations;
+    /** Number of free calls. */
+    size_t frees;
+    /** Bytes requested by malloc and realloc calls. */
+    size_t bytes_requested;
+    /** Bytes currently allocated, headers included. */
+    size_t bytes_live;
+    /** Characters currently stored. */
+    size_t bytes_used;
+    /** Bytes currently allocated but not storing characters,
+     *  that is bytes_live - bytes_used. */
+    size_t bytes_wasted;
+    /** Number of calls of every operation. */
+    size_t ops[STR_STATS_OPS];
+    /** Lengths of deleted str objects, bucket 0 counts empty strings
+     *  and bucket i counts lengths in [2^(i - 1), 2^i). */
+    size_t sizes[STR_STATS_BUCKETS];
+} str_stats;
+
+/** Takes snapshot of the statistics.
+ * @note       Counters are kept per thread, and merged with the
+ *             ones of every thread, including exited ones, on read.
+ *
+ * @param out  A pointer to where the statistics are stored.
+ *
+ * @return     true if successful, false if the library was
+ *             built without STR_STATS.
+ *
+ * @see str_stats_dump_text str_stats_dump_json */
+bool str_stats_snapshot(str_stats* out);
+
+/** Returns name of an operation.
+ *
+ * @param op   An operation.
+ *
+ * @return     A null terminated C string, e.g. "append". */
+char const* str_stats_op_name(str_stats_op op);
+
+/** Appends human readable statistics to str.
+ *
+ * @param stats A pointer to the statistics.
+ * @param out   A pointer to a str object.
+ *
+ * @return      true if successful.
+ *
+ * @see str_stats_snapshot str_stats_dump_json */
+bool str_stats_dump_text(str_stats const* stats, str* out);
+
+/** Appends statistics as a JSON object to str.
+ *
+ * @param stats A pointer to the statistics.
+ * @param out   A pointer to a str object.
+ *
+ * @return      true if successful.
+ *
+ * @see str_stats_snapshot str_stats_dump_text */
+bool str_stats_dump_json(str_stats const* stats, str* out);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
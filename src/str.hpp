@@ -0,0 +1,205 @@
+/** str's C++ Wrapper
+ * @file str.hpp
+ *
+ * strlib::str owns a str object and frees it when it goes out of
+ * scope. It moves instead of copying, copies being explicit with
+ * clone, and converts to std::string_view without touching the
+ * string. Everything is inline over the C functions, so it costs
+ * nothing over calling them by hand. Allocation failures throw
+ * std::bad_alloc. */
+#ifndef STR_HPP
+#define STR_HPP
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <string_view>
+#include <utility>
+
+#include "str.h"
+
+namespace strlib {
+
+/** Owning handle of a str object. */
+class str {
+public:
+    /** Creates empty str. */
+    str() : str(str_new()) {}
+
+    /** Creates str holding a copy of view. */
+    explicit str(std::string_view v) : str(str_from_view(view(v))) {}
+
+    /** Takes ownership of a str object, a null one included. */
+    static str adopt(::str* s) noexcept {
+        str self(nullptr);
+
+        self.s = s;
+
+        return self;
+    }
+
+    str(str const&) = delete;
+    str& operator=(str const&) = delete;
+
+    str(str&& other) noexcept : s(std::exchange(other.s, nullptr)) {}
+
+    /** The moved from str is left empty. */
+    str& operator=(str&& other) noexcept {
+        if (this != &other) {
+            reset();
+            s = std::exchange(other.s, nullptr);
+        }
+
+        return *this;
+    }
+
+    ~str() {
+        reset();
+    }
+
+    /** Returns a copy, copies are never implicit. */
+    str clone() const {
+        return s ? str(str_clone(s)) : str();
+    }
+
+    /** Returns the str object, still owned by this. */
+    ::str* get() const noexcept {
+        return s;
+    }
+
+    /** Gives up ownership of the str object, the caller frees it with
+     *  str_del. */
+    ::str* release() noexcept {
+        return std::exchange(s, nullptr);
+    }
+
+    std::size_t size() const noexcept {
+        return str_len(s);
+    }
+
+    bool empty() const noexcept {
+        return !str_len(s);
+    }
+
+    /** Returns a view of the characters, it doesn't null terminate. */
+    operator std::string_view() const noexcept {
+        str_view v = str_view_from_str(s);
+
+        return std::string_view(v.data, v.len);
+    }
+
+    /** Returns the characters null terminated. Writing the null makes
+     *  it a mutation, so it isn't const: use the string_view conversion
+     *  on strs shared between threads. */
+    char const* c_str() noexcept {
+        return str_cstr(s);
+    }
+
+    str& append(std::string_view v) {
+        check(str_append_view(own(), view(v)));
+        return *this;
+    }
+
+    str& operator+=(std::string_view v) {
+        return append(v);
+    }
+
+    str& operator+=(char c) {
+        check(str_append_char(own(), c));
+        return *this;
+    }
+
+    /** Reserves room for n more characters. */
+    void reserve(std::size_t n) {
+        check(str_reserve(own(), n));
+    }
+
+    /** Removes all characters, keeping the capacity. */
+    void clear() noexcept {
+        str_truncate(s, 0);
+    }
+
+    friend bool operator==(str const& a, str const& b) noexcept {
+        return std::string_view(a) == std::string_view(b);
+    }
+
+    friend bool operator!=(str const& a, str const& b) noexcept {
+        return !(a == b);
+    }
+
+    friend bool operator<(str const& a, str const& b) noexcept {
+        return std::string_view(a) < std::string_view(b);
+    }
+
+    friend bool operator==(str const& a, std::string_view b) noexcept {
+        return std::string_view(a) == b;
+    }
+
+    friend bool operator==(std::string_view a, str const& b) noexcept {
+        return a == std::string_view(b);
+    }
+
+    friend bool operator!=(str const& a, std::string_view b) noexcept {
+        return !(a == b);
+    }
+
+    friend bool operator!=(std::string_view a, str const& b) noexcept {
+        return !(a == b);
+    }
+
+private:
+    ::str* s;
+
+    /* takes a newly created str object, throwing if creating failed */
+    explicit str(::str* created) : s(created) {
+        if (!s) {
+            throw std::bad_alloc();
+        }
+    }
+
+    explicit str(std::nullptr_t) noexcept : s(nullptr) {}
+
+    /* moved from objects are common, their null is checked inline */
+    void reset() noexcept {
+        if (s) {
+            str_del(s);
+        }
+    }
+
+    static str_view view(std::string_view v) noexcept {
+        return str_view { v.data(), v.size() };
+    }
+
+    static void check(bool ok) {
+        if (!ok) {
+            throw std::bad_alloc();
+        }
+    }
+
+    /* a moved from str gets a new str object before it's changed */
+    ::str* own() {
+        if (!s) {
+            s = str_new();
+            check(s);
+        }
+
+        return s;
+    }
+};
+
+} /* namespace strlib */
+
+namespace std {
+
+/** Hashes as std::string_view, so equal contents hash equal whatever
+ *  holds them. */
+template <>
+struct hash<strlib::str> {
+    std::size_t operator()(strlib::str const& s) const noexcept {
+        return std::hash<std::string_view>()(s);
+    }
+};
+
+} /* namespace std */
+
+#endif /* STR_HPP */
@@ -0,0 +1,300 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "str_archive.h"
+#include "str_private.h"
+#include "str_sink.h"
+
+/* pieces at least this long are written straight from the caller */
+static const size_t STR_ARCHIVE_BUFFER = 1 << 16;
+
+static const char STR_ARCHIVE_MAGIC[8] = "\x89STRARC\n";
+static const uint32_t STR_ARCHIVE_BYTE_ORDER = 0x01020304;
+
+#define ALIGN 8
+
+struct header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+};
+
+struct footer {
+    uint64_t count;
+    uint64_t index;
+    uint64_t checksum;
+    char magic[8];
+};
+
+_Static_assert(sizeof (struct header) == 16, "header is not packed");
+_Static_assert(sizeof (struct footer) == 32, "footer is not packed");
+
+struct str_archive_writer {
+    str_sink* sink;
+    uint64_t offset;
+    uint64_t checksum;
+    bool failed;
+
+    /* offsets of the characters of every entry */
+    uint64_t* index;
+    size_t n;
+    size_t cap;
+};
+
+struct str_archive {
+    char const* data;
+    size_t size;
+    size_t count;
+    /* end of the entries */
+    size_t entries;
+    uint64_t const* index;
+    uint64_t checksum;
+};
+
+/* -- Private Interface -- */
+
+static void emit(struct str_archive_writer* self, void const* data,
+        size_t len) {
+    assert(self != (void*) 0);
+
+    self->checksum = str_fnv1a(self->checksum, data, len);
+    self->offset += len;
+
+    if (self->failed || !len) {
+        return;
+    }
+
+    self->failed = !str_sink_write_view(self->sink,
+            (str_view) { data, len });
+
+    /* the sink only references long pieces, which
+     * have to be written before the caller moves on */
+    if (!self->failed && len >= STR_ARCHIVE_BUFFER) {
+        self->failed = !str_sink_flush(self->sink);
+    }
+}
+
+static void emit_u64(struct str_archive_writer* self, uint64_t value) {
+    emit(self, &value, sizeof value);
+}
+
+static void pad(struct str_archive_writer* self) {
+    static const char zeros[ALIGN] = { 0 };
+
+    emit(self, zeros, (ALIGN - self->offset % ALIGN) % ALIGN);
+}
+
+static uint64_t read_u64(char const* p) {
+    uint64_t value;
+
+    memcpy(&value, p, sizeof value);
+
+    return value;
+}
+
+static bool valid(struct str_archive* self) {
+    assert(self != (void*) 0);
+
+    struct header header;
+    struct footer footer;
+
+    if (self->size < sizeof header + sizeof footer) {
+        return false;
+    }
+
+    memcpy(&header, self->data, sizeof header);
+    memcpy(&footer, self->data + self->size - sizeof footer, sizeof footer);
+
+    if (memcmp(header.magic, STR_ARCHIVE_MAGIC, sizeof header.magic)
+            || memcmp(footer.magic, STR_ARCHIVE_MAGIC, sizeof footer.magic)
+            || header.version != STR_ARCHIVE_VERSION
+            || header.byte_order != STR_ARCHIVE_BYTE_ORDER) {
+        return false;
+    }
+
+    size_t end = self->size - sizeof footer;
+
+    /* the index has to fill the space up to the footer */
+    if (footer.index < sizeof header || footer.index % ALIGN
+            || footer.index > end
+            || footer.count != (end - footer.index) / sizeof (uint64_t)
+            || (end - footer.index) % sizeof (uint64_t)) {
+        return false;
+    }
+
+    self->count = footer.count;
+    self->entries = footer.index;
+    self->index = (uint64_t const*) (void const*) (self->data + footer.index);
+    self->checksum = footer.checksum;
+
+    return true;
+}
+
+/* -- Public Interface Implementation -- */
+
+str_archive_writer* str_archive_writer_new(int fd) {
+    str_archive_writer* self = malloc(sizeof (str_archive_writer));
+
+    if (!self) {
+        return (void*) 0;
+    }
+
+    str_sink_config config = {
+        STR_ARCHIVE_BUFFER, 0, STR_ARCHIVE_BUFFER, STR_ARCHIVE_BUFFER,
+    };
+
+    *self = (str_archive_writer) { 0 };
+    self->sink = str_sink_new(fd, &config);
+    self->checksum = STR_FNV1A_BASIS;
+
+    if (!self->sink) {
+        free(self);
+        return (void*) 0;
+    }
+
+    struct header header = { { 0 }, STR_ARCHIVE_VERSION,
+        STR_ARCHIVE_BYTE_ORDER };
+
+    memcpy(header.magic, STR_ARCHIVE_MAGIC, sizeof header.magic);
+    emit(self, &header, sizeof header);
+
+    return self;
+}
+
+bool str_archive_writer_write(str_archive_writer* self, str_view v) {
+    if (!self || (!v.data && v.len)) {
+        return false;
+    }
+
+    if (self->n == self->cap) {
+        size_t cap = self->cap ? self->cap * 2 : 64;
+
+        /* overflow */
+        if (cap > SIZE_MAX / sizeof (uint64_t)) {
+            return false;
+        }
+
+        uint64_t* index = realloc(self->index, cap * sizeof (uint64_t));
+
+        if (!index) {
+            return false;
+        }
+
+        self->index = index;
+        self->cap = cap;
+    }
+
+    emit_u64(self, v.len);
+    self->index[self->n++] = self->offset;
+    emit(self, v.data, v.len);
+    emit(self, "", 1);
+    pad(self);
+
+    return !self->failed;
+}
+
+bool str_archive_writer_close(str_archive_writer* self) {
+    if (!self) {
+        return false;
+    }
+
+    struct footer footer = { self->n, self->offset, 0, { 0 } };
+
+    emit(self, self->index, self->n * sizeof (uint64_t));
+
+    footer.checksum = self->checksum;
+    memcpy(footer.magic, STR_ARCHIVE_MAGIC, sizeof footer.magic);
+    emit(self, &footer, sizeof footer);
+
+    bool written = str_sink_close(self->sink) && !self->failed;
+
+    free(self->index);
+    free(self);
+
+    return written;
+}
+
+str_archive* str_archive_map(int fd) {
+    struct stat st;
+
+    if (fstat(fd, &st) || st.st_size <= 0) {
+        return (void*) 0;
+    }
+
+    str_archive* self = malloc(sizeof (str_archive));
+
+    if (!self) {
+        return (void*) 0;
+    }
+
+    self->size = (size_t) st.st_size;
+
+    void* data = mmap((void*) 0, self->size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (data == MAP_FAILED) {
+        free(self);
+        return (void*) 0;
+    }
+
+    self->data = data;
+
+    if (!valid(self)) {
+        str_archive_unmap(self);
+        return (void*) 0;
+    }
+
+    return self;
+}
+
+void str_archive_unmap(str_archive* self) {
+    if (!self) {
+        return;
+    }
+
+    munmap((void*) self->data, self->size);
+    free(self);
+}
+
+size_t str_archive_len(str_archive* self) {
+    return self ? self->count : 0;
+}
+
+str_view str_archive_at(str_archive* self, size_t i) {
+    if (!self || i >= self->count) {
+        return (str_view) { "", 0 };
+    }
+
+    uint64_t offset = self->index[i];
+
+    /* the length comes right before the characters */
+    if (offset < sizeof (struct header) + sizeof (uint64_t)
+            || offset >= self->entries) {
+        return (str_view) { "", 0 };
+    }
+
+    uint64_t len = read_u64(self->data + offset - sizeof (uint64_t));
+
+    /* leaves room for the null character */
+    if (len >= self->entries - offset) {
+        return (str_view) { "", 0 };
+    }
+
+    return (str_view) { self->data + offset, (size_t) len };
+}
+
+bool str_archive_verify(str_archive* self) {
+    if (!self) {
+        return false;
+    }
+
+    size_t end = self->size - sizeof (struct footer);
+
+    return str_fnv1a(STR_FNV1A_BASIS, self->data, end) == self->checksum;
+}
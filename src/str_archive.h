@@ -0,0 +1,124 @@
+/** str's On-Disk String Archive
+ * @file str_archive.h
+ *
+ * An archive stores an array of strings in a file that loads with a
+ * single mmap, every string is handed back as a view into the mapping.
+ *
+ * All integers are 64 bits wide in the byte order of the writer, which
+ * is recorded in the header, and every entry starts 8-aligned:
+ *
+ *     header  "\x89STRARC\n", u32 version, u32 byte order marker
+ *     entries u64 length, characters, '\0', padding to 8 bytes
+ *     index   u64 offset of the characters of every entry
+ *     footer  u64 count, u64 index offset, u64 checksum, magic again
+ *
+ * The checksum is the FNV-1a 64 hash of everything before the footer.
+ * It is kept at the end so the writer never seeks back. */
+#ifndef STR_ARCHIVE_H
+#define STR_ARCHIVE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "str.h"
+
+/** Version of the archive format written by str_archive_writer. */
+#define STR_ARCHIVE_VERSION 1
+
+/** Opaque str_archive_writer Structure */
+typedef struct str_archive_writer str_archive_writer;
+
+/** Opaque str_archive Structure */
+typedef struct str_archive str_archive;
+
+/** Creates writer streaming an archive to a file descriptor.
+ * @warning    The user has to free the object after usage with
+ *             str_archive_writer_close, which also completes the
+ *             archive.
+ *
+ * @note       The writer never seeks, so fd may be a pipe, and never
+ *             closes fd.
+ *
+ * @param fd   A file descriptor open for writing.
+ *
+ * @return     A pointer to a str_archive_writer object.
+ *
+ * @see str_archive_writer_close */
+str_archive_writer* str_archive_writer_new(int fd);
+
+/** Appends string to archive.
+ * @param self A pointer to a str_archive_writer object.
+ * @param v    A view.
+ *
+ * @return     true if successful.
+ *
+ * @see str_archive_at */
+bool str_archive_writer_write(str_archive_writer* self, str_view v);
+
+/** Writes index and footer and deletes the writer.
+ * @note       The writer is deleted even if writing fails.
+ *
+ * @param self A pointer to a str_archive_writer object.
+ *
+ * @return     true if the whole archive was written.
+ *
+ * @see str_archive_writer_new */
+bool str_archive_writer_close(str_archive_writer* self);
+
+/** Maps archive from a file descriptor.
+ * @warning    The user has to free the object after usage with
+ *             str_archive_unmap.
+ *
+ * @note       Only the header, footer and index size are checked,
+ *             use str_archive_verify to check the contents.
+ *
+ * @note       The mapping outlives fd, which may be closed right away.
+ *
+ * @param fd   A file descriptor open for reading.
+ *
+ * @return     A pointer to a str_archive object or null if the file is
+ *             not an archive of this version and byte order.
+ *
+ * @see str_archive_unmap str_archive_verify */
+str_archive* str_archive_map(int fd);
+
+/** Unmaps archive.
+ * @warning    It invalidates every view into the archive.
+ *
+ * @param self A pointer to a str_archive object. */
+void str_archive_unmap(str_archive* self);
+
+/** Returns number of strings in archive.
+ * @param self A pointer to a str_archive object. */
+size_t str_archive_len(str_archive* self);
+
+/** Returns view over string of archive.
+ * @note       The view is followed by a null character, and stays
+ *             valid until the archive is unmapped.
+ *
+ * @note       If i is out of range or its entry is malformed, it
+ *             returns an empty view.
+ *
+ * @param self A pointer to a str_archive object.
+ * @param i    Index of the string.
+ *
+ * @return     A view over the string. */
+str_view str_archive_at(str_archive* self, size_t i);
+
+/** Checks the checksum of archive.
+ * @note       It reads the whole file.
+ *
+ * @param self A pointer to a str_archive object.
+ *
+ * @return     true if the contents match the checksum. */
+bool str_archive_verify(str_archive* self);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* STR_ARCHIVE_H */
@@ -0,0 +1,169 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <unistd.h>
+
+#include <cmocka.h>
+
+#include "str.h"
+#include "str_archive.h"
+
+/* writes n views to a temporary file and returns its descriptor */
+static int write_archive(FILE* file, str_view const* views, size_t n) {
+    int fd = fileno(file);
+    str_archive_writer* writer = str_archive_writer_new(fd);
+
+    assert_non_null(writer);
+
+    for (size_t i = 0; i < n; ++i) {
+        assert_true(str_archive_writer_write(writer, views[i]));
+    }
+
+    assert_true(str_archive_writer_close(writer));
+
+    return fd;
+}
+
+static void str_archive_empty_test(void** state) {
+    (void) state;
+
+    FILE* file = tmpfile();
+    int fd = write_archive(file, (void*) 0, 0);
+
+    str_archive* archive = str_archive_map(fd);
+
+    assert_non_null(archive);
+    assert_int_equal(str_archive_len(archive), 0);
+    assert_int_equal(str_archive_at(archive, 0).len, 0);
+    assert_true(str_archive_verify(archive));
+
+    str_archive_unmap(archive);
+    str_archive_unmap((void*) 0);
+    fclose(file);
+}
+
+static void str_archive_roundtrip_test(void** state) {
+    (void) state;
+
+    str* big = str_new();
+
+    for (size_t i = 0; i < 100000; ++i) {
+        str_append_char(big, (char) ('a' + i % 26));
+    }
+
+    str_view const views[] = {
+        str_view_of("foo"),
+        str_view_of(""),
+        { "nul\0inside", 10 },
+        str_view_of("exactly8"),
+        str_view_of(big),
+        str_view_of("last"),
+    };
+    size_t const n = sizeof views / sizeof views[0];
+
+    FILE* file = tmpfile();
+    int fd = write_archive(file, views, n);
+
+    str_archive* archive = str_archive_map(fd);
+
+    /* the mapping outlives the file */
+    fclose(file);
+
+    assert_non_null(archive);
+    assert_int_equal(str_archive_len(archive), n);
+    assert_true(str_archive_verify(archive));
+
+    for (size_t i = 0; i < n; ++i) {
+        str_view v = str_archive_at(archive, i);
+
+        assert_int_equal(v.len, views[i].len);
+        assert_memory_equal(v.data, views[i].data, v.len);
+        assert_int_equal(v.data[v.len], '\0');
+        assert_int_equal((size_t) v.data % 8, 0);
+    }
+
+    assert_int_equal(str_archive_at(archive, n).len, 0);
+
+    str_archive_unmap(archive);
+    str_del(big);
+}
+
+static void str_archive_corrupt_test(void** state) {
+    (void) state;
+
+    str_view const views[] = { str_view_of("alpha"), str_view_of("beta") };
+
+    FILE* file = tmpfile();
+    int fd = write_archive(file, views, 2);
+
+    /* flips a character of the first string */
+    char c;
+
+    assert_int_equal(pread(fd, &c, 1, 24), 1);
+    assert_int_equal(c, 'a');
+    assert_int_equal(pwrite(fd, "A", 1, 24), 1);
+
+    str_archive* archive = str_archive_map(fd);
+
+    assert_non_null(archive);
+    assert_false(str_archive_verify(archive));
+    assert_memory_equal(str_archive_at(archive, 0).data, "Alpha", 5);
+
+    str_archive_unmap(archive);
+
+    /* a bad version is refused */
+    assert_int_equal(pwrite(fd, "\x02", 1, 8), 1);
+    assert_null(str_archive_map(fd));
+    assert_int_equal(pwrite(fd, "\x01", 1, 8), 1);
+
+    /* and so is a truncated file */
+    off_t size = lseek(fd, 0, SEEK_END);
+
+    assert_int_equal(ftruncate(fd, size - 1), 0);
+    assert_null(str_archive_map(fd));
+    assert_int_equal(ftruncate(fd, 0), 0);
+    assert_null(str_archive_map(fd));
+
+    fclose(file);
+}
+
+static void str_archive_pipe_test(void** state) {
+    (void) state;
+
+    int fds[2];
+    char buffer[256];
+
+    assert_int_equal(pipe(fds), 0);
+
+    str_archive_writer* writer = str_archive_writer_new(fds[1]);
+
+    assert_true(str_archive_writer_write(writer, str_view_of("streamed")));
+    assert_true(str_archive_writer_close(writer));
+    close(fds[1]);
+
+    /* header, one entry of 8 + 16 bytes, one offset and the footer */
+    assert_int_equal(read(fds[0], buffer, sizeof buffer), 16 + 24 + 8 + 32);
+    assert_memory_equal(buffer, "\x89STRARC\n", 8);
+    assert_memory_equal(buffer + 24, "streamed", 9);
+
+    close(fds[0]);
+}
+
+
+int main(void) {
+    struct CMUnitTest const tests[] = {
+        cmocka_unit_test(str_archive_empty_test),
+        cmocka_unit_test(str_archive_roundtrip_test),
+        cmocka_unit_test(str_archive_corrupt_test),
+        cmocka_unit_test(str_archive_pipe_test),
+    };
+
+
+    return cmocka_run_group_tests(tests, (void*) 0, (void*) 0);
+}
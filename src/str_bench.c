@@ -0,0 +1,524 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "str.h"
+#include "str_codec.h"
+#include "str_escape.h"
+#include "str_hash.h"
+#include "str_template.h"
+
+/* Microbenchmarks of the public str API.
+ *
+ * Usage: str_bench [-f table|csv|json] [-m max size] [-t seconds]
+ *
+ * Every case runs for at least the given time (0.2s by default) at
+ * sizes from 8 B growing 8 times up to the max size (16M by default,
+ * use -m 1G for the full range). Allocations are counted by wrapping
+ * the allocator at link time, see the bench target of the Makefile. */
+
+enum format {
+    FORMAT_TABLE,
+    FORMAT_CSV,
+    FORMAT_JSON,
+};
+
+struct options {
+    enum format format;
+    size_t max_size;
+    double min_time;
+};
+
+struct result {
+    char const* name;
+    size_t size;
+    size_t iterations;
+    double seconds;
+    size_t allocations;
+};
+
+/* state shared by a case across its iterations */
+struct fixture {
+    size_t size;
+    char* cstr;
+    str* a;
+    str* b;
+    /* reversed in place, so it doesn't disturb a */
+    str* c;
+    str* scratch;
+    /* encodings of a */
+    str* base64;
+    str* hex;
+    /* rendered with a as its first value, into the same str */
+    str_template* template;
+    str* rendered;
+};
+
+struct bench {
+    char const* name;
+    /* true if every iteration needs a fresh copy of a in scratch */
+    bool mutates;
+    void (*run)(struct fixture* f);
+};
+
+/* -- Allocation Counting -- */
+
+static size_t allocations;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t n, size_t size);
+void* __real_realloc(void* p, size_t size);
+
+void* __wrap_malloc(size_t size) {
+    allocations++;
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t n, size_t size) {
+    allocations++;
+    return __real_calloc(n, size);
+}
+
+void* __wrap_realloc(void* p, size_t size) {
+    allocations++;
+    return __real_realloc(p, size);
+}
+
+/* -- Cases -- */
+
+/* keeps the compiler from dropping the results */
+static volatile size_t sink;
+
+static void bench_new_del(struct fixture* f) {
+    (void) f;
+
+    str_del(str_new());
+}
+
+static void bench_append_char(struct fixture* f) {
+    str* s = str_new();
+
+    for (size_t i = 0; i < f->size; ++i) {
+        str_append_char(s, 'x');
+    }
+
+    sink = str_len(s);
+    str_del(s);
+}
+
+static void bench_append_cstr(struct fixture* f) {
+    str* s = str_new();
+
+    str_append_cstr(s, f->cstr);
+
+    sink = str_len(s);
+    str_del(s);
+}
+
+static void bench_append_str(struct fixture* f) {
+    str* s = str_new();
+
+    str_append_str(s, f->a);
+
+    sink = str_len(s);
+    str_del(s);
+}
+
+static void bench_slice(struct fixture* f) {
+    str* s = str_slice(f->a, f->size / 4, f->size / 4 * 3);
+
+    sink = str_len(s);
+    str_del(s);
+}
+
+static void bench_clone(struct fixture* f) {
+    str* s = str_clone(f->a);
+
+    sink = str_len(s);
+    str_del(s);
+}
+
+static void bench_remove(struct fixture* f) {
+    str_remove(f->scratch, f->size / 4, f->size / 4 * 3);
+}
+
+static void bench_insert(struct fixture* f) {
+    str_insert(f->scratch, f->size / 2, str_view_of("inserted"));
+}
+
+static void bench_center(struct fixture* f) {
+    str_center(f->scratch, f->size * 2, ' ');
+}
+
+static void bench_repeat(struct fixture* f) {
+    str* s = str_repeat(str_view_of("-="), f->size / 2);
+
+    sink = str_len(s);
+    str_del(s);
+}
+
+static void bench_reverse(struct fixture* f) {
+    str_reverse(f->c);
+}
+
+static void bench_cmp(struct fixture* f) {
+    sink = (size_t) str_cmp(f->a, f->b);
+}
+
+static void bench_equal(struct fixture* f) {
+    sink = str_equal(f->a, f->b);
+}
+
+static void bench_compare(struct fixture* f) {
+    sink = (size_t) str_compare(str_view_of(f->a), str_view_of(f->b));
+}
+
+static void bench_common_prefix(struct fixture* f) {
+    sink = str_common_prefix_len(str_view_of(f->a), str_view_of(f->b));
+}
+
+static void bench_append_base64(struct fixture* f) {
+    str* s = str_new();
+
+    str_append_base64(s, str_view_of(f->a), STR_CODEC_DEFAULT);
+
+    sink = str_len(s);
+    str_del(s);
+}
+
+static void bench_base64_scalar(struct fixture* f) {
+    str* s = str_new();
+
+    str_append_base64(s, str_view_of(f->a), STR_CODEC_SCALAR);
+
+    sink = str_len(s);
+    str_del(s);
+}
+
+static void bench_decode_base64(struct fixture* f) {
+    str* s = str_new();
+
+    str_decode_base64(s, str_view_of(f->base64), STR_CODEC_DEFAULT);
+
+    sink = str_len(s);
+    str_del(s);
+}
+
+static void bench_unbase64_scalar(struct fixture* f) {
+    str* s = str_new();
+
+    str_decode_base64(s, str_view_of(f->base64), STR_CODEC_SCALAR);
+
+    sink = str_len(s);
+    str_del(s);
+}
+
+static void bench_append_hex(struct fixture* f) {
+    str* s = str_new();
+
+    str_append_hex(s, str_view_of(f->a), STR_CODEC_DEFAULT);
+
+    sink = str_len(s);
+    str_del(s);
+}
+
+static void bench_hex_scalar(struct fixture* f) {
+    str* s = str_new();
+
+    str_append_hex(s, str_view_of(f->a), STR_CODEC_SCALAR);
+
+    sink = str_len(s);
+    str_del(s);
+}
+
+static void bench_decode_hex(struct fixture* f) {
+    str* s = str_new();
+
+    str_decode_hex(s, str_view_of(f->hex), STR_CODEC_DEFAULT);
+
+    sink = str_len(s);
+    str_del(s);
+}
+
+static void bench_unhex_scalar(struct fixture* f) {
+    str* s = str_new();
+
+    str_decode_hex(s, str_view_of(f->hex), STR_CODEC_SCALAR);
+
+    sink = str_len(s);
+    str_del(s);
+}
+
+static void bench_json_escaped(struct fixture* f) {
+    str* s = str_new();
+
+    str_append_json_escaped(s, str_view_of(f->a));
+
+    sink = str_len(s);
+    str_del(s);
+}
+
+static void bench_crc32c(struct fixture* f) {
+    sink = str_crc32c(0, str_view_of(f->a), STR_HASH_DEFAULT);
+}
+
+static void bench_crc32c_scalar(struct fixture* f) {
+    sink = str_crc32c(0, str_view_of(f->a), STR_HASH_SCALAR);
+}
+
+static void bench_murmur3(struct fixture* f) {
+    sink = (size_t) str_murmur3(str_view_of(f->a), 0).lo;
+}
+
+static void bench_template_render(struct fixture* f) {
+    str_view values[] = {
+        str_view_of(f->a), str_view_of("42"), str_view_of("tomorrow"),
+    };
+
+    str_template_render(f->template, values, f->rendered);
+
+    sink = str_len(f->rendered);
+}
+
+static struct bench const benches[] = {
+    { "str_new_del",      false, bench_new_del },
+    { "str_append_char",  false, bench_append_char },
+    { "str_append_cstr",  false, bench_append_cstr },
+    { "str_append_str",   false, bench_append_str },
+    { "str_slice",        false, bench_slice },
+    { "str_clone",        false, bench_clone },
+    { "str_remove",       true,  bench_remove },
+    { "str_insert",       true,  bench_insert },
+    { "str_center",       true,  bench_center },
+    { "str_repeat",       false, bench_repeat },
+    { "str_reverse",      false, bench_reverse },
+    { "str_cmp",          false, bench_cmp },
+    { "str_equal",        false, bench_equal },
+    { "str_compare",      false, bench_compare },
+    { "str_common_prefix", false, bench_common_prefix },
+    /* sizes are those of the bytes, encoded or decoded */
+    { "str_append_base64", false, bench_append_base64 },
+    { "base64_scalar",    false, bench_base64_scalar },
+    { "str_decode_base64", false, bench_decode_base64 },
+    { "unbase64_scalar",  false, bench_unbase64_scalar },
+    { "str_append_hex",   false, bench_append_hex },
+    { "hex_scalar",       false, bench_hex_scalar },
+    { "str_decode_hex",   false, bench_decode_hex },
+    { "unhex_scalar",     false, bench_unhex_scalar },
+    { "str_json_escaped", false, bench_json_escaped },
+    { "str_crc32c",       false, bench_crc32c },
+    { "crc32c_scalar",    false, bench_crc32c_scalar },
+    { "str_murmur3",      false, bench_murmur3 },
+    { "str_template_render", false, bench_template_render },
+};
+
+/* -- Harness -- */
+
+static double now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+static bool fixture_new(struct fixture* f, size_t size) {
+    f->size = size;
+    f->cstr = malloc(size + 1);
+    f->a = str_new();
+    f->b = str_new();
+    f->c = str_new();
+    f->scratch = (void*) 0;
+    f->base64 = str_new();
+    f->hex = str_new();
+    f->template = str_template_compile(str_view_of(
+                "<p>Hello {name}, order {id} ships {when}.</p>"));
+    f->rendered = str_new();
+
+    if (!f->cstr || !f->a || !f->b || !f->c || !f->base64 || !f->hex
+            || !f->template || !f->rendered) {
+        return false;
+    }
+
+    for (size_t i = 0; i < size; ++i) {
+        f->cstr[i] = (char) ('a' + i % 26);
+    }
+
+    f->cstr[size] = 0;
+
+    /* b equals a, so the comparisons look at every byte */
+    return str_append_cstr(f->a, f->cstr)
+        && str_append_cstr(f->b, f->cstr)
+        && str_append_cstr(f->c, f->cstr)
+        && str_append_base64(f->base64, str_view_of(f->a), STR_CODEC_DEFAULT)
+        && str_append_hex(f->hex, str_view_of(f->a), STR_CODEC_DEFAULT);
+}
+
+static void fixture_del(struct fixture* f) {
+    free(f->cstr);
+    str_del(f->a);
+    str_del(f->b);
+    str_del(f->c);
+    str_del(f->scratch);
+    str_del(f->base64);
+    str_del(f->hex);
+    str_template_del(f->template);
+    str_del(f->rendered);
+}
+
+static struct result measure(struct bench const* bench, struct fixture* f,
+        double min_time) {
+    struct result r = { bench->name, f->size, 0, 0, 0 };
+
+    /* doubles the batch until it runs long enough */
+    for (size_t batch = 1; r.seconds < min_time; batch *= 2) {
+        double elapsed = 0;
+        size_t allocated = 0;
+
+        for (size_t i = 0; i < batch; ++i) {
+            if (bench->mutates) {
+                str_del(f->scratch);
+                f->scratch = str_clone(f->a);
+            }
+
+            /* mutating cases are timed one by one
+             * to leave the copy out */
+            if (bench->mutates || i == 0) {
+                double start = now();
+                size_t before = allocations;
+
+                bench->run(f);
+
+                allocated += allocations - before;
+                elapsed += now() - start;
+
+                continue;
+            }
+
+            double start = now();
+            size_t before = allocations;
+
+            for (; i < batch; ++i) {
+                bench->run(f);
+            }
+
+            allocated += allocations - before;
+            elapsed += now() - start;
+        }
+
+        r.iterations += batch;
+        r.seconds += elapsed;
+        r.allocations += allocated;
+    }
+
+    return r;
+}
+
+static void report(struct result const* r, enum format format, bool first) {
+    double ns = r->seconds * 1e9 / (double) r->iterations;
+    double bps = (double) r->size * (double) r->iterations / r->seconds;
+    double allocs = (double) r->allocations / (double) r->iterations;
+
+    switch (format) {
+    case FORMAT_TABLE:
+        if (first) {
+            printf("%-18s %12s %12s %16s %14s %10s\n", "benchmark", "size",
+                    "iterations", "ns/op", "MB/s", "allocs/op");
+        }
+
+        printf("%-18s %12zu %12zu %16.1f %14.1f %10.2f\n", r->name,
+                r->size, r->iterations, ns, bps / 1e6, allocs);
+        break;
+    case FORMAT_CSV:
+        if (first) {
+            printf("benchmark,size,iterations,ns_per_op,bytes_per_s,"
+                    "allocs_per_op\n");
+        }
+
+        printf("%s,%zu,%zu,%.3f,%.1f,%.3f\n", r->name, r->size,
+                r->iterations, ns, bps, allocs);
+        break;
+    case FORMAT_JSON:
+        printf("%s{\"benchmark\":\"%s\",\"size\":%zu,\"iterations\":%zu,"
+                "\"ns_per_op\":%.3f,\"bytes_per_s\":%.1f,"
+                "\"allocs_per_op\":%.3f}", first ? "[\n  " : ",\n  ",
+                r->name, r->size, r->iterations, ns, bps, allocs);
+        break;
+    }
+}
+
+static size_t parse_size(char const* s) {
+    char* end;
+    size_t size = strtoul(s, &end, 10);
+
+    switch (*end) {
+    case 'G': size <<= 10; /* fallthrough */
+    case 'M': size <<= 10; /* fallthrough */
+    case 'K': size <<= 10; break;
+    }
+
+    return size;
+}
+
+static bool parse(int argc, char const** argv, struct options* options) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "-f")) {
+            if (!strcmp(argv[i + 1], "csv")) {
+                options->format = FORMAT_CSV;
+            } else if (!strcmp(argv[i + 1], "json")) {
+                options->format = FORMAT_JSON;
+            } else if (!strcmp(argv[i + 1], "table")) {
+                options->format = FORMAT_TABLE;
+            } else {
+                return false;
+            }
+        } else if (!strcmp(argv[i], "-m")) {
+            options->max_size = parse_size(argv[i + 1]);
+        } else if (!strcmp(argv[i], "-t")) {
+            options->min_time = strtod(argv[i + 1], (void*) 0);
+        } else {
+            return false;
+        }
+    }
+
+    return argc % 2 == 1;
+}
+
+int main(int argc, char const** argv) {
+    struct options options = { FORMAT_TABLE, 16 << 20, 0.2 };
+
+    if (!parse(argc, argv, &options)) {
+        fprintf(stderr, "usage: %s [-f table|csv|json] [-m max size] "
+                "[-t seconds]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    bool first = true;
+
+    for (size_t size = 8; size <= options.max_size; size *= 8) {
+        struct fixture f;
+
+        if (!fixture_new(&f, size)) {
+            fixture_del(&f);
+            return EXIT_FAILURE;
+        }
+
+        for (size_t i = 0; i < sizeof benches / sizeof benches[0]; ++i) {
+            struct result r = measure(&benches[i], &f, options.min_time);
+
+            report(&r, options.format, first);
+            first = false;
+        }
+
+        fixture_del(&f);
+    }
+
+    if (options.format == FORMAT_JSON) {
+        printf(first ? "[]\n" : "\n]\n");
+    }
+
+    return EXIT_SUCCESS;
+}
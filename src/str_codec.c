@@ -0,0 +1,764 @@
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "str_codec.h"
+#include "str_private.h"
+#include "str_simd.h"
+
+/* output is staged in a stack buffer and appended a chunk at a time,
+ * the slack takes the full stores of the kernels past their output */
+#define CHUNK 4096
+#define SLACK 32
+
+/* marks bytes outside of the alphabet in decoding tables */
+#define INVALID 0xff
+
+static char const BASE64[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+static char const BASE64_URL[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+static char const HEX[] = "0123456789abcdef";
+static char const HEX_UPPER[] = "0123456789ABCDEF";
+
+/* -- Private Interface -- */
+
+static enum str_simd simd(unsigned flags) {
+    enum str_simd level = str_simd_detect();
+
+    if (flags & STR_CODEC_SCALAR) {
+        return STR_SIMD_SCALAR;
+    }
+
+    if ((flags & STR_CODEC_SSSE3) && level > STR_SIMD_SSSE3) {
+        return STR_SIMD_SSSE3;
+    }
+
+    return level;
+}
+
+static bool space(unsigned char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+/* -- Kernels -- */
+
+#ifdef STR_SIMD_X86
+
+/* base64 after Muła and Lemire, Faster Base64 Encoding and Decoding
+ * Using AVX2 Instructions: bytes are shuffled so that every 32 bit word
+ * holds three of them, whose 6 bit fields are moved in place by
+ * multiplications, then mapped to the alphabet by adding an offset
+ * looked up from the range of the value */
+
+STR_SIMD_TARGET("ssse3")
+static __m128i base64_encode_ranges(char const* alphabet) {
+    return _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            (char) (alphabet[62] - 62), (char) (alphabet[63] - 63), 'A', 0,
+            0);
+}
+
+STR_SIMD_TARGET("ssse3")
+static size_t base64_encode_ssse3(char* out, unsigned char const* in,
+        size_t n, char const* alphabet) {
+    __m128i const order = _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7,
+            10, 9, 11, 10);
+    __m128i const ranges = base64_encode_ranges(alphabet);
+    size_t i = 0;
+
+    /* 12 bytes to 16 characters, loads read 4 bytes ahead */
+    for (; i + 16 <= n; i += 12, out += 16) {
+        __m128i v = _mm_shuffle_epi8(
+                _mm_loadu_si128((__m128i const*) (in + i)), order);
+        __m128i hi = _mm_mulhi_epu16(
+                _mm_and_si128(v, _mm_set1_epi32(0x0fc0fc00)),
+                _mm_set1_epi32(0x04000040));
+        __m128i lo = _mm_mullo_epi16(
+                _mm_and_si128(v, _mm_set1_epi32(0x003f03f0)),
+                _mm_set1_epi32(0x01000010));
+        __m128i index = _mm_or_si128(hi, lo);
+        __m128i range = _mm_or_si128(
+                _mm_subs_epu8(index, _mm_set1_epi8(51)),
+                _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), index),
+                    _mm_set1_epi8(13)));
+
+        _mm_storeu_si128((__m128i*) out,
+                _mm_add_epi8(index, _mm_shuffle_epi8(ranges, range)));
+    }
+
+    return i;
+}
+
+STR_SIMD_TARGET("avx2")
+static size_t base64_encode_avx2(char* out, unsigned char const* in,
+        size_t n, char const* alphabet) {
+    __m256i const order = _mm256_broadcastsi128_si256(_mm_setr_epi8(1, 0,
+                2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+    __m256i const ranges = _mm256_broadcastsi128_si256(
+            base64_encode_ranges(alphabet));
+    size_t i = 0;
+
+    /* 24 bytes to 32 characters, 12 bytes per lane */
+    for (; i + 28 <= n; i += 24, out += 32) {
+        __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(
+                    _mm_loadu_si128((__m128i const*) (in + i))),
+                _mm_loadu_si128((__m128i const*) (in + i + 12)), 1);
+
+        v = _mm256_shuffle_epi8(v, order);
+
+        __m256i hi = _mm256_mulhi_epu16(
+                _mm256_and_si256(v, _mm256_set1_epi32(0x0fc0fc00)),
+                _mm256_set1_epi32(0x04000040));
+        __m256i lo = _mm256_mullo_epi16(
+                _mm256_and_si256(v, _mm256_set1_epi32(0x003f03f0)),
+                _mm256_set1_epi32(0x01000010));
+        __m256i index = _mm256_or_si256(hi, lo);
+        __m256i range = _mm256_or_si256(
+                _mm256_subs_epu8(index, _mm256_set1_epi8(51)),
+                _mm256_and_si256(
+                    _mm256_cmpgt_epi8(_mm256_set1_epi8(26), index),
+                    _mm256_set1_epi8(13)));
+
+        _mm256_storeu_si256((__m256i*) out,
+                _mm256_add_epi8(index, _mm256_shuffle_epi8(ranges, range)));
+    }
+
+    return i;
+}
+
+/* decoding classifies every character by range, stopping at the first
+ * block holding one outside of the alphabet, which is left to the
+ * scalar code, and packs four 6 bit values to three bytes with
+ * multiply-adds */
+
+STR_SIMD_TARGET("ssse3")
+static __m128i in_range(__m128i v, char lo, char hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8((char) (lo - 1))),
+            _mm_cmpgt_epi8(_mm_set1_epi8((char) (hi + 1)), v));
+}
+
+STR_SIMD_TARGET("avx2")
+static __m256i in_range256(__m256i v, char lo, char hi) {
+    return _mm256_and_si256(
+            _mm256_cmpgt_epi8(v, _mm256_set1_epi8((char) (lo - 1))),
+            _mm256_cmpgt_epi8(_mm256_set1_epi8((char) (hi + 1)), v));
+}
+
+STR_SIMD_TARGET("ssse3")
+static size_t base64_decode_ssse3(unsigned char* out, char const* in,
+        size_t n, char const* alphabet) {
+    __m128i const order = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13,
+            12, -1, -1, -1, -1);
+    size_t i = 0;
+
+    /* 16 characters to 12 bytes */
+    for (; i + 16 <= n; i += 16, out += 12) {
+        __m128i v = _mm_loadu_si128((__m128i const*) (in + i));
+        __m128i upper = in_range(v, 'A', 'Z');
+        __m128i lower = in_range(v, 'a', 'z');
+        __m128i digit = in_range(v, '0', '9');
+        __m128i c62 = _mm_cmpeq_epi8(v, _mm_set1_epi8(alphabet[62]));
+        __m128i c63 = _mm_cmpeq_epi8(v, _mm_set1_epi8(alphabet[63]));
+        __m128i valid = _mm_or_si128(_mm_or_si128(upper, lower),
+                _mm_or_si128(digit, _mm_or_si128(c62, c63)));
+
+        if (_mm_movemask_epi8(valid) != 0xffff) {
+            break;
+        }
+
+        __m128i offset = _mm_or_si128(
+                _mm_or_si128(_mm_and_si128(upper, _mm_set1_epi8(-'A')),
+                    _mm_and_si128(lower, _mm_set1_epi8(26 - 'a'))),
+                _mm_or_si128(_mm_and_si128(digit, _mm_set1_epi8(52 - '0')),
+                    _mm_or_si128(
+                        _mm_and_si128(c62,
+                            _mm_set1_epi8((char) (62 - alphabet[62]))),
+                        _mm_and_si128(c63,
+                            _mm_set1_epi8((char) (63 - alphabet[63]))))));
+        __m128i values = _mm_add_epi8(v, offset);
+        __m128i merged = _mm_madd_epi16(
+                _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140)),
+                _mm_set1_epi32(0x00011000));
+
+        _mm_storeu_si128((__m128i*) out, _mm_shuffle_epi8(merged, order));
+    }
+
+    return i;
+}
+
+STR_SIMD_TARGET("avx2")
+static size_t base64_decode_avx2(unsigned char* out, char const* in,
+        size_t n, char const* alphabet) {
+    __m256i const order = _mm256_broadcastsi128_si256(_mm_setr_epi8(2, 1,
+                0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    size_t i = 0;
+
+    /* 32 characters to 24 bytes, 12 bytes per lane */
+    for (; i + 32 <= n; i += 32, out += 24) {
+        __m256i v = _mm256_loadu_si256((__m256i const*) (in + i));
+        __m256i upper = in_range256(v, 'A', 'Z');
+        __m256i lower = in_range256(v, 'a', 'z');
+        __m256i digit = in_range256(v, '0', '9');
+        __m256i c62 = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(alphabet[62]));
+        __m256i c63 = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(alphabet[63]));
+        __m256i valid = _mm256_or_si256(_mm256_or_si256(upper, lower),
+                _mm256_or_si256(digit, _mm256_or_si256(c62, c63)));
+
+        if ((unsigned) _mm256_movemask_epi8(valid) != 0xffffffffu) {
+            break;
+        }
+
+        __m256i offset = _mm256_or_si256(
+                _mm256_or_si256(
+                    _mm256_and_si256(upper, _mm256_set1_epi8(-'A')),
+                    _mm256_and_si256(lower, _mm256_set1_epi8(26 - 'a'))),
+                _mm256_or_si256(
+                    _mm256_and_si256(digit, _mm256_set1_epi8(52 - '0')),
+                    _mm256_or_si256(
+                        _mm256_and_si256(c62,
+                            _mm256_set1_epi8((char) (62 - alphabet[62]))),
+                        _mm256_and_si256(c63,
+                            _mm256_set1_epi8((char) (63 - alphabet[63]))))));
+        __m256i values = _mm256_add_epi8(v, offset);
+        __m256i merged = _mm256_shuffle_epi8(_mm256_madd_epi16(
+                    _mm256_maddubs_epi16(values,
+                        _mm256_set1_epi32(0x01400140)),
+                    _mm256_set1_epi32(0x00011000)), order);
+
+        _mm_storeu_si128((__m128i*) out, _mm256_castsi256_si128(merged));
+        _mm_storeu_si128((__m128i*) (out + 12),
+                _mm256_extracti128_si256(merged, 1));
+    }
+
+    return i;
+}
+
+/* hex looks up both nibbles of every byte in a 16 byte table and
+ * interleaves them */
+
+STR_SIMD_TARGET("ssse3")
+static size_t hex_encode_ssse3(char* out, unsigned char const* in,
+        size_t n, char const* digits) {
+    __m128i const table = _mm_loadu_si128((__m128i const*) digits);
+    __m128i const mask = _mm_set1_epi8(0x0f);
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16, out += 32) {
+        __m128i v = _mm_loadu_si128((__m128i const*) (in + i));
+        __m128i hi = _mm_shuffle_epi8(table,
+                _mm_and_si128(_mm_srli_epi16(v, 4), mask));
+        __m128i lo = _mm_shuffle_epi8(table, _mm_and_si128(v, mask));
+
+        _mm_storeu_si128((__m128i*) out, _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128((__m128i*) (out + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+
+    return i;
+}
+
+STR_SIMD_TARGET("avx2")
+static size_t hex_encode_avx2(char* out, unsigned char const* in,
+        size_t n, char const* digits) {
+    __m256i const table = _mm256_broadcastsi128_si256(
+            _mm_loadu_si128((__m128i const*) digits));
+    __m256i const mask = _mm256_set1_epi8(0x0f);
+    size_t i = 0;
+
+    for (; i + 32 <= n; i += 32, out += 64) {
+        __m256i v = _mm256_loadu_si256((__m256i const*) (in + i));
+        __m256i hi = _mm256_shuffle_epi8(table,
+                _mm256_and_si256(_mm256_srli_epi16(v, 4), mask));
+        __m256i lo = _mm256_shuffle_epi8(table, _mm256_and_si256(v, mask));
+        /* the unpacks work within lanes */
+        __m256i first = _mm256_unpacklo_epi8(hi, lo);
+        __m256i second = _mm256_unpackhi_epi8(hi, lo);
+
+        _mm256_storeu_si256((__m256i*) out,
+                _mm256_permute2x128_si256(first, second, 0x20));
+        _mm256_storeu_si256((__m256i*) (out + 32),
+                _mm256_permute2x128_si256(first, second, 0x31));
+    }
+
+    return i;
+}
+
+/* returns the nibbles of 16 digits, with valid set to the lanes
+ * holding digits */
+STR_SIMD_TARGET("ssse3")
+static __m128i nibbles(__m128i v, __m128i* valid) {
+    __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+    __m128i digit = in_range(v, '0', '9');
+    __m128i alpha = in_range(lower, 'a', 'f');
+
+    *valid = _mm_or_si128(digit, alpha);
+
+    return _mm_or_si128(
+            _mm_and_si128(digit, _mm_sub_epi8(v, _mm_set1_epi8('0'))),
+            _mm_and_si128(alpha,
+                _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))));
+}
+
+STR_SIMD_TARGET("avx2")
+static __m256i nibbles256(__m256i v, __m256i* valid) {
+    __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+    __m256i digit = in_range256(v, '0', '9');
+    __m256i alpha = in_range256(lower, 'a', 'f');
+
+    *valid = _mm256_or_si256(digit, alpha);
+
+    return _mm256_or_si256(
+            _mm256_and_si256(digit, _mm256_sub_epi8(v, _mm256_set1_epi8('0'))),
+            _mm256_and_si256(alpha,
+                _mm256_sub_epi8(lower, _mm256_set1_epi8('a' - 10))));
+}
+
+STR_SIMD_TARGET("ssse3")
+static size_t hex_decode_ssse3(unsigned char* out, char const* in,
+        size_t n) {
+    /* the high nibble comes first, so it is weighted 16 */
+    __m128i const weights = _mm_set1_epi16(0x0110);
+    size_t i = 0;
+
+    for (; i + 32 <= n; i += 32, out += 16) {
+        __m128i valid_a;
+        __m128i valid_b;
+        __m128i a = nibbles(_mm_loadu_si128((__m128i const*) (in + i)),
+                &valid_a);
+        __m128i b = nibbles(_mm_loadu_si128((__m128i const*) (in + i + 16)),
+                &valid_b);
+
+        if (_mm_movemask_epi8(_mm_and_si128(valid_a, valid_b)) != 0xffff) {
+            break;
+        }
+
+        _mm_storeu_si128((__m128i*) out, _mm_packus_epi16(
+                    _mm_maddubs_epi16(a, weights),
+                    _mm_maddubs_epi16(b, weights)));
+    }
+
+    return i;
+}
+
+STR_SIMD_TARGET("avx2")
+static size_t hex_decode_avx2(unsigned char* out, char const* in,
+        size_t n) {
+    __m256i const weights = _mm256_set1_epi16(0x0110);
+    size_t i = 0;
+
+    for (; i + 64 <= n; i += 64, out += 32) {
+        __m256i valid_a;
+        __m256i valid_b;
+        __m256i a = nibbles256(
+                _mm256_loadu_si256((__m256i const*) (in + i)), &valid_a);
+        __m256i b = nibbles256(
+                _mm256_loadu_si256((__m256i const*) (in + i + 32)), &valid_b);
+
+        if ((unsigned) _mm256_movemask_epi8(
+                    _mm256_and_si256(valid_a, valid_b)) != 0xffffffffu) {
+            break;
+        }
+
+        /* the pack interleaves the lanes of a and b */
+        __m256i packed = _mm256_packus_epi16(
+                _mm256_maddubs_epi16(a, weights),
+                _mm256_maddubs_epi16(b, weights));
+
+        _mm256_storeu_si256((__m256i*) out,
+                _mm256_permute4x64_epi64(packed, 0xd8));
+    }
+
+    return i;
+}
+
+#endif /* STR_SIMD_X86 */
+
+/* -- Base64 -- */
+
+/* encodes the first n bytes of in, or the largest multiple of three
+ * below, and returns how many that is; in must have readable bytes */
+static size_t base64_encode(char* out, unsigned char const* in, size_t n,
+        size_t readable, char const* alphabet, enum str_simd level) {
+    size_t i = 0;
+
+#ifdef STR_SIMD_X86
+    /* the kernels load 4 bytes past the groups they encode */
+    size_t limit = readable - n >= 4 ? n + 4 : readable;
+
+    if (level == STR_SIMD_AVX2) {
+        i = base64_encode_avx2(out, in, limit, alphabet);
+    }
+
+    if (level >= STR_SIMD_SSSE3) {
+        i += base64_encode_ssse3(out + i / 3 * 4, in + i, limit - i,
+                alphabet);
+    }
+#else
+    (void) readable;
+    (void) level;
+#endif /* STR_SIMD_X86 */
+
+    for (out += i / 3 * 4; i + 3 <= n; i += 3, out += 4) {
+        uint32_t v = (uint32_t) in[i] << 16 | (uint32_t) in[i + 1] << 8
+            | in[i + 2];
+
+        out[0] = alphabet[v >> 18];
+        out[1] = alphabet[v >> 12 & 63];
+        out[2] = alphabet[v >> 6 & 63];
+        out[3] = alphabet[v & 63];
+    }
+
+    return i;
+}
+
+/* decodes whole blocks of the first n characters of in, stopping at
+ * any character outside of the alphabet, and returns how many it
+ * decoded, which is a multiple of four */
+static size_t base64_decode_blocks(unsigned char* out, char const* in,
+        size_t n, char const* alphabet, enum str_simd level) {
+    size_t i = 0;
+
+#ifdef STR_SIMD_X86
+    if (level == STR_SIMD_AVX2) {
+        i = base64_decode_avx2(out, in, n, alphabet);
+    }
+
+    if (level >= STR_SIMD_SSSE3) {
+        i += base64_decode_ssse3(out + i / 4 * 3, in + i, n - i, alphabet);
+    }
+#else
+    (void) out;
+    (void) in;
+    (void) n;
+    (void) alphabet;
+    (void) level;
+#endif /* STR_SIMD_X86 */
+
+    return i;
+}
+
+/* -- Hex -- */
+
+static size_t hex_encode(char* out, unsigned char const* in, size_t n,
+        char const* digits, enum str_simd level) {
+    size_t i = 0;
+
+#ifdef STR_SIMD_X86
+    if (level == STR_SIMD_AVX2) {
+        i = hex_encode_avx2(out, in, n, digits);
+    }
+
+    if (level >= STR_SIMD_SSSE3) {
+        i += hex_encode_ssse3(out + 2 * i, in + i, n - i, digits);
+    }
+#else
+    (void) level;
+#endif /* STR_SIMD_X86 */
+
+    for (out += 2 * i; i < n; ++i, out += 2) {
+        out[0] = digits[in[i] >> 4];
+        out[1] = digits[in[i] & 15];
+    }
+
+    return n;
+}
+
+static size_t hex_decode_blocks(unsigned char* out, char const* in,
+        size_t n, enum str_simd level) {
+    size_t i = 0;
+
+#ifdef STR_SIMD_X86
+    if (level == STR_SIMD_AVX2) {
+        i = hex_decode_avx2(out, in, n);
+    }
+
+    if (level >= STR_SIMD_SSSE3) {
+        i += hex_decode_ssse3(out + i / 2, in + i, n - i);
+    }
+#else
+    (void) out;
+    (void) in;
+    (void) n;
+    (void) level;
+#endif /* STR_SIMD_X86 */
+
+    return i;
+}
+
+/* -- Public Interface Implementation -- */
+
+size_t str_base64_len(size_t n, unsigned flags) {
+    size_t rest = n % 3;
+
+    /* overflow */
+    if (n / 3 >= SIZE_MAX / 4) {
+        return SIZE_MAX;
+    }
+
+    if (!rest) {
+        return n / 3 * 4;
+    }
+
+    return n / 3 * 4 + (flags & STR_CODEC_NO_PAD ? rest + 1 : 4);
+}
+
+bool str_append_base64(str* self, str_view v, unsigned flags) {
+    if (!self || (!v.data && v.len)) {
+        return false;
+    }
+
+    size_t len = str_base64_len(v.len, flags);
+
+    if (len == SIZE_MAX || !str_reserve_view(self, &v, len)) {
+        return false;
+    }
+
+    char const* alphabet = flags & STR_CODEC_URL ? BASE64_URL : BASE64;
+    enum str_simd level = simd(flags);
+    unsigned char const* in = (unsigned char const*) v.data;
+    char buf[CHUNK + SLACK];
+    size_t i = 0;
+    bool ok = true;
+
+    while (ok && v.len - i >= 3) {
+        size_t n = v.len - i < CHUNK / 4 * 3 ? v.len - i : CHUNK / 4 * 3;
+        size_t done = base64_encode(buf, in + i, n, v.len - i, alphabet,
+                level);
+
+        ok = str_append_view(self, (str_view) { buf, done / 3 * 4 });
+        i += done;
+    }
+
+    size_t rest = v.len - i;
+
+    if (ok && rest) {
+        uint32_t x = (uint32_t) in[i] << 16
+            | (rest == 2 ? (uint32_t) in[i + 1] << 8 : 0);
+
+        buf[0] = alphabet[x >> 18];
+        buf[1] = alphabet[x >> 12 & 63];
+        buf[2] = rest == 2 ? alphabet[x >> 6 & 63] : '=';
+        buf[3] = '=';
+
+        ok = str_append_view(self, (str_view) { buf,
+                flags & STR_CODEC_NO_PAD ? rest + 1 : 4 });
+    }
+
+    return ok;
+}
+
+bool str_decode_base64(str* self, str_view v, unsigned flags) {
+    if (!self || (!v.data && v.len)) {
+        return false;
+    }
+
+    bool lenient = flags & STR_CODEC_LENIENT;
+    size_t end = v.len;
+    size_t pad = 0;
+
+    /* strips the padding, and the white space around it */
+    while (end) {
+        char c = v.data[end - 1];
+
+        if (lenient && space((unsigned char) c)) {
+            end--;
+        } else if (c == '=' && pad < 2 && !(flags & STR_CODEC_NO_PAD)) {
+            pad++;
+            end--;
+        } else {
+            break;
+        }
+    }
+
+    /* exact unless white space is skipped */
+    if (!str_reserve_view(self, &v,
+                end / 4 * 3 + (end % 4 ? end % 4 - 1 : 0))) {
+        return false;
+    }
+
+    char const* alphabet = flags & STR_CODEC_URL ? BASE64_URL : BASE64;
+    enum str_simd level = simd(flags);
+    unsigned char table[UCHAR_MAX + 1];
+
+    memset(table, INVALID, sizeof table);
+
+    for (unsigned char k = 0; k < 64; ++k) {
+        table[(unsigned char) alphabet[k]] = k;
+    }
+
+    size_t len = str_len(self);
+    unsigned char buf[CHUNK + SLACK];
+    uint32_t acc = 0;
+    size_t quad = 0;
+
+    /* a piece of CHUNK characters decodes to at most 3 / 4 of CHUNK
+     * bytes, with the characters left over from the previous one */
+    for (size_t i = 0; i < end;) {
+        char const* in = v.data + i;
+        size_t n = end - i < CHUNK ? end - i : CHUNK;
+        size_t used = 0;
+
+        for (size_t k = 0; k < n;) {
+            if (!quad) {
+                size_t done = base64_decode_blocks(buf + used, in + k,
+                        n - k, alphabet, level);
+
+                k += done;
+                used += done / 4 * 3;
+
+                if (k == n) {
+                    break;
+                }
+            }
+
+            unsigned char c = (unsigned char) in[k++];
+
+            if (table[c] == INVALID) {
+                if (lenient && space(c)) {
+                    continue;
+                }
+
+                return str_rollback(self, len);
+            }
+
+            acc = acc << 6 | table[c];
+
+            if (++quad == 4) {
+                buf[used++] = (unsigned char) (acc >> 16);
+                buf[used++] = (unsigned char) (acc >> 8);
+                buf[used++] = (unsigned char) acc;
+                acc = 0;
+                quad = 0;
+            }
+        }
+
+        if (!str_append_view(self, (str_view) { (char*) buf, used })) {
+            return str_rollback(self, len);
+        }
+
+        i += n;
+    }
+
+    /* padding, if any, completes the last group */
+    if ((pad || !(flags & (STR_CODEC_NO_PAD | STR_CODEC_LENIENT)))
+            && (quad ? quad + pad != 4 : pad != 0)) {
+        return str_rollback(self, len);
+    }
+
+    /* a lone character doesn't make a byte, and strict decoding wants
+     * the bits past the last byte cleared */
+    if (quad == 1 || (!lenient && quad == 2 && (acc & 15))
+            || (!lenient && quad == 3 && (acc & 3))) {
+        return str_rollback(self, len);
+    }
+
+    if (quad == 2) {
+        buf[0] = (unsigned char) (acc >> 4);
+    } else if (quad == 3) {
+        buf[0] = (unsigned char) (acc >> 10);
+        buf[1] = (unsigned char) (acc >> 2);
+    }
+
+    if (quad && !str_append_view(self, (str_view) { (char*) buf,
+                quad - 1 })) {
+        return str_rollback(self, len);
+    }
+
+    return true;
+}
+
+bool str_append_hex(str* self, str_view v, unsigned flags) {
+    if (!self || (!v.data && v.len)) {
+        return false;
+    }
+
+    /* overflow */
+    if (v.len > SIZE_MAX / 2 || !str_reserve_view(self, &v, 2 * v.len)) {
+        return false;
+    }
+
+    char const* digits = flags & STR_CODEC_UPPER ? HEX_UPPER : HEX;
+    enum str_simd level = simd(flags);
+    unsigned char const* in = (unsigned char const*) v.data;
+    char buf[CHUNK + SLACK];
+    bool ok = true;
+
+    for (size_t i = 0; ok && i < v.len;) {
+        size_t n = v.len - i < CHUNK / 2 ? v.len - i : CHUNK / 2;
+
+        hex_encode(buf, in + i, n, digits, level);
+        ok = str_append_view(self, (str_view) { buf, 2 * n });
+        i += n;
+    }
+
+    return ok;
+}
+
+bool str_decode_hex(str* self, str_view v, unsigned flags) {
+    if (!self || (!v.data && v.len)) {
+        return false;
+    }
+
+    bool lenient = flags & STR_CODEC_LENIENT;
+
+    if ((!lenient && v.len % 2) || !str_reserve_view(self, &v, v.len / 2)) {
+        return false;
+    }
+
+    enum str_simd level = simd(flags);
+    size_t len = str_len(self);
+    unsigned char buf[CHUNK + SLACK];
+    unsigned acc = 0;
+    bool half = false;
+
+    for (size_t i = 0; i < v.len;) {
+        char const* in = v.data + i;
+        size_t n = v.len - i < CHUNK ? v.len - i : CHUNK;
+        size_t used = 0;
+
+        for (size_t k = 0; k < n;) {
+            if (!half) {
+                size_t done = hex_decode_blocks(buf + used, in + k, n - k,
+                        level);
+
+                k += done;
+                used += done / 2;
+
+                if (k == n) {
+                    break;
+                }
+            }
+
+            unsigned char c = (unsigned char) in[k++];
+            int x = str_hex_digit((char) c);
+
+            if (x < 0) {
+                if (lenient && space(c)) {
+                    continue;
+                }
+
+                return str_rollback(self, len);
+            }
+
+            if (half) {
+                buf[used++] = (unsigned char) (acc << 4 | x);
+            }
+
+            acc = x;
+            half = !half;
+        }
+
+        if (!str_append_view(self, (str_view) { (char*) buf, used })) {
+            return str_rollback(self, len);
+        }
+
+        i += n;
+    }
+
+    /* a digit without its pair */
+    if (half) {
+        return str_rollback(self, len);
+    }
+
+    return true;
+}
@@ -0,0 +1,103 @@
+/** str's Binary to Text Codecs
+ * @file str_codec.h
+ *
+ * Base64 (RFC 4648) and hex encoding and decoding, appending to str.
+ * On x86-64 blocks of input go through AVX2 or SSSE3 kernels when the
+ * cpu supports them, the rest through scalar code with the same
+ * results. */
+#ifndef STR_CODEC_H
+#define STR_CODEC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "str.h"
+
+/** Flags of the codecs, they combine with |. */
+typedef enum str_codec_flags {
+    STR_CODEC_DEFAULT = 0,
+    /** Base64 with - and _ instead of + and /, safe in URLs and
+     *  file names. */
+    STR_CODEC_URL = 1 << 0,
+    /** Base64 without the = padding, which decoding then rejects. */
+    STR_CODEC_NO_PAD = 1 << 1,
+    /** Decoding skips ASCII white space, takes base64 with or without
+     *  padding and ignores the unused bits of its last character. */
+    STR_CODEC_LENIENT = 1 << 2,
+    /** Hex with A-F instead of a-f. */
+    STR_CODEC_UPPER = 1 << 3,
+    /** Runs the scalar code only, for tests and benchmarks. */
+    STR_CODEC_SCALAR = 1 << 4,
+    /** Runs at most the SSSE3 kernels, for tests and benchmarks. */
+    STR_CODEC_SSSE3 = 1 << 5,
+} str_codec_flags;
+
+/** Returns length of the base64 encoding of n bytes.
+ * @param n     Number of bytes.
+ * @param flags A combination of str_codec_flags.
+ *
+ * @return      Number of characters, or SIZE_MAX on overflow. */
+size_t str_base64_len(size_t n, unsigned flags);
+
+/** Appends base64 encoding of bytes to str.
+ * @note       It reserves the exact length up front, so it allocates
+ *             at most once.
+ *
+ * @param self  A pointer to a str object.
+ * @param v     A view over the bytes.
+ * @param flags STR_CODEC_URL and STR_CODEC_NO_PAD select the variant.
+ *
+ * @return      true if successful.
+ *
+ * @see str_decode_base64 str_base64_len */
+bool str_append_base64(str* self, str_view v, unsigned flags);
+
+/** Decodes base64 and appends the bytes to str.
+ * @note       By default the input must be canonical, i.e. padded to a
+ *             multiple of four characters, without white space and
+ *             with the unused bits of the last character cleared.
+ *
+ * @param self  A pointer to a str object.
+ * @param v     A view over the base64 text.
+ * @param flags STR_CODEC_URL, STR_CODEC_NO_PAD and STR_CODEC_LENIENT
+ *              select the variant.
+ *
+ * @return      true if successful, false if the input is invalid, in
+ *              which case self is left unchanged.
+ *
+ * @see str_append_base64 */
+bool str_decode_base64(str* self, str_view v, unsigned flags);
+
+/** Appends hex encoding of bytes to str, two digits per byte.
+ * @param self  A pointer to a str object.
+ * @param v     A view over the bytes.
+ * @param flags STR_CODEC_UPPER selects upper case digits.
+ *
+ * @return      true if successful.
+ *
+ * @see str_decode_hex */
+bool str_append_hex(str* self, str_view v, unsigned flags);
+
+/** Decodes hex and appends the bytes to str.
+ * @note       Digits of either case are accepted.
+ *
+ * @param self  A pointer to a str object.
+ * @param v     A view over the hex text.
+ * @param flags STR_CODEC_LENIENT skips white space between digits.
+ *
+ * @return      true if successful, false if the input is invalid or
+ *              has an odd number of digits, in which case self is left
+ *              unchanged.
+ *
+ * @see str_append_hex */
+bool str_decode_hex(str* self, str_view v, unsigned flags);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* STR_CODEC_H */
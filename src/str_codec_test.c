@@ -0,0 +1,260 @@
+#include <assert.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cmocka.h>
+
+#include "str.h"
+#include "str_codec.h"
+
+/* every kernel selection, the last one being the best the cpu runs */
+static unsigned const levels[] = {
+    STR_CODEC_SCALAR,
+    STR_CODEC_SSSE3,
+    STR_CODEC_DEFAULT,
+};
+
+static void assert_base64(char const* in, char const* out, unsigned flags) {
+    str* s = str_from("prefix:");
+
+    assert_true(str_append_base64(s, str_view_of(in), flags));
+    assert_string_equal(str_cstr(s) + 7, out);
+    assert_int_equal(str_len(s) - 7, str_base64_len(strlen(in), flags));
+
+    str_clear(s);
+    assert_true(str_decode_base64(s, str_view_of(out), flags));
+    assert_string_equal(str_cstr(s), in);
+
+    str_del(s);
+}
+
+/* checks that decoding fails and leaves the str alone */
+static void assert_invalid(bool (*decode)(str*, str_view, unsigned),
+        char const* in, unsigned flags) {
+    str* s = str_from("kept");
+
+    assert_false(decode(s, str_view_of(in), flags));
+    assert_string_equal(str_cstr(s), "kept");
+
+    str_del(s);
+}
+
+static str* random_bytes(size_t n) {
+    str* s = str_new();
+
+    for (size_t i = 0; i < n; ++i) {
+        str_append_char(s, (char) rand());
+    }
+
+    return s;
+}
+
+/* returns a copy of v with a random character replaced by c */
+static char* corrupt(str_view v, char c) {
+    char* s = malloc(v.len + 1);
+
+    memcpy(s, v.data, v.len);
+    s[rand() % v.len] = c;
+    s[v.len] = 0;
+
+    return s;
+}
+
+static void str_base64_test(void** state) {
+    (void) state;
+
+    /* RFC 4648 */
+    assert_base64("", "", STR_CODEC_DEFAULT);
+    assert_base64("f", "Zg==", STR_CODEC_DEFAULT);
+    assert_base64("fo", "Zm8=", STR_CODEC_DEFAULT);
+    assert_base64("foo", "Zm9v", STR_CODEC_DEFAULT);
+    assert_base64("foob", "Zm9vYg==", STR_CODEC_DEFAULT);
+    assert_base64("fooba", "Zm9vYmE=", STR_CODEC_DEFAULT);
+    assert_base64("foobar", "Zm9vYmFy", STR_CODEC_DEFAULT);
+
+    assert_base64("fo", "Zm8", STR_CODEC_NO_PAD);
+    assert_base64("\xfb\xff\xbf", "+/+/", STR_CODEC_DEFAULT);
+    assert_base64("\xfb\xff\xbf", "-_-_", STR_CODEC_URL);
+    assert_base64("\xfb\xff", "-_8", STR_CODEC_URL | STR_CODEC_NO_PAD);
+}
+
+static void str_base64_decode_test(void** state) {
+    (void) state;
+
+    char const* invalid[] = {
+        "Zg=", "Zg", "Z===", "Zm9v=", "Zh==", "Zm9=", "Zm 9v", "Zm9v\n",
+        "Zm-v", "=Zm9", "Zm=v", "Z",
+    };
+
+    for (size_t i = 0; i < sizeof invalid / sizeof *invalid; ++i) {
+        assert_invalid(str_decode_base64, invalid[i], STR_CODEC_DEFAULT);
+    }
+
+    assert_invalid(str_decode_base64, "Zg==", STR_CODEC_NO_PAD);
+    assert_invalid(str_decode_base64, "Z", STR_CODEC_NO_PAD);
+    assert_invalid(str_decode_base64, "Zm+v", STR_CODEC_URL);
+    assert_invalid(str_decode_base64, "Zm9v=", STR_CODEC_LENIENT);
+    assert_invalid(str_decode_base64, "Zm9=v", STR_CODEC_LENIENT);
+
+    str* s = str_new();
+
+    assert_true(str_decode_base64(s, str_view_of(" Zm9v\r\nYmE\n= \n"),
+                STR_CODEC_LENIENT));
+    assert_string_equal(str_cstr(s), "fooba");
+
+    str_clear(s);
+    assert_true(str_decode_base64(s, str_view_of("Zh"), STR_CODEC_LENIENT));
+    assert_string_equal(str_cstr(s), "f");
+
+    str_del(s);
+}
+
+static void str_base64_random_test(void** state) {
+    (void) state;
+
+    srand(38);
+
+    for (int round = 0; round < 200; ++round) {
+        str* in = random_bytes((size_t) rand() % (round < 150 ? 200 : 20000));
+        str_view v = str_view_of(in);
+        unsigned variant = (unsigned) rand() % 4;
+        str* expected = (void*) 0;
+
+        for (size_t l = 0; l < sizeof levels / sizeof *levels; ++l) {
+            unsigned flags = variant | levels[l];
+            str* out = str_new();
+            str* back = str_new();
+
+            assert_true(str_append_base64(out, v, flags));
+            assert_true(str_decode_base64(back, str_view_of(out), flags));
+            assert_true(str_equal(back, in));
+
+            if (expected) {
+                assert_true(str_equal(out, expected));
+                str_del(out);
+            } else {
+                expected = out;
+            }
+
+            /* line breaks every 76 characters as in MIME */
+            str* wrapped = str_new();
+            str_view e = str_view_of(expected);
+
+            for (size_t i = 0; i < e.len; i += 76) {
+                str_append_view(wrapped, (str_view) { e.data + i,
+                        e.len - i < 76 ? e.len - i : 76 });
+                str_append_view(wrapped, str_view_of("\r\n"));
+            }
+
+            str_clear(back);
+            assert_true(str_decode_base64(back, str_view_of(wrapped),
+                        flags | STR_CODEC_LENIENT));
+            assert_true(str_equal(back, in));
+
+            /* a bad character anywhere is caught */
+            if (e.len) {
+                char* bad = corrupt(e, '*');
+
+                assert_invalid(str_decode_base64, bad, flags);
+                free(bad);
+            }
+
+            str_del(wrapped);
+            str_del(back);
+        }
+
+        str_del(expected);
+        str_del(in);
+    }
+}
+
+static void str_hex_test(void** state) {
+    (void) state;
+
+    str* s = str_new();
+
+    assert_true(str_append_hex(s, str_view_of("\x01\xab\xff"),
+                STR_CODEC_DEFAULT));
+    assert_true(str_append_hex(s, str_view_of("\x01\xab\xff"),
+                STR_CODEC_UPPER));
+    assert_string_equal(str_cstr(s), "01abff01ABFF");
+
+    str_clear(s);
+    assert_true(str_decode_hex(s, str_view_of("4a4B"), STR_CODEC_DEFAULT));
+    assert_true(str_decode_hex(s, str_view_of(" 4 a\n4b "),
+                STR_CODEC_LENIENT));
+    assert_string_equal(str_cstr(s), "JKJK");
+
+    assert_invalid(str_decode_hex, "abc", STR_CODEC_DEFAULT);
+    assert_invalid(str_decode_hex, "ab c", STR_CODEC_LENIENT);
+    assert_invalid(str_decode_hex, "ag", STR_CODEC_DEFAULT);
+    assert_invalid(str_decode_hex, "a b", STR_CODEC_DEFAULT);
+
+    /* a view into the str itself */
+    str_clear(s);
+    str_append_cstr(s, "hi");
+    assert_true(str_append_hex(s, str_view_of(s), STR_CODEC_DEFAULT));
+    assert_string_equal(str_cstr(s), "hi6869");
+    assert_true(str_decode_hex(s, (str_view) { str_cstr(s) + 2, 4 },
+                STR_CODEC_DEFAULT));
+    assert_string_equal(str_cstr(s), "hi6869hi");
+
+    str_del(s);
+
+    srand(16);
+
+    for (int round = 0; round < 100; ++round) {
+        str* in = random_bytes((size_t) rand() % 10000);
+        str* expected = (void*) 0;
+
+        for (size_t l = 0; l < sizeof levels / sizeof *levels; ++l) {
+            unsigned flags = levels[l] | (round % 2 ? STR_CODEC_UPPER : 0);
+            str* out = str_new();
+            str* back = str_new();
+
+            assert_true(str_append_hex(out, str_view_of(in), flags));
+            assert_true(str_decode_hex(back, str_view_of(out), flags));
+            assert_true(str_equal(back, in));
+
+            if (expected) {
+                assert_true(str_equal(out, expected));
+                str_del(out);
+            } else {
+                expected = out;
+            }
+
+            str_del(back);
+        }
+
+        /* bad digits in the middle of the kernels' blocks */
+        if (str_len(expected)) {
+            char* bad = corrupt(str_view_of(expected), 'g');
+
+            for (size_t l = 0; l < sizeof levels / sizeof *levels; ++l) {
+                assert_invalid(str_decode_hex, bad, levels[l]);
+            }
+
+            free(bad);
+        }
+
+        str_del(expected);
+        str_del(in);
+    }
+}
+
+
+int main(void) {
+    struct CMUnitTest const tests[] = {
+        cmocka_unit_test(str_base64_test),
+        cmocka_unit_test(str_base64_decode_test),
+        cmocka_unit_test(str_base64_random_test),
+        cmocka_unit_test(str_hex_test),
+    };
+
+
+    return cmocka_run_group_tests(tests, (void*) 0, (void*) 0);
+}
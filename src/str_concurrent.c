@@ -0,0 +1,158 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sched.h>
+
+#include "str_concurrent.h"
+
+/* reservations at or past this mean the buffer was swapped out, it
+ * leaves room for producers adding to it before they notice */
+#define CLOSED (SIZE_MAX / 2)
+
+/* keeps the counters producers hammer on their own cache lines */
+#define CACHE_LINE 64
+
+struct half {
+    char* data;
+
+    /* bytes handed out, including any past capacity */
+    _Atomic size_t reserved;
+    char pad_reserved[CACHE_LINE - sizeof (size_t)];
+
+    /* bytes of [0, capacity) whose producers are done, either copied
+     * or given up on */
+    _Atomic size_t committed;
+
+    /* end of the records, less than capacity if a record didn't fit */
+    _Atomic size_t end;
+    char pad_committed[CACHE_LINE - 2 * sizeof (size_t)];
+};
+
+struct str_concurrent_buffer {
+    size_t capacity;
+    _Atomic unsigned active;
+    char pad[CACHE_LINE];
+    struct half halves[2];
+};
+
+/* -- Private Interface -- */
+
+static void reset(struct half* half, size_t capacity) {
+    atomic_store(&half->committed, 0);
+    atomic_store(&half->end, capacity);
+    atomic_store(&half->reserved, 0);
+}
+
+/* -- Public Interface Implementation -- */
+
+str_concurrent_buffer* str_concurrent_buffer_new(size_t capacity) {
+    if (!capacity || capacity >= CLOSED) {
+        return (void*) 0;
+    }
+
+    str_concurrent_buffer* self = malloc(sizeof (str_concurrent_buffer));
+
+    if (!self) {
+        return (void*) 0;
+    }
+
+    self->capacity = capacity;
+    atomic_init(&self->active, 0);
+
+    for (int i = 0; i < 2; ++i) {
+        self->halves[i].data = malloc(capacity);
+        atomic_init(&self->halves[i].reserved, i ? CLOSED : 0);
+        atomic_init(&self->halves[i].committed, 0);
+        atomic_init(&self->halves[i].end, capacity);
+    }
+
+    if (!self->halves[0].data || !self->halves[1].data) {
+        str_concurrent_buffer_del(self);
+        return (void*) 0;
+    }
+
+    return self;
+}
+
+void str_concurrent_buffer_del(str_concurrent_buffer* self) {
+    if (!self) {
+        return;
+    }
+
+    free(self->halves[0].data);
+    free(self->halves[1].data);
+    free(self);
+}
+
+bool str_concurrent_buffer_append(str_concurrent_buffer* self, str_view v) {
+    if (!self || (!v.data && v.len) || v.len > self->capacity) {
+        return false;
+    }
+
+    size_t capacity = self->capacity;
+
+    for (;;) {
+        struct half* half = &self->halves[atomic_load(&self->active)];
+        size_t offset = atomic_fetch_add(&half->reserved, v.len);
+
+        /* swapped out in between, the other half is active by now */
+        if (offset >= CLOSED) {
+            continue;
+        }
+
+        if (offset >= capacity) {
+            return false;
+        }
+
+        if (capacity - offset < v.len) {
+            /* the first record not fitting ends the buffer, the others
+             * start past capacity */
+            atomic_store(&half->end, offset);
+            atomic_fetch_add_explicit(&half->committed, capacity - offset,
+                    memory_order_release);
+            return false;
+        }
+
+        if (v.len) {
+            memcpy(half->data + offset, v.data, v.len);
+        }
+
+        atomic_fetch_add_explicit(&half->committed, v.len,
+                memory_order_release);
+
+        return true;
+    }
+}
+
+str_view str_concurrent_buffer_swap(str_concurrent_buffer* self) {
+    if (!self) {
+        return (str_view) { (void*) 0, 0 };
+    }
+
+    unsigned old = atomic_load(&self->active);
+    struct half* half = &self->halves[old];
+
+    /* opens the other half before closing this one, so producers
+     * turned away always find an open one */
+    reset(&self->halves[!old], self->capacity);
+    atomic_store(&self->active, !old);
+
+    size_t reserved = atomic_exchange(&half->reserved, CLOSED);
+    size_t used = reserved < self->capacity ? reserved : self->capacity;
+
+    /* waits for the copies in flight */
+    while (atomic_load_explicit(&half->committed, memory_order_acquire)
+            != used) {
+        sched_yield();
+    }
+
+    if (reserved > self->capacity) {
+        used = atomic_load(&half->end);
+    }
+
+    return (str_view) { half->data, used };
+}
@@ -0,0 +1,81 @@
+/** str's Concurrent Append Buffer
+ * @file str_concurrent.h
+ *
+ * A buffer many threads append to without locking, emptied by a single
+ * consumer. Producers reserve space with an atomic add and copy their
+ * record into it, so they only contend on that add. The consumer swaps
+ * between two buffers: while it reads one, producers fill the other. */
+#ifndef STR_CONCURRENT_H
+#define STR_CONCURRENT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "str.h"
+
+/** Opaque str_concurrent_buffer Structure */
+typedef struct str_concurrent_buffer str_concurrent_buffer;
+
+/** Creates concurrent buffer.
+ * @warning    The user has to free the object after usage with
+ *             str_concurrent_buffer_del.
+ *
+ * @note       It allocates two buffers of capacity bytes up front and
+ *             never grows them.
+ *
+ * @param capacity Size of each of the two buffers.
+ *
+ * @return     A pointer to a str_concurrent_buffer object, or null if
+ *             capacity is 0 or allocating failed.
+ *
+ * @see str_concurrent_buffer_del */
+str_concurrent_buffer* str_concurrent_buffer_new(size_t capacity);
+
+/** Deletes concurrent buffer.
+ * @warning    No thread may use it any more.
+ *
+ * @param self A pointer to a str_concurrent_buffer object. */
+void str_concurrent_buffer_del(str_concurrent_buffer* self);
+
+/** Appends record to the buffer.
+ * @note       Safe to call from any number of threads at once, and
+ *             concurrently with str_concurrent_buffer_swap. A record is
+ *             copied whole, records of different threads don't
+ *             interleave.
+ *
+ * @note       It never blocks. When the buffer is full it fails, and
+ *             the caller may retry once the consumer swapped.
+ *
+ * @param self A pointer to a str_concurrent_buffer object.
+ * @param v    A view over the record.
+ *
+ * @return     true if successful, false if the record doesn't fit in
+ *             what is left of the buffer or is longer than its
+ *             capacity.
+ *
+ * @see str_concurrent_buffer_swap */
+bool str_concurrent_buffer_append(str_concurrent_buffer* self, str_view v);
+
+/** Swaps the buffers and returns what was appended to the old one.
+ * @warning    Only one thread may call it at a time.
+ *
+ * @note       New appends go to the other buffer right away, it only
+ *             waits for appends already copying into the old one.
+ *
+ * @note       The view stays valid until the next swap, which reuses
+ *             the memory.
+ *
+ * @param self A pointer to a str_concurrent_buffer object.
+ *
+ * @return     A view over the records appended since the last swap. */
+str_view str_concurrent_buffer_swap(str_concurrent_buffer* self);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* STR_CONCURRENT_H */
@@ -0,0 +1,169 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "str.h"
+#include "str_concurrent.h"
+
+/* Scaling benchmark of str_concurrent_buffer against a str behind a
+ * mutex, producers appending 61 byte records while one consumer
+ * drains them.
+ *
+ * Usage: str_concurrent_bench [records per thread] [max threads] */
+
+#define CAPACITY (1 << 20)
+
+static char const record[] =
+    "2024-01-01T00:00:00Z INFO worker finished request in 12ms ok\n";
+
+struct run {
+    bool locked;
+    size_t records;
+
+    str_concurrent_buffer* buffer;
+
+    pthread_mutex_t lock;
+    str* current;
+
+    atomic_size_t running;
+};
+
+static double now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+static void* producer(void* arg) {
+    struct run* run = arg;
+    str_view v = { record, sizeof record - 1 };
+
+    for (size_t i = 0; i < run->records; ++i) {
+        if (run->locked) {
+            pthread_mutex_lock(&run->lock);
+            str_append_view(run->current, v);
+            pthread_mutex_unlock(&run->lock);
+            continue;
+        }
+
+        while (!str_concurrent_buffer_append(run->buffer, v)) {
+            sched_yield();
+        }
+    }
+
+    atomic_fetch_sub(&run->running, 1);
+
+    return (void*) 0;
+}
+
+/* drains until the producers are done, returns bytes drained */
+static size_t consume(struct run* run) {
+    str* spare = str_new();
+    size_t total = 0;
+    bool done = false;
+
+    str_reserve(spare, CAPACITY);
+
+    while (!done) {
+        done = atomic_load(&run->running) == 0;
+
+        if (run->locked) {
+            pthread_mutex_lock(&run->lock);
+            str* full = run->current;
+            run->current = spare;
+            pthread_mutex_unlock(&run->lock);
+
+            total += str_len(full);
+            str_truncate(full, 0);
+            spare = full;
+        } else {
+            total += str_concurrent_buffer_swap(run->buffer).len;
+        }
+
+        sched_yield();
+    }
+
+    str_del(spare);
+
+    return total;
+}
+
+static double measure(bool locked, size_t threads, size_t records) {
+    struct run run = { .locked = locked, .records = records };
+    pthread_t* ids = malloc(threads * sizeof *ids);
+
+    run.buffer = str_concurrent_buffer_new(CAPACITY);
+    run.current = str_new();
+    pthread_mutex_init(&run.lock, (void*) 0);
+    atomic_init(&run.running, threads);
+
+    if (!ids || !run.buffer || !run.current
+            || !str_reserve(run.current, CAPACITY)) {
+        fprintf(stderr, "str_concurrent_bench: out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    double start = now();
+
+    for (size_t i = 0; i < threads; ++i) {
+        pthread_create(&ids[i], (void*) 0, producer, &run);
+    }
+
+    size_t total = consume(&run);
+
+    for (size_t i = 0; i < threads; ++i) {
+        pthread_join(ids[i], (void*) 0);
+    }
+
+    double elapsed = now() - start;
+
+    if (total != threads * records * (sizeof record - 1)) {
+        fprintf(stderr, "str_concurrent_bench: lost records\n");
+        exit(EXIT_FAILURE);
+    }
+
+    pthread_mutex_destroy(&run.lock);
+    str_del(run.current);
+    str_concurrent_buffer_del(run.buffer);
+    free(ids);
+
+    return elapsed;
+}
+
+int main(int argc, char const** argv) {
+    size_t records = argc > 1 ? strtoul(argv[1], (void*) 0, 10) : 200000;
+    size_t max_threads = argc > 2 ? strtoul(argv[2], (void*) 0, 10) : 64;
+
+    printf("threads,buffer_mrec_per_s,mutex_mrec_per_s,ratio\n");
+
+    for (size_t threads = 1; threads <= max_threads;
+            threads = threads * 2 > max_threads ? max_threads : threads * 2) {
+        double n = (double) (threads * records) / 1e6;
+        double buffer = 1e30;
+        double mutex = 1e30;
+
+        for (int round = 0; round < 3; ++round) {
+            double b = measure(false, threads, records);
+            double m = measure(true, threads, records);
+
+            buffer = b < buffer ? b : buffer;
+            mutex = m < mutex ? m : mutex;
+        }
+
+        printf("%zu,%.2f,%.2f,%.2f\n", threads, n / buffer, n / mutex,
+                mutex / buffer);
+
+        if (threads == max_threads) {
+            break;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
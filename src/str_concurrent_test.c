@@ -0,0 +1,140 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cmocka.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "str.h"
+#include "str_concurrent.h"
+
+enum { PRODUCERS = 8, RECORDS = 20000, RECORD = 16 };
+
+static void str_concurrent_buffer_test(void** state) {
+    (void) state;
+
+    assert_null(str_concurrent_buffer_new(0));
+
+    str_concurrent_buffer* b = str_concurrent_buffer_new(8);
+    str_view v = str_concurrent_buffer_swap(b);
+
+    assert_int_equal(v.len, 0);
+
+    assert_true(str_concurrent_buffer_append(b, str_view_of("abc")));
+    assert_true(str_concurrent_buffer_append(b, str_view_of("")));
+    assert_true(str_concurrent_buffer_append(b, str_view_of("de")));
+    /* doesn't fit, nor does anything after it */
+    assert_false(str_concurrent_buffer_append(b, str_view_of("fghi")));
+    assert_false(str_concurrent_buffer_append(b, str_view_of("f")));
+
+    v = str_concurrent_buffer_swap(b);
+    assert_int_equal(v.len, 5);
+    assert_memory_equal(v.data, "abcde", 5);
+
+    /* exactly full */
+    assert_true(str_concurrent_buffer_append(b, str_view_of("12345678")));
+    assert_false(str_concurrent_buffer_append(b, str_view_of("9")));
+    assert_false(str_concurrent_buffer_append(b, str_view_of("123456789")));
+
+    v = str_concurrent_buffer_swap(b);
+    assert_int_equal(v.len, 8);
+    assert_memory_equal(v.data, "12345678", 8);
+
+    v = str_concurrent_buffer_swap(b);
+    assert_int_equal(v.len, 0);
+
+    str_concurrent_buffer_del(b);
+}
+
+struct shared {
+    str_concurrent_buffer* buffer;
+    atomic_int running;
+};
+
+static void* producer(void* arg) {
+    struct shared* shared = arg;
+    static atomic_int ids;
+    int id = atomic_fetch_add(&ids, 1) % PRODUCERS;
+
+    for (int i = 0; i < RECORDS; ++i) {
+        char record[RECORD + 1];
+
+        snprintf(record, sizeof record, "%02d:%012d\n", id, i);
+
+        while (!str_concurrent_buffer_append(shared->buffer,
+                    (str_view) { record, RECORD })) {
+            sched_yield();
+        }
+    }
+
+    atomic_fetch_sub(&shared->running, 1);
+
+    return (void*) 0;
+}
+
+static void str_concurrent_buffer_threads_test(void** state) {
+    (void) state;
+
+    /* small, so producers often find it full */
+    struct shared shared = { str_concurrent_buffer_new(40 * RECORD + 5),
+        PRODUCERS };
+    pthread_t threads[PRODUCERS];
+    str* out = str_new();
+
+    assert_non_null(shared.buffer);
+
+    for (int i = 0; i < PRODUCERS; ++i) {
+        pthread_create(&threads[i], (void*) 0, producer, &shared);
+    }
+
+    bool done = false;
+
+    while (!done) {
+        done = atomic_load(&shared.running) == 0;
+        str_append_view(out, str_concurrent_buffer_swap(shared.buffer));
+    }
+
+    for (int i = 0; i < PRODUCERS; ++i) {
+        pthread_join(threads[i], (void*) 0);
+    }
+
+    str_append_view(out, str_concurrent_buffer_swap(shared.buffer));
+
+    /* every record whole, once, and in order within its thread */
+    int next[PRODUCERS] = { 0 };
+    char const* data = str_cstr(out);
+
+    assert_int_equal(str_len(out), (size_t) PRODUCERS * RECORDS * RECORD);
+
+    for (size_t i = 0; i < str_len(out); i += RECORD) {
+        int id;
+        int seq;
+
+        assert_int_equal(sscanf(data + i, "%2d:%12d", &id, &seq), 2);
+        assert_int_equal(data[i + RECORD - 1], '\n');
+        assert_true(id >= 0 && id < PRODUCERS);
+        assert_int_equal(seq, next[id]++);
+    }
+
+    str_del(out);
+    str_concurrent_buffer_del(shared.buffer);
+}
+
+
+int main(void) {
+    struct CMUnitTest const tests[] = {
+        cmocka_unit_test(str_concurrent_buffer_test),
+        cmocka_unit_test(str_concurrent_buffer_threads_test),
+    };
+
+
+    return cmocka_run_group_tests(tests, (void*) 0, (void*) 0);
+}
@@ -0,0 +1,216 @@
+#include <assert.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "str_edit.h"
+
+#define WORD_BITS 64
+#define HIGH_BIT ((uint64_t) 1 << (WORD_BITS - 1))
+#define ALPHABET (UCHAR_MAX + 1)
+
+struct pattern {
+    str_view v;
+    size_t blocks;
+    /* peq[c * blocks + b] has bit i set if character 64 * b + i
+     * of the pattern is c */
+    uint64_t* peq;
+    /* vertical deltas of the current column, +1 and -1 bits */
+    uint64_t* pv;
+    uint64_t* mv;
+    /* storage of a single block pattern, which is the common case */
+    uint64_t local[ALPHABET + 2];
+};
+
+/* -- Private Interface -- */
+
+static void release(struct pattern* p) {
+    assert(p != (void*) 0);
+
+    if (p->peq != p->local) {
+        free(p->peq);
+    }
+}
+
+static bool compile(struct pattern* p, str_view v) {
+    assert(p != (void*) 0);
+
+    p->v = v;
+    p->blocks = (v.len + WORD_BITS - 1) / WORD_BITS;
+
+    if (!p->blocks) {
+        p->blocks = 1;
+    }
+
+    size_t words = (ALPHABET + 2) * p->blocks;
+
+    if (p->blocks == 1) {
+        p->peq = p->local;
+    } else if (p->blocks > SIZE_MAX / sizeof (uint64_t) / (ALPHABET + 2)) {
+        return false;
+    } else {
+        p->peq = malloc(words * sizeof (uint64_t));
+
+        if (!p->peq) {
+            return false;
+        }
+    }
+
+    memset(p->peq, 0, ALPHABET * p->blocks * sizeof (uint64_t));
+
+    p->pv = p->peq + ALPHABET * p->blocks;
+    p->mv = p->pv + p->blocks;
+
+    for (size_t i = 0; i < v.len; ++i) {
+        unsigned char c = (unsigned char) v.data[i];
+
+        p->peq[c * p->blocks + i / WORD_BITS] |=
+            (uint64_t) 1 << (i % WORD_BITS);
+    }
+
+    return true;
+}
+
+/* advances one block of the column by a text character, hin is the
+ * horizontal delta entering at its top row, and the one leaving at
+ * the row of the last bit is returned, see Hyyrö, A Bit-Vector
+ * Algorithm for Computing Levenshtein and Damerau Edit Distances */
+static int advance(uint64_t* pv, uint64_t* mv, uint64_t eq, int hin,
+        uint64_t last) {
+    uint64_t xv = eq | *mv;
+
+    if (hin < 0) {
+        eq |= 1;
+    }
+
+    uint64_t xh = (((eq & *pv) + *pv) ^ *pv) | eq;
+    uint64_t ph = *mv | ~(xh | *pv);
+    uint64_t mh = *pv & xh;
+
+    int hout = (ph & last) ? 1 : (mh & last) ? -1 : 0;
+
+    ph <<= 1;
+    mh <<= 1;
+
+    if (hin < 0) {
+        mh |= 1;
+    } else if (hin > 0) {
+        ph |= 1;
+    }
+
+    *pv = mh | ~(xv | ph);
+    *mv = ph & xv;
+
+    return hout;
+}
+
+static size_t distance(struct pattern* p, str_view text, size_t k) {
+    assert(p != (void*) 0);
+
+    size_t m = p->v.len;
+    size_t n = text.len;
+
+    if (!m || !n) {
+        size_t d = m + n;
+        return d > k ? k + 1 : d;
+    }
+
+    /* every column changes the last row by at most one */
+    if ((m > n ? m - n : n - m) > k) {
+        return k + 1;
+    }
+
+    size_t blocks = p->blocks;
+    uint64_t last = (uint64_t) 1 << ((m - 1) % WORD_BITS);
+
+    for (size_t b = 0; b < blocks; ++b) {
+        p->pv[b] = ~(uint64_t) 0;
+        p->mv[b] = 0;
+    }
+
+    size_t score = m;
+
+    for (size_t j = 0; j < n; ++j) {
+        uint64_t const* eq = p->peq
+            + (unsigned char) text.data[j] * blocks;
+
+        /* the top row is j, so it always grows by one */
+        int h = 1;
+
+        for (size_t b = 0; b + 1 < blocks; ++b) {
+            h = advance(&p->pv[b], &p->mv[b], eq[b], h, HIGH_BIT);
+        }
+
+        h = advance(&p->pv[blocks - 1], &p->mv[blocks - 1],
+                eq[blocks - 1], h, last);
+
+        score = h < 0 ? score - 1 : score + (size_t) h;
+
+        /* the remaining columns can lower it by one each at best */
+        size_t left = n - j - 1;
+
+        if (score > left && score - left > k) {
+            return k + 1;
+        }
+    }
+
+    return score > k ? k + 1 : score;
+}
+
+/* -- Public Interface Implementation -- */
+
+size_t str_edit_distance(str_view a, str_view b) {
+    return str_edit_distance_max(a, b, SIZE_MAX);
+}
+
+size_t str_edit_distance_max(str_view a, str_view b, size_t k) {
+    /* distances never reach SIZE_MAX, so k + 1 can't overflow */
+    if (k == SIZE_MAX) {
+        k = SIZE_MAX - 1;
+    }
+
+    /* the shorter string takes fewer blocks as the pattern */
+    if (a.len > b.len) {
+        str_view t = a;
+        a = b;
+        b = t;
+    }
+
+    struct pattern p;
+
+    if (!compile(&p, a)) {
+        return k + 1;
+    }
+
+    size_t d = distance(&p, b, k);
+
+    release(&p);
+
+    return d;
+}
+
+bool str_edit_distance_batch(str_view pattern, str_view const* candidates,
+        size_t n, size_t k, size_t* distances) {
+    if ((!candidates || !distances) && n) {
+        return false;
+    }
+
+    struct pattern p;
+
+    if (!compile(&p, pattern)) {
+        return false;
+    }
+
+    if (k == SIZE_MAX) {
+        k = SIZE_MAX - 1;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        distances[i] = distance(&p, candidates[i], k);
+    }
+
+    release(&p);
+
+    return true;
+}
@@ -0,0 +1,66 @@
+/** str's Edit Distance
+ * @file str_edit.h */
+#ifndef STR_EDIT_H
+#define STR_EDIT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "str.h"
+
+/** Computes Levenshtein distance.
+ * @note       It uses Myers' bit-parallel algorithm, 64 rows of the
+ *             dynamic programming matrix per machine word, with as many
+ *             words as the shorter string needs.
+ *
+ * @param a    A view.
+ * @param b    A view.
+ *
+ * @return     Number of insertions, deletions and substitutions
+ *             turning a into b, or SIZE_MAX if memory runs out.
+ *
+ * @see str_edit_distance_max str_edit_distance_batch */
+size_t str_edit_distance(str_view a, str_view b);
+
+/** Computes Levenshtein distance up to a bound.
+ * @note       It stops as soon as the distance is known to exceed k,
+ *             which is faster for dissimilar strings. A k of SIZE_MAX
+ *             gives the exact distance.
+ *
+ * @param a    A view.
+ * @param b    A view.
+ * @param k    Largest distance of interest.
+ *
+ * @return     The distance if it is at most k, otherwise k + 1,
+ *             which is also returned if memory runs out.
+ *
+ * @see str_edit_distance */
+size_t str_edit_distance_max(str_view a, str_view b, size_t k);
+
+/** Computes Levenshtein distances from one pattern to many candidates.
+ * @note       The pattern is preprocessed once for all candidates.
+ *
+ * @note       Distances above k are reported as k + 1, pass SIZE_MAX
+ *             for exact distances.
+ *
+ * @param pattern    A view.
+ * @param candidates A pointer to an array of views.
+ * @param n          Number of candidates.
+ * @param k          Largest distance of interest.
+ * @param distances  A pointer to an array receiving n distances.
+ *
+ * @return           true if successful.
+ *
+ * @see str_edit_distance_max */
+bool str_edit_distance_batch(str_view pattern, str_view const* candidates,
+        size_t n, size_t k, size_t* distances);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* STR_EDIT_H */
@@ -0,0 +1,160 @@
+#include <assert.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cmocka.h>
+
+#include "str.h"
+#include "str_edit.h"
+
+static size_t naive_distance(str_view a, str_view b) {
+    size_t* row = malloc((b.len + 1) * sizeof (size_t));
+
+    for (size_t j = 0; j <= b.len; ++j) {
+        row[j] = j;
+    }
+
+    for (size_t i = 1; i <= a.len; ++i) {
+        size_t diag = row[0];
+
+        row[0] = i;
+
+        for (size_t j = 1; j <= b.len; ++j) {
+            size_t up = row[j];
+            size_t best = diag + (a.data[i - 1] != b.data[j - 1]);
+
+            best = up + 1 < best ? up + 1 : best;
+            best = row[j - 1] + 1 < best ? row[j - 1] + 1 : best;
+
+            row[j] = best;
+            diag = up;
+        }
+    }
+
+    size_t d = row[b.len];
+
+    free(row);
+
+    return d;
+}
+
+static str* random_str(size_t max) {
+    size_t len = (size_t) rand() % (max + 1);
+    str* s = str_new();
+
+    for (size_t i = 0; i < len; ++i) {
+        str_append_char(s, "abc\xff"[rand() % 4]);
+    }
+
+    return s;
+}
+
+static void str_edit_distance_test(void** state) {
+    (void) state;
+
+    assert_int_equal(str_edit_distance(str_view_of("kitten"),
+                str_view_of("sitting")), 3);
+    assert_int_equal(str_edit_distance(str_view_of("flaw"),
+                str_view_of("lawn")), 2);
+    assert_int_equal(str_edit_distance(str_view_of(""),
+                str_view_of("abc")), 3);
+    assert_int_equal(str_edit_distance(str_view_of("abc"),
+                str_view_of("")), 3);
+    assert_int_equal(str_edit_distance(str_view_of("same"),
+                str_view_of("same")), 0);
+}
+
+static void str_edit_distance_random_test(void** state) {
+    (void) state;
+
+    srand(36);
+
+    /* up to three blocks */
+    for (int round = 0; round < 300; ++round) {
+        str* a = random_str(round % 3 ? 60 : 180);
+        str* b = random_str(round % 3 ? 60 : 180);
+        str_view va = str_view_of(a);
+        str_view vb = str_view_of(b);
+
+        assert_int_equal(str_edit_distance(va, vb), naive_distance(va, vb));
+
+        str_del(a);
+        str_del(b);
+    }
+}
+
+static void str_edit_distance_max_test(void** state) {
+    (void) state;
+
+    srand(7);
+
+    for (int round = 0; round < 300; ++round) {
+        str* a = random_str(100);
+        str* b = random_str(100);
+        str_view va = str_view_of(a);
+        str_view vb = str_view_of(b);
+        size_t d = naive_distance(va, vb);
+        size_t k = (size_t) rand() % 80;
+
+        assert_int_equal(str_edit_distance_max(va, vb, k), d > k ? k + 1 : d);
+
+        str_del(a);
+        str_del(b);
+    }
+
+    assert_int_equal(str_edit_distance_max(str_view_of("kitten"),
+                str_view_of("sitting"), SIZE_MAX), 3);
+    assert_int_equal(str_edit_distance_max(str_view_of("kitten"),
+                str_view_of("sitting"), 0), 1);
+}
+
+static void str_edit_distance_batch_test(void** state) {
+    (void) state;
+
+    str_view const candidates[] = {
+        str_view_of("apple"),
+        str_view_of("apply"),
+        str_view_of("ample"),
+        str_view_of("maple syrup"),
+        str_view_of(""),
+    };
+    size_t distances[5];
+
+    assert_true(str_edit_distance_batch(str_view_of("apple"), candidates, 5,
+                SIZE_MAX, distances));
+
+    for (size_t i = 0; i < 5; ++i) {
+        assert_int_equal(distances[i],
+                naive_distance(str_view_of("apple"), candidates[i]));
+    }
+
+    assert_true(str_edit_distance_batch(str_view_of("apple"), candidates, 5,
+                1, distances));
+    assert_int_equal(distances[0], 0);
+    assert_int_equal(distances[1], 1);
+    assert_int_equal(distances[2], 1);
+    assert_int_equal(distances[3], 2);
+    assert_int_equal(distances[4], 2);
+
+    assert_true(str_edit_distance_batch(str_view_of("x"), (void*) 0, 0, 0,
+                (void*) 0));
+    assert_false(str_edit_distance_batch(str_view_of("x"), (void*) 0, 1, 0,
+                distances));
+}
+
+
+int main(void) {
+    struct CMUnitTest const tests[] = {
+        cmocka_unit_test(str_edit_distance_test),
+        cmocka_unit_test(str_edit_distance_random_test),
+        cmocka_unit_test(str_edit_distance_max_test),
+        cmocka_unit_test(str_edit_distance_batch_test),
+    };
+
+
+    return cmocka_run_group_tests(tests, (void*) 0, (void*) 0);
+}
@@ -0,0 +1,531 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "str_escape.h"
+#include "str_private.h"
+#include "str_simd.h"
+
+/* bytes a format escapes, controls adds those below 0x20 */
+struct special {
+    char bytes[5];
+    size_t n;
+    bool controls;
+};
+
+static struct special const JSON = { { '"', '\\' }, 2, true };
+static struct special const CSV = { { ',', '"', '\r', '\n' }, 4, false };
+static struct special const HTML = { { '&', '<', '>', '"', '\'' }, 5, false };
+
+/* -- Private Interface -- */
+
+static bool is_special(struct special const* sp, unsigned char c) {
+    if (sp->controls && c < 0x20) {
+        return true;
+    }
+
+    for (size_t i = 0; i < sp->n; ++i) {
+        if (c == (unsigned char) sp->bytes[i]) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+#ifdef STR_SIMD_X86
+
+/* SSE2 is part of x86-64, so the 16 byte blocks need no check */
+static unsigned mask_sse2(char const* s, struct special const* sp) {
+    __m128i v = _mm_loadu_si128((__m128i const*) s);
+    __m128i hit = _mm_setzero_si128();
+
+    if (sp->controls) {
+        __m128i top = _mm_set1_epi8(0x1f);
+
+        hit = _mm_cmpeq_epi8(_mm_max_epu8(v, top), top);
+    }
+
+    for (size_t i = 0; i < sp->n; ++i) {
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v,
+                    _mm_set1_epi8(sp->bytes[i])));
+    }
+
+    return (unsigned) _mm_movemask_epi8(hit);
+}
+
+STR_SIMD_TARGET("avx2")
+static unsigned mask_avx2(char const* s, struct special const* sp) {
+    __m256i v = _mm256_loadu_si256((__m256i const*) s);
+    __m256i hit = _mm256_setzero_si256();
+
+    if (sp->controls) {
+        __m256i top = _mm256_set1_epi8(0x1f);
+
+        hit = _mm256_cmpeq_epi8(_mm256_max_epu8(v, top), top);
+    }
+
+    for (size_t i = 0; i < sp->n; ++i) {
+        hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(v,
+                    _mm256_set1_epi8(sp->bytes[i])));
+    }
+
+    return (unsigned) _mm256_movemask_epi8(hit);
+}
+
+#endif /* STR_SIMD_X86 */
+
+/* returns index of the first special byte of v at or after from,
+ * or v.len */
+static size_t find(str_view v, size_t from, struct special const* sp,
+        enum str_simd level) {
+    size_t i = from;
+
+#ifdef STR_SIMD_X86
+    if (level == STR_SIMD_AVX2) {
+        for (; i + 32 <= v.len; i += 32) {
+            unsigned mask = mask_avx2(v.data + i, sp);
+
+            if (mask) {
+                return i + (size_t) __builtin_ctz(mask);
+            }
+        }
+    }
+
+    for (; i + 16 <= v.len; i += 16) {
+        unsigned mask = mask_sse2(v.data + i, sp);
+
+        if (mask) {
+            return i + (size_t) __builtin_ctz(mask);
+        }
+    }
+#else
+    (void) level;
+#endif /* STR_SIMD_X86 */
+
+    while (i < v.len && !is_special(sp, (unsigned char) v.data[i])) {
+        i++;
+    }
+
+    return i;
+}
+
+/* returns number of special bytes of v */
+static size_t count(str_view v, struct special const* sp,
+        enum str_simd level) {
+    size_t i = 0;
+    size_t n = 0;
+
+#ifdef STR_SIMD_X86
+    if (level == STR_SIMD_AVX2) {
+        for (; i + 32 <= v.len; i += 32) {
+            n += (size_t) __builtin_popcount(mask_avx2(v.data + i, sp));
+        }
+    }
+
+    for (; i + 16 <= v.len; i += 16) {
+        n += (size_t) __builtin_popcount(mask_sse2(v.data + i, sp));
+    }
+#else
+    (void) level;
+#endif /* STR_SIMD_X86 */
+
+    for (; i < v.len; ++i) {
+        n += is_special(sp, (unsigned char) v.data[i]);
+    }
+
+    return n;
+}
+
+/* reserves room for v with every special byte grown by at most
+ * extra bytes */
+static bool reserve_escaped(str* self, str_view* v, size_t extra,
+        struct special const* sp, enum str_simd level) {
+    size_t n = count(*v, sp, level);
+
+    /* overflow */
+    if (n && extra > (SIZE_MAX - v->len) / n) {
+        return false;
+    }
+
+    return str_reserve_view(self, v, v->len + extra * n);
+}
+
+static bool append_run(str* self, str_view v, size_t begin, size_t end) {
+    return begin == end
+        || str_append_view(self, (str_view) { v.data + begin, end - begin });
+}
+
+/* appends code point as UTF-8 */
+static bool append_utf8(str* self, uint32_t cp) {
+    char buf[4];
+    size_t n;
+
+    if (cp < 0x80) {
+        buf[0] = (char) cp;
+        n = 1;
+    } else if (cp < 0x800) {
+        buf[0] = (char) (0xc0 | cp >> 6);
+        buf[1] = (char) (0x80 | (cp & 0x3f));
+        n = 2;
+    } else if (cp < 0x10000) {
+        buf[0] = (char) (0xe0 | cp >> 12);
+        buf[1] = (char) (0x80 | (cp >> 6 & 0x3f));
+        buf[2] = (char) (0x80 | (cp & 0x3f));
+        n = 3;
+    } else {
+        buf[0] = (char) (0xf0 | cp >> 18);
+        buf[1] = (char) (0x80 | (cp >> 12 & 0x3f));
+        buf[2] = (char) (0x80 | (cp >> 6 & 0x3f));
+        buf[3] = (char) (0x80 | (cp & 0x3f));
+        n = 4;
+    }
+
+    return str_append_view(self, (str_view) { buf, n });
+}
+
+/* parses the 4 hex digits of a \u escape at i, or returns -1 */
+static long hex4(str_view v, size_t i) {
+    if (v.len - i < 4) {
+        return -1;
+    }
+
+    long x = 0;
+
+    for (size_t k = 0; k < 4; ++k) {
+        int d = str_hex_digit(v.data[i + k]);
+
+        if (d < 0) {
+            return -1;
+        }
+
+        x = x << 4 | d;
+    }
+
+    return x;
+}
+
+/* parses the character reference after the & at i, returning its code
+ * point and setting its end, or returning 0 if there is none */
+static uint32_t reference(str_view v, size_t i, size_t* end) {
+    static struct {
+        char const* name;
+        uint32_t cp;
+    } const names[] = {
+        { "amp;", '&' }, { "lt;", '<' }, { "gt;", '>' }, { "quot;", '"' },
+        { "apos;", '\'' },
+    };
+
+    char const* p = v.data + i + 1;
+    size_t n = v.len - i - 1;
+
+    for (size_t k = 0; k < sizeof names / sizeof *names; ++k) {
+        size_t len = strlen(names[k].name);
+
+        if (n >= len && !memcmp(p, names[k].name, len)) {
+            *end = i + 1 + len;
+            return names[k].cp;
+        }
+    }
+
+    if (n < 3 || p[0] != '#') {
+        return 0;
+    }
+
+    bool hexadecimal = p[1] == 'x' || p[1] == 'X';
+    size_t k = hexadecimal ? 2 : 1;
+    size_t digits = k;
+    uint32_t cp = 0;
+
+    for (; k < n && p[k] != ';'; ++k) {
+        int d = hexadecimal ? str_hex_digit(p[k])
+            : p[k] >= '0' && p[k] <= '9' ? p[k] - '0' : -1;
+
+        if (d < 0) {
+            return 0;
+        }
+
+        cp = cp * (hexadecimal ? 16 : 10) + (uint32_t) d;
+
+        /* out of range, which also keeps it from overflowing */
+        if (cp > 0x10ffff) {
+            return 0;
+        }
+    }
+
+    /* surrogates aren't characters */
+    if (k == n || k == digits || (cp >= 0xd800 && cp <= 0xdfff)) {
+        return 0;
+    }
+
+    *end = i + 1 + k + 1;
+
+    return cp;
+}
+
+/* -- Public Interface Implementation -- */
+
+bool str_append_json_escaped(str* self, str_view v) {
+    if (!self || (!v.data && v.len)) {
+        return false;
+    }
+
+    enum str_simd level = str_simd_detect();
+
+    /* \u00XX is the longest escape */
+    if (!reserve_escaped(self, &v, 5, &JSON, level)) {
+        return false;
+    }
+
+    for (size_t i = 0; i < v.len;) {
+        size_t j = find(v, i, &JSON, level);
+
+        if (!append_run(self, v, i, j)) {
+            return false;
+        }
+
+        if (j == v.len) {
+            break;
+        }
+
+        unsigned char c = (unsigned char) v.data[j];
+        char buf[6] = { '\\', (char) c };
+        size_t n = 2;
+
+        switch (c) {
+        case '\b': buf[1] = 'b'; break;
+        case '\f': buf[1] = 'f'; break;
+        case '\n': buf[1] = 'n'; break;
+        case '\r': buf[1] = 'r'; break;
+        case '\t': buf[1] = 't'; break;
+        case '"': case '\\': break;
+        default:
+            memcpy(buf + 1, "u00", 3);
+            buf[4] = "0123456789abcdef"[c >> 4];
+            buf[5] = "0123456789abcdef"[c & 15];
+            n = 6;
+        }
+
+        if (!str_append_view(self, (str_view) { buf, n })) {
+            return false;
+        }
+
+        i = j + 1;
+    }
+
+    return true;
+}
+
+bool str_append_json_unescaped(str* self, str_view v) {
+    if (!self || (!v.data && v.len)) {
+        return false;
+    }
+
+    /* escapes never grow */
+    if (!str_reserve_view(self, &v, v.len)) {
+        return false;
+    }
+
+    size_t len = str_len(self);
+
+    for (size_t i = 0; i < v.len;) {
+        char const* p = memchr(v.data + i, '\\', v.len - i);
+        size_t j = p ? (size_t) (p - v.data) : v.len;
+
+        if (!append_run(self, v, i, j)) {
+            return str_rollback(self, len);
+        }
+
+        if (j == v.len) {
+            break;
+        }
+
+        if (j + 1 == v.len) {
+            return str_rollback(self, len);
+        }
+
+        char c = v.data[j + 1];
+        char const* simple = strchr("\"\\/bfnrt", c);
+
+        i = j + 2;
+
+        if (c && simple) {
+            if (!str_append_char(self,
+                        "\"\\/\b\f\n\r\t"[simple - "\"\\/bfnrt"])) {
+                return str_rollback(self, len);
+            }
+
+            continue;
+        }
+
+        long cp = c == 'u' ? hex4(v, i) : -1;
+
+        if (cp < 0 || (cp >= 0xdc00 && cp <= 0xdfff)) {
+            return str_rollback(self, len);
+        }
+
+        i += 4;
+
+        /* a high surrogate pairs with a low one */
+        if (cp >= 0xd800 && cp <= 0xdbff) {
+            long low = v.len - i >= 2 && v.data[i] == '\\'
+                && v.data[i + 1] == 'u' ? hex4(v, i + 2) : -1;
+
+            if (low < 0xdc00 || low > 0xdfff) {
+                return str_rollback(self, len);
+            }
+
+            cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+            i += 6;
+        }
+
+        if (!append_utf8(self, (uint32_t) cp)) {
+            return str_rollback(self, len);
+        }
+    }
+
+    return true;
+}
+
+bool str_append_csv_quoted(str* self, str_view v) {
+    if (!self || (!v.data && v.len)) {
+        return false;
+    }
+
+    enum str_simd level = str_simd_detect();
+    size_t first = find(v, 0, &CSV, level);
+
+    if (first == v.len) {
+        return str_append_view(self, v);
+    }
+
+    static struct special const QUOTE = { { '"' }, 1, false };
+    size_t quotes = count(v, &QUOTE, level);
+
+    /* overflow */
+    if (v.len > SIZE_MAX - 2 - quotes
+            || !str_reserve_view(self, &v, v.len + 2 + quotes)
+            || !str_append_char(self, '"')) {
+        return false;
+    }
+
+    for (size_t i = 0; i < v.len;) {
+        char const* p = memchr(v.data + i, '"', v.len - i);
+        /* the quote goes with the run, then again on its own */
+        size_t j = p ? (size_t) (p - v.data) + 1 : v.len;
+
+        if (!append_run(self, v, i, j) || (p && !str_append_char(self, '"'))) {
+            return false;
+        }
+
+        i = j;
+    }
+
+    return str_append_char(self, '"');
+}
+
+bool str_append_csv_unquoted(str* self, str_view v) {
+    if (!self || (!v.data && v.len)) {
+        return false;
+    }
+
+    if (!v.len || v.data[0] != '"') {
+        return str_append_view(self, v);
+    }
+
+    if (v.len < 2 || v.data[v.len - 1] != '"'
+            || !str_reserve_view(self, &v, v.len)) {
+        return false;
+    }
+
+    size_t len = str_len(self);
+    /* without the outer quotes */
+    str_view inner = { v.data + 1, v.len - 2 };
+
+    for (size_t i = 0; i < inner.len;) {
+        char const* p = memchr(inner.data + i, '"', inner.len - i);
+        size_t j = p ? (size_t) (p - inner.data) : inner.len;
+
+        /* quotes come in pairs, of which one is kept */
+        if (p && (j + 1 == inner.len || inner.data[j + 1] != '"')) {
+            return str_rollback(self, len);
+        }
+
+        if (!append_run(self, inner, i, p ? j + 1 : j)) {
+            return str_rollback(self, len);
+        }
+
+        i = p ? j + 2 : j;
+    }
+
+    return true;
+}
+
+bool str_append_html_escaped(str* self, str_view v) {
+    if (!self || (!v.data && v.len)) {
+        return false;
+    }
+
+    enum str_simd level = str_simd_detect();
+
+    /* &quot; is the longest reference */
+    if (!reserve_escaped(self, &v, 5, &HTML, level)) {
+        return false;
+    }
+
+    for (size_t i = 0; i < v.len;) {
+        size_t j = find(v, i, &HTML, level);
+
+        if (!append_run(self, v, i, j)) {
+            return false;
+        }
+
+        if (j == v.len) {
+            break;
+        }
+
+        char const* ref = "&#39;";
+
+        switch (v.data[j]) {
+        case '&': ref = "&amp;"; break;
+        case '<': ref = "&lt;"; break;
+        case '>': ref = "&gt;"; break;
+        case '"': ref = "&quot;"; break;
+        }
+
+        if (!str_append_view(self, str_view_of(ref))) {
+            return false;
+        }
+
+        i = j + 1;
+    }
+
+    return true;
+}
+
+bool str_append_html_unescaped(str* self, str_view v) {
+    if (!self || (!v.data && v.len)) {
+        return false;
+    }
+
+    /* references never grow */
+    if (!str_reserve_view(self, &v, v.len)) {
+        return false;
+    }
+
+    for (size_t i = 0; i < v.len;) {
+        char const* p = memchr(v.data + i, '&', v.len - i);
+        size_t j = p ? (size_t) (p - v.data) : v.len;
+        size_t end = j + 1;
+        uint32_t cp = p ? reference(v, j, &end) : 0;
+
+        /* a lone & stays with the run */
+        if (!append_run(self, v, i, cp ? j : end > v.len ? v.len : end)
+                || (cp && !append_utf8(self, cp))) {
+            return false;
+        }
+
+        i = end;
+    }
+
+    return true;
+}
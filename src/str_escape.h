@@ -0,0 +1,98 @@
+/** str's Escaping
+ * @file str_escape.h
+ *
+ * Escaping and unescaping for JSON strings, CSV fields and HTML text,
+ * appending to str. Input is scanned a block of 16 or 32 bytes at a
+ * time for the characters that need escaping, and the runs between
+ * them are copied in bulk. */
+#ifndef STR_ESCAPE_H
+#define STR_ESCAPE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "str.h"
+
+/** Appends view escaped as the contents of a JSON string.
+ * @note       Quotes, backslashes and control characters are escaped,
+ *             the surrounding quotes aren't added. Other bytes,
+ *             UTF-8 included, are copied as they are.
+ *
+ * @param self A pointer to a str object.
+ * @param v    A view.
+ *
+ * @return     true if successful.
+ *
+ * @see str_append_json_unescaped */
+bool str_append_json_escaped(str* self, str_view v);
+
+/** Appends contents of a JSON string with its escapes resolved.
+ * @note       \\u escapes are written as UTF-8, surrogate pairs
+ *             included.
+ *
+ * @param self A pointer to a str object.
+ * @param v    A view over the contents, without the quotes.
+ *
+ * @return     true if successful, false if an escape is invalid, in
+ *             which case self is left unchanged.
+ *
+ * @see str_append_json_escaped */
+bool str_append_json_unescaped(str* self, str_view v);
+
+/** Appends view as a CSV field.
+ * @note       As in RFC 4180, a field holding commas, quotes or line
+ *             breaks is quoted, with its quotes doubled, any other is
+ *             appended as it is.
+ *
+ * @param self A pointer to a str object.
+ * @param v    A view.
+ *
+ * @return     true if successful.
+ *
+ * @see str_append_csv_unquoted */
+bool str_append_csv_quoted(str* self, str_view v);
+
+/** Appends value of a CSV field.
+ * @param self A pointer to a str object.
+ * @param v    A view over the field, quoted or not.
+ *
+ * @return     true if successful, false if a quoted field isn't closed
+ *             or holds a lone quote, in which case self is left
+ *             unchanged.
+ *
+ * @see str_append_csv_quoted */
+bool str_append_csv_unquoted(str* self, str_view v);
+
+/** Appends view escaped as HTML text or attribute value.
+ * @note       & < > " and ' are replaced with character references.
+ *
+ * @param self A pointer to a str object.
+ * @param v    A view.
+ *
+ * @return     true if successful.
+ *
+ * @see str_append_html_unescaped */
+bool str_append_html_escaped(str* self, str_view v);
+
+/** Appends HTML text with its character references resolved.
+ * @note       It resolves &amp; &lt; &gt; &quot; &apos; and numeric
+ *             references, written as UTF-8. As in browsers, anything
+ *             else starting with & is copied as it is.
+ *
+ * @param self A pointer to a str object.
+ * @param v    A view.
+ *
+ * @return     true if successful.
+ *
+ * @see str_append_html_escaped */
+bool str_append_html_unescaped(str* self, str_view v);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* STR_ESCAPE_H */
@@ -0,0 +1,183 @@
+#include <assert.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cmocka.h>
+
+#include "str.h"
+#include "str_escape.h"
+
+typedef bool (*append_fn)(str*, str_view);
+
+static void assert_append(append_fn fn, str_view in, char const* out) {
+    str* s = str_from("<");
+
+    assert_true(fn(s, in));
+    assert_int_equal(str_len(s), strlen(out) + 1);
+    assert_memory_equal(str_cstr(s) + 1, out, strlen(out));
+
+    str_del(s);
+}
+
+/* checks that unescaping fails and leaves the str alone */
+static void assert_invalid(append_fn fn, char const* in) {
+    str* s = str_from("kept");
+
+    assert_false(fn(s, str_view_of(in)));
+    assert_string_equal(str_cstr(s), "kept");
+
+    str_del(s);
+}
+
+/* random strings rich in the characters the formats escape */
+static str* random_str(size_t max) {
+    static char const alphabet[] = "ab,\"\\&<>'\n\r\t\x01\x1f\x7f\xc3\xa9 ;#";
+    size_t len = (size_t) rand() % (max + 1);
+    str* s = str_new();
+
+    for (size_t i = 0; i < len; ++i) {
+        /* long clean runs now and then */
+        if (rand() % 8 == 0) {
+            for (int k = rand() % 64; k > 0; --k) {
+                str_append_char(s, 'x');
+            }
+        }
+
+        str_append_char(s, alphabet[rand() % (sizeof alphabet - 1)]);
+    }
+
+    return s;
+}
+
+static void assert_round_trip(append_fn escape, append_fn unescape,
+        int seed) {
+    srand((unsigned) seed);
+
+    for (int round = 0; round < 500; ++round) {
+        str* in = random_str(round < 400 ? 40 : 2000);
+        str* escaped = str_new();
+        str* back = str_new();
+
+        assert_true(escape(escaped, str_view_of(in)));
+        assert_true(unescape(back, str_view_of(escaped)));
+        assert_true(str_equal(back, in));
+
+        str_del(in);
+        str_del(escaped);
+        str_del(back);
+    }
+}
+
+static void str_json_test(void** state) {
+    (void) state;
+
+    assert_append(str_append_json_escaped, str_view_of("plain"), "plain");
+    assert_append(str_append_json_escaped,
+            str_view_of("a\"b\\c\n\t\x01\x1f/\xc3\xa9"),
+            "a\\\"b\\\\c\\n\\t\\u0001\\u001f/\xc3\xa9");
+    assert_append(str_append_json_escaped, ((str_view) { "\0", 1 }),
+            "\\u0000");
+
+    assert_append(str_append_json_unescaped,
+            str_view_of("a\\\"b\\\\c\\/\\b\\f\\n\\r\\t"),
+            "a\"b\\c/\b\f\n\r\t");
+    assert_append(str_append_json_unescaped,
+            str_view_of("\\u0041\\u00e9\\u20AC\\ud83d\\ude00"),
+            "A\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80");
+
+    str* nul = str_new();
+
+    assert_true(str_append_json_unescaped(nul, str_view_of("\\u0000")));
+    assert_int_equal(str_len(nul), 1);
+    assert_int_equal(str_cstr(nul)[0], 0);
+
+    str_del(nul);
+
+    char const* invalid[] = {
+        "\\", "\\x", "\\u12", "\\u12g4", "\\ud83d", "\\ud83dx", "\\ude00",
+        "\\ud83d\\u0041", "ok\\q",
+    };
+
+    for (size_t i = 0; i < sizeof invalid / sizeof *invalid; ++i) {
+        assert_invalid(str_append_json_unescaped, invalid[i]);
+    }
+
+    assert_round_trip(str_append_json_escaped, str_append_json_unescaped,
+            39);
+}
+
+static void str_csv_test(void** state) {
+    (void) state;
+
+    assert_append(str_append_csv_quoted, str_view_of("plain text"),
+            "plain text");
+    assert_append(str_append_csv_quoted, str_view_of("a,b"), "\"a,b\"");
+    assert_append(str_append_csv_quoted, str_view_of("say \"hi\""),
+            "\"say \"\"hi\"\"\"");
+    assert_append(str_append_csv_quoted, str_view_of("two\nlines"),
+            "\"two\nlines\"");
+    assert_append(str_append_csv_quoted, str_view_of(""), "");
+
+    assert_append(str_append_csv_unquoted, str_view_of("plain"), "plain");
+    assert_append(str_append_csv_unquoted, str_view_of("\"\""), "");
+    assert_append(str_append_csv_unquoted, str_view_of("\"a\"\"b,\""),
+            "a\"b,");
+
+    assert_invalid(str_append_csv_unquoted, "\"");
+    assert_invalid(str_append_csv_unquoted, "\"abc");
+    assert_invalid(str_append_csv_unquoted, "\"a\"b\"");
+    assert_invalid(str_append_csv_unquoted, "\"a\"\"\"\"\"\"");
+
+    assert_round_trip(str_append_csv_quoted, str_append_csv_unquoted, 40);
+}
+
+static void str_html_test(void** state) {
+    (void) state;
+
+    assert_append(str_append_html_escaped,
+            str_view_of("<a href=\"x\">Tom & Jerry's</a>"),
+            "&lt;a href=&quot;x&quot;&gt;Tom &amp; Jerry&#39;s&lt;/a&gt;");
+
+    assert_append(str_append_html_unescaped,
+            str_view_of("&lt;&amp;&gt;&quot;&apos;&#39;&#x41;&#X20ac;&#233;"),
+            "<&>\"''A\xe2\x82\xac\xc3\xa9");
+    /* anything else is left alone */
+    assert_append(str_append_html_unescaped,
+            str_view_of("& &amp &nbsp; &#; &#x; &#12a; &#xd800; &#1114112;"
+                " &#0; &"),
+            "& &amp &nbsp; &#; &#x; &#12a; &#xd800; &#1114112; &#0; &");
+
+    assert_round_trip(str_append_html_escaped, str_append_html_unescaped,
+            41);
+}
+
+static void str_escape_self_test(void** state) {
+    (void) state;
+
+    str* s = str_from("a\"b");
+
+    /* a view into the str itself */
+    assert_true(str_append_json_escaped(s, str_view_of(s)));
+    assert_string_equal(str_cstr(s), "a\"ba\\\"b");
+    assert_true(str_append_html_escaped(s, (str_view) { str_cstr(s), 3 }));
+    assert_string_equal(str_cstr(s), "a\"ba\\\"ba&quot;b");
+
+    str_del(s);
+}
+
+
+int main(void) {
+    struct CMUnitTest const tests[] = {
+        cmocka_unit_test(str_json_test),
+        cmocka_unit_test(str_csv_test),
+        cmocka_unit_test(str_html_test),
+        cmocka_unit_test(str_escape_self_test),
+    };
+
+
+    return cmocka_run_group_tests(tests, (void*) 0, (void*) 0);
+}
@@ -0,0 +1,338 @@
+#include <pthread.h>
+#include <string.h>
+
+#include "str_hash.h"
+#include "str_simd.h"
+
+/* CRC32C polynomial, bit reversed */
+#define POLY 0x82f63b78u
+
+/* large inputs are split in three lanes of this many bytes, whose CRCs
+ * are computed side by side and then combined */
+#define LONG 8192
+#define SHORT 256
+
+/* -- Private Interface -- */
+
+static pthread_once_t tables_once = PTHREAD_ONCE_INIT;
+
+/* slicing-by-8 tables, and tables shifting a CRC over LONG and SHORT
+ * zero bytes */
+static uint32_t tables[8][256];
+static uint32_t zeros_long[4][256];
+static uint32_t zeros_short[4][256];
+
+/* returns a times b modulo POLY, both bit reversed */
+static uint32_t multmodp(uint32_t a, uint32_t b) {
+    uint32_t m = (uint32_t) 1 << 31;
+    uint32_t p = 0;
+
+    for (;;) {
+        if (a & m) {
+            p ^= b;
+
+            if (!(a & (m - 1))) {
+                break;
+            }
+        }
+
+        m >>= 1;
+        b = b & 1 ? (b >> 1) ^ POLY : b >> 1;
+    }
+
+    return p;
+}
+
+/* returns x^(8 n) modulo POLY, i.e. the factor shifting a CRC over n
+ * zero bytes */
+static uint32_t x8nmodp(size_t n) {
+    uint32_t p = (uint32_t) 1 << 31;
+    uint32_t sq = (uint32_t) 1 << 23;
+
+    for (; n; n >>= 1) {
+        if (n & 1) {
+            p = multmodp(sq, p);
+        }
+
+        sq = multmodp(sq, sq);
+    }
+
+    return p;
+}
+
+static void zeros_init(uint32_t zeros[4][256], size_t n) {
+    uint32_t x = x8nmodp(n);
+
+    for (uint32_t i = 0; i < 256; ++i) {
+        for (int k = 0; k < 4; ++k) {
+            zeros[k][i] = multmodp(x, i << 8 * k);
+        }
+    }
+}
+
+static void tables_init(void) {
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t crc = i;
+
+        for (int k = 0; k < 8; ++k) {
+            crc = crc & 1 ? (crc >> 1) ^ POLY : crc >> 1;
+        }
+
+        tables[0][i] = crc;
+    }
+
+    for (uint32_t i = 0; i < 256; ++i) {
+        for (int k = 1; k < 8; ++k) {
+            tables[k][i] = tables[0][tables[k - 1][i] & 0xff]
+                ^ tables[k - 1][i] >> 8;
+        }
+    }
+
+    zeros_init(zeros_long, LONG);
+    zeros_init(zeros_short, SHORT);
+}
+
+static uint32_t shift(uint32_t zeros[4][256], uint32_t crc) {
+    return zeros[0][crc & 0xff] ^ zeros[1][crc >> 8 & 0xff]
+        ^ zeros[2][crc >> 16 & 0xff] ^ zeros[3][crc >> 24];
+}
+
+static uint32_t crc_bytes(uint32_t crc, unsigned char const* s, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        crc = tables[0][(crc ^ s[i]) & 0xff] ^ crc >> 8;
+    }
+
+    return crc;
+}
+
+static uint32_t crc_slice8(uint32_t crc, unsigned char const* s, size_t n) {
+    for (; n >= 8; s += 8, n -= 8) {
+        uint32_t lo = crc ^ ((uint32_t) s[0] | (uint32_t) s[1] << 8
+                | (uint32_t) s[2] << 16 | (uint32_t) s[3] << 24);
+
+        crc = tables[7][lo & 0xff] ^ tables[6][lo >> 8 & 0xff]
+            ^ tables[5][lo >> 16 & 0xff] ^ tables[4][lo >> 24]
+            ^ tables[3][s[4]] ^ tables[2][s[5]]
+            ^ tables[1][s[6]] ^ tables[0][s[7]];
+    }
+
+    return crc_bytes(crc, s, n);
+}
+
+#ifdef STR_SIMD_X86
+
+static uint64_t load64(unsigned char const* s) {
+    uint64_t w;
+
+    memcpy(&w, s, 8);
+
+    return w;
+}
+
+/* the crc32 instruction takes 3 cycles and can start every cycle, so
+ * three independent lanes keep it busy, one lane would wait on itself */
+STR_SIMD_TARGET("sse4.2")
+static uint32_t lanes_sse42(uint32_t crc, unsigned char const* s,
+        size_t lane, uint32_t zeros[4][256]) {
+    uint64_t c0 = crc;
+    uint64_t c1 = 0;
+    uint64_t c2 = 0;
+
+    for (size_t i = 0; i < lane; i += 8) {
+        c0 = _mm_crc32_u64(c0, load64(s + i));
+        c1 = _mm_crc32_u64(c1, load64(s + lane + i));
+        c2 = _mm_crc32_u64(c2, load64(s + 2 * lane + i));
+    }
+
+    crc = shift(zeros, (uint32_t) c0) ^ (uint32_t) c1;
+
+    return shift(zeros, crc) ^ (uint32_t) c2;
+}
+
+STR_SIMD_TARGET("sse4.2")
+static uint32_t crc_sse42(uint32_t crc, unsigned char const* s, size_t n) {
+    for (; n >= 3 * LONG; s += 3 * LONG, n -= 3 * LONG) {
+        crc = lanes_sse42(crc, s, LONG, zeros_long);
+    }
+
+    for (; n >= 3 * SHORT; s += 3 * SHORT, n -= 3 * SHORT) {
+        crc = lanes_sse42(crc, s, SHORT, zeros_short);
+    }
+
+    uint64_t c = crc;
+
+    for (; n >= 8; s += 8, n -= 8) {
+        c = _mm_crc32_u64(c, load64(s));
+    }
+
+    crc = (uint32_t) c;
+
+    for (; n; ++s, --n) {
+        crc = _mm_crc32_u8(crc, *s);
+    }
+
+    return crc;
+}
+
+#endif /* STR_SIMD_X86 */
+
+/* -- MurmurHash3 -- */
+
+#define C1 0x87c37b91114253d5u
+#define C2 0x4cf5ad432745937fu
+
+static uint64_t rotl(uint64_t x, int r) {
+    return x << r | x >> (64 - r);
+}
+
+static uint64_t le64(unsigned char const* s) {
+    return (uint64_t) s[0] | (uint64_t) s[1] << 8 | (uint64_t) s[2] << 16
+        | (uint64_t) s[3] << 24 | (uint64_t) s[4] << 32
+        | (uint64_t) s[5] << 40 | (uint64_t) s[6] << 48
+        | (uint64_t) s[7] << 56;
+}
+
+static uint64_t fmix(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdu;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53u;
+    k ^= k >> 33;
+
+    return k;
+}
+
+static uint64_t mix1(uint64_t k1) {
+    return rotl(k1 * C1, 31) * C2;
+}
+
+static uint64_t mix2(uint64_t k2) {
+    return rotl(k2 * C2, 33) * C1;
+}
+
+static void blocks(str_murmur3_state* self, unsigned char const* s, size_t n) {
+    uint64_t h1 = self->h1;
+    uint64_t h2 = self->h2;
+
+    for (; n >= 16; s += 16, n -= 16) {
+        h1 ^= mix1(le64(s));
+        h1 = (rotl(h1, 27) + h2) * 5 + 0x52dce729;
+        h2 ^= mix2(le64(s + 8));
+        h2 = (rotl(h2, 31) + h1) * 5 + 0x38495ab5;
+    }
+
+    self->h1 = h1;
+    self->h2 = h2;
+}
+
+/* -- Public Interface Implementation -- */
+
+uint32_t str_crc32c(uint32_t crc, str_view v, unsigned flags) {
+    if (!v.data) {
+        return crc;
+    }
+
+    unsigned char const* s = (unsigned char const*) v.data;
+
+    pthread_once(&tables_once, tables_init);
+
+    crc = ~crc;
+
+#ifdef STR_SIMD_X86
+    if (!(flags & STR_HASH_SCALAR) && __builtin_cpu_supports("sse4.2")) {
+        return ~crc_sse42(crc, s, v.len);
+    }
+#else
+    (void) flags;
+#endif /* STR_SIMD_X86 */
+
+    return ~crc_slice8(crc, s, v.len);
+}
+
+void str_murmur3_init(str_murmur3_state* self, uint32_t seed) {
+    if (!self) {
+        return;
+    }
+
+    self->h1 = seed;
+    self->h2 = seed;
+    self->len = 0;
+}
+
+void str_murmur3_update(str_murmur3_state* self, str_view v) {
+    if (!self || !v.data || !v.len) {
+        return;
+    }
+
+    unsigned char const* s = (unsigned char const*) v.data;
+    size_t n = v.len;
+    size_t held = self->len % 16;
+
+    self->len += n;
+
+    /* tops up the tail left by the last update first */
+    if (held) {
+        size_t take = 16 - held < n ? 16 - held : n;
+
+        memcpy(self->tail + held, s, take);
+        s += take;
+        n -= take;
+
+        if (held + take < 16) {
+            return;
+        }
+
+        blocks(self, self->tail, 16);
+    }
+
+    blocks(self, s, n);
+    memcpy(self->tail, s + n / 16 * 16, n % 16);
+}
+
+str_hash128 str_murmur3_final(str_murmur3_state const* self) {
+    if (!self) {
+        return (str_hash128) { 0, 0 };
+    }
+
+    uint64_t h1 = self->h1;
+    uint64_t h2 = self->h2;
+    size_t held = self->len % 16;
+    uint64_t k1 = 0;
+    uint64_t k2 = 0;
+
+    for (size_t i = held; i > 8; --i) {
+        k2 = k2 << 8 | self->tail[i - 1];
+    }
+
+    for (size_t i = held < 8 ? held : 8; i > 0; --i) {
+        k1 = k1 << 8 | self->tail[i - 1];
+    }
+
+    if (held > 8) {
+        h2 ^= mix2(k2);
+    }
+
+    if (held) {
+        h1 ^= mix1(k1);
+    }
+
+    h1 ^= self->len;
+    h2 ^= self->len;
+    h1 += h2;
+    h2 += h1;
+    h1 = fmix(h1);
+    h2 = fmix(h2);
+    h1 += h2;
+    h2 += h1;
+
+    return (str_hash128) { h1, h2 };
+}
+
+str_hash128 str_murmur3(str_view v, uint32_t seed) {
+    str_murmur3_state state;
+
+    str_murmur3_init(&state, seed);
+    str_murmur3_update(&state, v);
+
+    return str_murmur3_final(&state);
+}
@@ -0,0 +1,93 @@
+/** str's Checksums
+ * @file str_hash.h
+ *
+ * CRC32C (Castagnoli), as used by iSCSI, ext4 and many storage formats,
+ * and the 128-bit MurmurHash3, a fast non-cryptographic digest. Both
+ * can be computed a chunk at a time, so streamed input needn't be
+ * gathered first. On x86-64 CRC32C runs on the SSE4.2 crc32
+ * instruction when the cpu has it, otherwise on slicing-by-8 tables. */
+#ifndef STR_HASH_H
+#define STR_HASH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "str.h"
+
+/** Flags of the checksums, they combine with |. */
+typedef enum str_hash_flags {
+    STR_HASH_DEFAULT = 0,
+    /** Runs the table driven code only, for tests and benchmarks. */
+    STR_HASH_SCALAR = 1 << 0,
+} str_hash_flags;
+
+/** 128-bit digest. */
+typedef struct str_hash128 {
+    uint64_t lo;
+    uint64_t hi;
+} str_hash128;
+
+/** State of a MurmurHash3 in progress.
+ * @note       Its fields are private, use the str_murmur3 functions. */
+typedef struct str_murmur3_state {
+    uint64_t h1;
+    uint64_t h2;
+    uint64_t len;
+    unsigned char tail[16];
+} str_murmur3_state;
+
+/** Computes CRC32C of view, continuing from crc.
+ * @note       Pass 0 to start, and the previous result to continue with
+ *             the next chunk: str_crc32c(str_crc32c(0, a, 0), b, 0) is
+ *             the CRC of a followed by b.
+ *
+ * @param crc   CRC of the bytes before v, or 0.
+ * @param v     A view.
+ * @param flags STR_HASH_SCALAR selects the table driven code.
+ *
+ * @return      CRC32C of the bytes before v followed by v. */
+uint32_t str_crc32c(uint32_t crc, str_view v, unsigned flags);
+
+/** Starts a MurmurHash3.
+ * @param self A pointer to a state.
+ * @param seed A seed.
+ *
+ * @see str_murmur3_update str_murmur3_final */
+void str_murmur3_init(str_murmur3_state* self, uint32_t seed);
+
+/** Adds view to a MurmurHash3.
+ * @param self A pointer to a state.
+ * @param v    A view.
+ *
+ * @see str_murmur3_final */
+void str_murmur3_update(str_murmur3_state* self, str_view v);
+
+/** Returns the MurmurHash3 of everything added.
+ * @note       The state isn't changed, more can still be added.
+ *
+ * @param self A pointer to a state.
+ *
+ * @return     The x64 128-bit variant of MurmurHash3, lo and hi being
+ *             its first and second halves.
+ *
+ * @see str_murmur3 */
+str_hash128 str_murmur3_final(str_murmur3_state const* self);
+
+/** Returns MurmurHash3 of view.
+ * @param v    A view.
+ * @param seed A seed.
+ *
+ * @return     The same as str_murmur3_final after adding v.
+ *
+ * @see str_murmur3_init */
+str_hash128 str_murmur3(str_view v, uint32_t seed);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* STR_HASH_H */
@@ -0,0 +1,181 @@
+#include <assert.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cmocka.h>
+
+#include "str.h"
+#include "str_hash.h"
+
+/* bit at a time, straight from the definition */
+static uint32_t crc32c_reference(unsigned char const* s, size_t n) {
+    uint32_t crc = 0xffffffffu;
+
+    for (size_t i = 0; i < n; ++i) {
+        crc ^= s[i];
+
+        for (int k = 0; k < 8; ++k) {
+            crc = crc & 1 ? (crc >> 1) ^ 0x82f63b78u : crc >> 1;
+        }
+    }
+
+    return ~crc;
+}
+
+static void str_crc32c_test(void** state) {
+    (void) state;
+
+    unsigned const flags[] = { STR_HASH_DEFAULT, STR_HASH_SCALAR };
+
+    for (size_t f = 0; f < 2; ++f) {
+        assert_int_equal(str_crc32c(0, str_view_of(""), flags[f]), 0);
+        assert_int_equal(str_crc32c(0, str_view_of("123456789"), flags[f]),
+                0xe3069283u);
+        assert_int_equal(str_crc32c(0, str_view_of("a"), flags[f]),
+                0xc1d04330u);
+    }
+
+    /* long enough for both lane sizes, from every offset */
+    size_t const n = 3 * 8192 * 2 + 3 * 256 + 100;
+    unsigned char* buf = malloc(n);
+
+    srand(41);
+
+    for (size_t i = 0; i < n; ++i) {
+        buf[i] = (unsigned char) rand();
+    }
+
+    size_t const lens[] = { 1, 7, 8, 9, 767, 768, 769, 24575, 24576, n - 3 };
+
+    for (size_t i = 0; i < sizeof lens / sizeof *lens; ++i) {
+        for (size_t offset = 0; offset < 3; ++offset) {
+            str_view v = { (char const*) buf + offset, lens[i] };
+            uint32_t expected = crc32c_reference(buf + offset, lens[i]);
+
+            assert_int_equal(str_crc32c(0, v, STR_HASH_DEFAULT), expected);
+            assert_int_equal(str_crc32c(0, v, STR_HASH_SCALAR), expected);
+        }
+    }
+
+    free(buf);
+}
+
+static void str_crc32c_stream_test(void** state) {
+    (void) state;
+
+    str* s = str_new();
+
+    for (int i = 0; i < 30000; ++i) {
+        str_append_char(s, (char) ('a' + i % 26));
+    }
+
+    str_view v = str_view_of(s);
+    uint32_t whole = str_crc32c(0, v, STR_HASH_DEFAULT);
+
+    srand(42);
+
+    for (int round = 0; round < 50; ++round) {
+        uint32_t crc = 0;
+
+        for (size_t i = 0; i < v.len;) {
+            size_t n = (size_t) rand() % (round < 25 ? 40 : 20000);
+
+            n = n < v.len - i ? n : v.len - i;
+            crc = str_crc32c(crc, (str_view) { v.data + i, n },
+                    round % 2 ? STR_HASH_SCALAR : STR_HASH_DEFAULT);
+            i += n;
+        }
+
+        assert_int_equal(crc, whole);
+    }
+
+    str_del(s);
+}
+
+static void put64(unsigned char* out, uint64_t x) {
+    for (int i = 0; i < 8; ++i) {
+        out[i] = (unsigned char) (x >> 8 * i);
+    }
+}
+
+static void str_murmur3_test(void** state) {
+    (void) state;
+
+    /* SMHasher's check: keys 0, 0 1, 0 1 2, ... seeded 256 - length,
+     * their hashes hashed again */
+    unsigned char key[256];
+    unsigned char hashes[256 * 16];
+
+    for (size_t i = 0; i < 256; ++i) {
+        str_hash128 h;
+
+        key[i] = (unsigned char) i;
+        h = str_murmur3((str_view) { (char const*) key, i },
+                (uint32_t) (256 - i));
+        put64(hashes + 16 * i, h.lo);
+        put64(hashes + 16 * i + 8, h.hi);
+    }
+
+    str_hash128 h = str_murmur3((str_view) {
+            (char const*) hashes, sizeof hashes }, 0);
+
+    assert_int_equal(h.lo & 0xffffffffu, 0x6384ba69u);
+
+    h = str_murmur3(str_view_of(""), 0);
+    assert_true(h.lo == 0 && h.hi == 0);
+}
+
+static void str_murmur3_stream_test(void** state) {
+    (void) state;
+
+    char buf[1000];
+
+    srand(43);
+
+    for (size_t i = 0; i < sizeof buf; ++i) {
+        buf[i] = (char) rand();
+    }
+
+    for (int round = 0; round < 200; ++round) {
+        size_t len = (size_t) rand() % sizeof buf;
+        str_hash128 whole = str_murmur3((str_view) { buf, len }, 7);
+        str_murmur3_state m;
+
+        str_murmur3_init(&m, 7);
+
+        for (size_t i = 0; i < len;) {
+            size_t n = (size_t) rand() % 40;
+
+            n = n < len - i ? n : len - i;
+            str_murmur3_update(&m, (str_view) { buf + i, n });
+            i += n;
+
+            /* finishing doesn't disturb the state */
+            str_hash128 part = str_murmur3_final(&m);
+            str_hash128 expected = str_murmur3((str_view) { buf, i }, 7);
+
+            assert_true(part.lo == expected.lo && part.hi == expected.hi);
+        }
+
+        str_hash128 h = str_murmur3_final(&m);
+
+        assert_true(h.lo == whole.lo && h.hi == whole.hi);
+    }
+}
+
+
+int main(void) {
+    struct CMUnitTest const tests[] = {
+        cmocka_unit_test(str_crc32c_test),
+        cmocka_unit_test(str_crc32c_stream_test),
+        cmocka_unit_test(str_murmur3_test),
+        cmocka_unit_test(str_murmur3_stream_test),
+    };
+
+
+    return cmocka_run_group_tests(tests, (void*) 0, (void*) 0);
+}
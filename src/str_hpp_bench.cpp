@@ -0,0 +1,154 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "str.hpp"
+
+/* Benchmark of strlib::str against the C functions it wraps and
+ * std::string, over the same work.
+ *
+ * Usage: str_hpp_bench [iterations] */
+
+/* keeps the compiler from dropping the results */
+static volatile std::size_t sink;
+
+static char const piece[] = "field=42;";
+
+/* pieces appended per string, longer than any small string buffer */
+static constexpr int PIECES = 16;
+
+template <typename F>
+static double measure(std::size_t n, F f) {
+    double best = 1e30;
+
+    for (int round = 0; round < 5; ++round) {
+        auto start = std::chrono::steady_clock::now();
+
+        for (std::size_t i = 0; i < n; ++i) {
+            f();
+        }
+
+        std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+        best = elapsed.count() / (double) n < best
+            ? elapsed.count() / (double) n
+            : best;
+    }
+
+    return best;
+}
+
+static void report(char const* name, double c, double hpp, double std) {
+    std::printf("%s,%.1f,%.1f,%.1f,%.2f\n", name, c, hpp, std, hpp / c);
+}
+
+int main(int argc, char const** argv) {
+    std::size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+    str_view v = { piece, sizeof piece - 1 };
+    std::string_view sv(piece, sizeof piece - 1);
+
+    std::printf("case,c_ns,hpp_ns,std_ns,hpp_over_c\n");
+
+    /* builds a string from pieces and frees it */
+    report("build",
+        measure(n, [&] {
+            str* s = str_new();
+
+            for (int i = 0; i < PIECES; ++i) {
+                str_append_view(s, v);
+            }
+
+            sink = str_len(s);
+            str_del(s);
+        }),
+        measure(n, [&] {
+            strlib::str s;
+
+            for (int i = 0; i < PIECES; ++i) {
+                s += sv;
+            }
+
+            sink = s.size();
+        }),
+        measure(n, [&] {
+            std::string s;
+
+            for (int i = 0; i < PIECES; ++i) {
+                s += sv;
+            }
+
+            sink = s.size();
+        }));
+
+    /* hands a string over to another owner and back */
+    str* c = str_new();
+    strlib::str hpp;
+    std::string std;
+
+    for (int i = 0; i < PIECES; ++i) {
+        str_append_view(c, v);
+        hpp += sv;
+        std += sv;
+    }
+
+    report("move",
+        measure(n, [&] {
+            str* other = c;
+
+            c = nullptr;
+            sink = str_len(other);
+            c = other;
+        }),
+        measure(n, [&] {
+            strlib::str other = std::move(hpp);
+
+            sink = other.size();
+            hpp = std::move(other);
+        }),
+        measure(n, [&] {
+            std::string other = std::move(std);
+
+            sink = other.size();
+            std = std::move(other);
+        }));
+
+    /* looks at the characters through std::string_view */
+    report("hash",
+        measure(n, [&] {
+            str_view view = str_view_from_str(c);
+
+            sink = std::hash<std::string_view>()({ view.data, view.len });
+        }),
+        measure(n, [&] {
+            sink = std::hash<strlib::str>()(hpp);
+        }),
+        measure(n, [&] {
+            sink = std::hash<std::string>()(std);
+        }));
+
+    str* c2 = str_clone(c);
+    strlib::str hpp2 = hpp.clone();
+    std::string std2 = std;
+
+    report("equal",
+        measure(n, [&] {
+            sink = str_equal(c, c2);
+        }),
+        measure(n, [&] {
+            sink = hpp == hpp2;
+        }),
+        measure(n, [&] {
+            sink = std == std2;
+        }));
+
+    str_del(c);
+    str_del(c2);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,139 @@
+#include <cassert>
+#include <csetjmp>
+#include <cstdarg>
+#include <cstddef>
+#include <new>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <cmocka.h>
+
+#include "str.hpp"
+
+static_assert(!std::is_copy_constructible_v<strlib::str>);
+static_assert(!std::is_copy_assignable_v<strlib::str>);
+static_assert(std::is_nothrow_move_constructible_v<strlib::str>);
+static_assert(std::is_nothrow_move_assignable_v<strlib::str>);
+static_assert(std::is_convertible_v<strlib::str, std::string_view>);
+static_assert(sizeof (strlib::str) == sizeof (str*));
+
+/* c_str writes the null, a const str only hands out views */
+template <typename T, typename = void>
+struct has_c_str : std::false_type {};
+
+template <typename T>
+struct has_c_str<T, std::void_t<decltype(std::declval<T&>().c_str())>>
+    : std::true_type {};
+
+static_assert(has_c_str<strlib::str>::value);
+static_assert(!has_c_str<strlib::str const>::value);
+
+static void str_hpp_basics_test(void** state) {
+    (void) state;
+
+    strlib::str s("Hello");
+
+    s += ", ";
+    s += std::string("world");
+    s += '!';
+
+    assert_int_equal(s.size(), 13);
+    assert_false(s.empty());
+    assert_string_equal(s.c_str(), "Hello, world!");
+    assert_true(s == "Hello, world!");
+    assert_true("Hello, world!" == s);
+    assert_true(s != std::string_view("Hello"));
+
+    std::string_view v = s;
+
+    assert_ptr_equal(v.data(), str_cstr(s.get()));
+    assert_int_equal(v.size(), 13);
+
+    /* capacity is kept */
+    char const* data = v.data();
+
+    s.clear();
+    assert_true(s.empty());
+    s.append("Hi");
+    assert_ptr_equal(std::string_view(s).data(), data);
+
+    strlib::str empty;
+
+    assert_true(empty.empty());
+    assert_true(empty == "");
+    assert_true(strlib::str("a") < strlib::str("b"));
+}
+
+static void str_hpp_move_test(void** state) {
+    (void) state;
+
+    strlib::str a("payload");
+    str* raw = a.get();
+    strlib::str b = std::move(a);
+
+    /* the str object itself moved, nothing was copied */
+    assert_ptr_equal(b.get(), raw);
+    assert_null(a.get());
+    assert_true(a.empty());
+    assert_string_equal(a.c_str(), "");
+
+    /* a moved from str can be used again */
+    a += "again";
+    assert_true(a == "again");
+
+    a = std::move(b);
+    assert_ptr_equal(a.get(), raw);
+    assert_true(a == "payload");
+
+    strlib::str c = a.clone();
+
+    assert_true(c == a);
+    assert_ptr_not_equal(c.get(), a.get());
+
+    std::vector<strlib::str> v;
+
+    for (int i = 0; i < 100; ++i) {
+        v.emplace_back(std::to_string(i));
+    }
+
+    assert_true(v[42] == "42");
+
+    str* released = c.release();
+
+    assert_null(c.get());
+
+    strlib::str adopted = strlib::str::adopt(released);
+
+    assert_true(adopted == "payload");
+}
+
+static void str_hpp_hash_test(void** state) {
+    (void) state;
+
+    std::unordered_set<strlib::str> set;
+
+    set.insert(strlib::str("one"));
+    set.insert(strlib::str("two"));
+    set.insert(strlib::str("one"));
+
+    assert_int_equal(set.size(), 2);
+    assert_true(set.count(strlib::str("two")));
+    assert_int_equal(std::hash<strlib::str>()(strlib::str("key")),
+            std::hash<std::string_view>()("key"));
+}
+
+
+int main(void) {
+    struct CMUnitTest const tests[] = {
+        cmocka_unit_test(str_hpp_basics_test),
+        cmocka_unit_test(str_hpp_move_test),
+        cmocka_unit_test(str_hpp_hash_test),
+    };
+
+
+    return cmocka_run_group_tests(tests, (void*) 0, (void*) 0);
+}
@@ -0,0 +1,605 @@
+#include <assert.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "str_index.h"
+#include "str_private.h"
+
+/* chunks of the LCP computation smaller than this are not worth a thread */
+static const size_t STR_INDEX_MIN_CHUNK = 1 << 16;
+
+static const char STR_INDEX_MAGIC[8] = "STRINDEX";
+
+/* an unfilled slot of the suffix array under construction */
+#define EMPTY SIZE_MAX
+
+struct str_index {
+    str_view text;
+    /* sa[r] is the start of the suffix of rank r */
+    size_t* sa;
+    /* lcp[r] is the longest common prefix of the suffixes
+     * of rank r - 1 and r, lcp[0] is zero */
+    size_t* lcp;
+    /* rank of the longest repeat */
+    size_t repeat;
+};
+
+/* the string sorted by SA-IS, either the characters shifted up by one
+ * followed by a zero sentinel, or the names of a reduced level, which
+ * end in their own unique zero */
+struct text {
+    unsigned char const* bytes;
+    size_t const* names;
+    size_t n;
+};
+
+struct lcp_job {
+    str_view text;
+    size_t const* sa;
+    size_t* rank;
+    size_t* lcp;
+    size_t chunk;
+};
+
+/* -- Private Interface -- */
+
+static size_t chr(struct text const* s, size_t i) {
+    if (s->names) {
+        return s->names[i];
+    }
+
+    return i + 1 < s->n ? (size_t) s->bytes[i] + 1 : 0;
+}
+
+/* a leftmost S-type position, t[i] is true for S-type */
+static bool lms(unsigned char const* t, size_t i) {
+    return i != EMPTY && i > 0 && t[i] && !t[i - 1];
+}
+
+static void buckets(struct text const* s, size_t* bkt, size_t k, bool end) {
+    memset(bkt, 0, k * sizeof (size_t));
+
+    for (size_t i = 0; i < s->n; ++i) {
+        bkt[chr(s, i)]++;
+    }
+
+    for (size_t c = 0, sum = 0; c < k; ++c) {
+        size_t count = bkt[c];
+
+        sum += count;
+        bkt[c] = end ? sum : sum - count;
+    }
+}
+
+static void induce(struct text const* s, unsigned char const* t, size_t* sa,
+        size_t* bkt, size_t k) {
+    size_t n = s->n;
+
+    /* L-type suffixes from the left, at the start of their buckets */
+    buckets(s, bkt, k, false);
+
+    for (size_t i = 0; i < n; ++i) {
+        size_t j = sa[i];
+
+        if (j != EMPTY && j > 0 && !t[j - 1]) {
+            sa[bkt[chr(s, j - 1)]++] = j - 1;
+        }
+    }
+
+    /* S-type suffixes from the right, at the end of their buckets */
+    buckets(s, bkt, k, true);
+
+    for (size_t i = n; i > 0; --i) {
+        size_t j = sa[i - 1];
+
+        if (j != EMPTY && j > 0 && t[j - 1]) {
+            sa[--bkt[chr(s, j - 1)]] = j - 1;
+        }
+    }
+}
+
+/* sorts the suffixes of s over an alphabet of k characters,
+ * see Nong, Zhang and Chan, Two Efficient Algorithms for Linear
+ * Time Suffix Array Construction */
+static bool sais(struct text const* s, size_t* sa, size_t k) {
+    size_t n = s->n;
+    unsigned char* t = malloc(n);
+    size_t* bkt = malloc(k * sizeof (size_t));
+
+    if (!t || !bkt) {
+        free(t);
+        free(bkt);
+        return false;
+    }
+
+    /* classifies the suffixes, the sentinel is S-type */
+    t[n - 1] = 1;
+
+    for (size_t i = n - 1; i > 0; --i) {
+        size_t a = chr(s, i - 1);
+        size_t b = chr(s, i);
+
+        t[i - 1] = a < b || (a == b && t[i]);
+    }
+
+    /* sorts the LMS substrings by inducing from their unsorted starts */
+    buckets(s, bkt, k, true);
+
+    for (size_t i = 0; i < n; ++i) {
+        sa[i] = EMPTY;
+    }
+
+    for (size_t i = 1; i < n; ++i) {
+        if (lms(t, i)) {
+            sa[--bkt[chr(s, i)]] = i;
+        }
+    }
+
+    induce(s, t, sa, bkt, k);
+
+    size_t n1 = 0;
+
+    for (size_t i = 0; i < n; ++i) {
+        if (lms(t, sa[i])) {
+            sa[n1++] = sa[i];
+        }
+    }
+
+    /* names the LMS substrings, equal ones share a name, and stores
+     * them by position in the upper half, LMS positions are at
+     * least two apart so pos / 2 never collides */
+    for (size_t i = n1; i < n; ++i) {
+        sa[i] = EMPTY;
+    }
+
+    size_t names = 0;
+    size_t prev = EMPTY;
+
+    for (size_t i = 0; i < n1; ++i) {
+        size_t pos = sa[i];
+        bool diff = false;
+
+        for (size_t d = 0;; ++d) {
+            if (prev == EMPTY || chr(s, pos + d) != chr(s, prev + d)
+                    || t[pos + d] != t[prev + d]) {
+                diff = true;
+                break;
+            }
+
+            if (d > 0 && (lms(t, pos + d) || lms(t, prev + d))) {
+                break;
+            }
+        }
+
+        if (diff) {
+            names++;
+            prev = pos;
+        }
+
+        sa[n1 + pos / 2] = names - 1;
+    }
+
+    for (size_t i = n, j = n; i > n1; --i) {
+        if (sa[i - 1] != EMPTY) {
+            sa[--j] = sa[i - 1];
+        }
+    }
+
+    /* sorts the reduced string, recursing unless the names are unique */
+    size_t* s1 = sa + n - n1;
+    size_t* sa1 = sa;
+
+    if (names < n1) {
+        struct text reduced = { (void*) 0, s1, n1 };
+
+        if (!sais(&reduced, sa1, names)) {
+            free(t);
+            free(bkt);
+            return false;
+        }
+    } else {
+        for (size_t i = 0; i < n1; ++i) {
+            sa1[s1[i]] = i;
+        }
+    }
+
+    /* induces the full order from the sorted LMS suffixes */
+    for (size_t i = 1, j = 0; i < n; ++i) {
+        if (lms(t, i)) {
+            s1[j++] = i;
+        }
+    }
+
+    for (size_t i = 0; i < n1; ++i) {
+        sa1[i] = s1[sa1[i]];
+    }
+
+    for (size_t i = n1; i < n; ++i) {
+        sa[i] = EMPTY;
+    }
+
+    buckets(s, bkt, k, true);
+
+    for (size_t i = n1; i > 0; --i) {
+        size_t j = sa[i - 1];
+
+        sa[i - 1] = EMPTY;
+        sa[--bkt[chr(s, j)]] = j;
+    }
+
+    induce(s, t, sa, bkt, k);
+
+    free(t);
+    free(bkt);
+
+    return true;
+}
+
+static void range(struct lcp_job const* job, size_t i, size_t* begin,
+        size_t* end) {
+    size_t n = job->text.len;
+
+    *begin = i * job->chunk;
+    *end = *begin + job->chunk < n ? *begin + job->chunk : n;
+}
+
+static void rank_task(void* ctx, size_t i) {
+    struct lcp_job* job = ctx;
+    size_t begin, end;
+
+    range(job, i, &begin, &end);
+
+    for (size_t r = begin; r < end; ++r) {
+        job->rank[job->sa[r]] = r;
+    }
+}
+
+/* Kasai's algorithm over the positions of one chunk, which restarts
+ * from zero at the chunk start but writes disjoint entries of lcp */
+static void lcp_task(void* ctx, size_t i) {
+    struct lcp_job* job = ctx;
+    char const* text = job->text.data;
+    size_t n = job->text.len;
+    size_t begin, end;
+
+    range(job, i, &begin, &end);
+
+    for (size_t p = begin, h = 0; p < end; ++p) {
+        size_t r = job->rank[p];
+
+        if (!r) {
+            job->lcp[r] = 0;
+            h = 0;
+            continue;
+        }
+
+        size_t q = job->sa[r - 1];
+
+        while (p + h < n && q + h < n && text[p + h] == text[q + h]) {
+            h++;
+        }
+
+        job->lcp[r] = h;
+
+        if (h) {
+            h--;
+        }
+    }
+}
+
+static bool lcp(str_par_pool* pool, struct str_index* self) {
+    assert(self != (void*) 0);
+
+    size_t n = self->text.len;
+    size_t threads = str_par_pool_threads(pool);
+    size_t chunk = (n + threads * 4 - 1) / (threads * 4);
+
+    if (chunk < STR_INDEX_MIN_CHUNK) {
+        chunk = STR_INDEX_MIN_CHUNK;
+    }
+
+    struct lcp_job job = {
+        self->text, self->sa, malloc(n * sizeof (size_t)), self->lcp, chunk,
+    };
+
+    if (!job.rank) {
+        return false;
+    }
+
+    size_t chunks = (n + chunk - 1) / chunk;
+
+    str_par_run(pool, rank_task, &job, chunks);
+    str_par_run(pool, lcp_task, &job, chunks);
+
+    free(job.rank);
+
+    return true;
+}
+
+static void find_repeat(struct str_index* self) {
+    assert(self != (void*) 0);
+
+    self->repeat = 0;
+
+    for (size_t r = 1; r < self->text.len; ++r) {
+        if (self->lcp[r] > self->lcp[self->repeat]) {
+            self->repeat = r;
+        }
+    }
+}
+
+static struct str_index* alloc(str* s) {
+    if (!s) {
+        return (void*) 0;
+    }
+
+    str_view text = str_view_from_str(s);
+
+    /* overflow, leaving room for the sentinel */
+    if (text.len >= SIZE_MAX / sizeof (size_t) - 1) {
+        return (void*) 0;
+    }
+
+    struct str_index* self = malloc(sizeof (struct str_index));
+
+    if (!self) {
+        return (void*) 0;
+    }
+
+    self->text = text;
+    self->sa = malloc((text.len + 1) * sizeof (size_t));
+    self->lcp = malloc((text.len + 1) * sizeof (size_t));
+    self->repeat = 0;
+
+    if (!self->sa || !self->lcp) {
+        str_index_del(self);
+        return (void*) 0;
+    }
+
+    return self;
+}
+
+/* compares the suffix at pos with needle, a suffix starting
+ * with needle compares equal */
+static int cmp_suffix(struct str_index const* self, size_t pos,
+        str_view needle) {
+    size_t left = self->text.len - pos;
+    size_t m = left < needle.len ? left : needle.len;
+    int c = memcmp(self->text.data + pos, needle.data, m);
+
+    if (c) {
+        return c;
+    }
+
+    return left < needle.len ? -1 : 0;
+}
+
+/* ranks [*lo, *hi) of the suffixes starting with needle */
+static void search(struct str_index const* self, str_view needle,
+        size_t* lo, size_t* hi) {
+    size_t a = 0;
+    size_t b = self->text.len;
+
+    while (a < b) {
+        size_t mid = a + (b - a) / 2;
+
+        if (cmp_suffix(self, self->sa[mid], needle) < 0) {
+            a = mid + 1;
+        } else {
+            b = mid;
+        }
+    }
+
+    *lo = a;
+    b = self->text.len;
+
+    while (a < b) {
+        size_t mid = a + (b - a) / 2;
+
+        if (cmp_suffix(self, self->sa[mid], needle) <= 0) {
+            a = mid + 1;
+        } else {
+            b = mid;
+        }
+    }
+
+    *hi = a;
+}
+
+static int cmp_position(void const* a, void const* b) {
+    size_t x = *(size_t const*) a;
+    size_t y = *(size_t const*) b;
+
+    return x < y ? -1 : x > y;
+}
+
+static uint64_t checksum(str_view v) {
+    return str_fnv1a(STR_FNV1A_BASIS, v.data, v.len);
+}
+
+static bool append_u64(str* out, uint64_t value) {
+    return str_append_view(out, (str_view) { (char const*) &value,
+        sizeof value });
+}
+
+static uint64_t read_u64(char const* p) {
+    uint64_t value;
+
+    memcpy(&value, p, sizeof value);
+
+    return value;
+}
+
+/* -- Public Interface Implementation -- */
+
+str_index* str_index_build(str* s) {
+    return str_index_build_par((void*) 0, s);
+}
+
+str_index* str_index_build_par(str_par_pool* pool, str* s) {
+    struct str_index* self = alloc(s);
+
+    if (!self) {
+        return (void*) 0;
+    }
+
+    size_t n = self->text.len;
+
+    if (!n) {
+        return self;
+    }
+
+    struct text text = {
+        (unsigned char const*) self->text.data, (void*) 0, n + 1,
+    };
+
+    /* the sentinel sorts first, the rest is the suffix array */
+    if (!sais(&text, self->sa, UCHAR_MAX + 2)) {
+        str_index_del(self);
+        return (void*) 0;
+    }
+
+    memmove(self->sa, self->sa + 1, n * sizeof (size_t));
+
+    if (!lcp(pool, self)) {
+        str_index_del(self);
+        return (void*) 0;
+    }
+
+    find_repeat(self);
+
+    return self;
+}
+
+void str_index_del(str_index* self) {
+    if (!self) {
+        return;
+    }
+
+    free(self->sa);
+    free(self->lcp);
+    free(self);
+}
+
+size_t str_index_count(str_index* self, str_view needle) {
+    if (!self || !needle.len || !needle.data) {
+        return 0;
+    }
+
+    size_t lo, hi;
+
+    search(self, needle, &lo, &hi);
+
+    return hi - lo;
+}
+
+bool str_index_find_all(str_index* self, str_view needle,
+        size_t** positions, size_t* n) {
+    if (!self || !positions || !n || (!needle.data && needle.len)) {
+        return false;
+    }
+
+    size_t lo = 0;
+    size_t hi = 0;
+
+    if (needle.len) {
+        search(self, needle, &lo, &hi);
+    }
+
+    *n = hi - lo;
+    *positions = malloc((*n ? *n : 1) * sizeof (size_t));
+
+    if (!*positions) {
+        *n = 0;
+        return false;
+    }
+
+    if (*n) {
+        memcpy(*positions, self->sa + lo, *n * sizeof (size_t));
+        qsort(*positions, *n, sizeof (size_t), cmp_position);
+    }
+
+    return true;
+}
+
+str_view str_index_longest_repeat(str_index* self) {
+    if (!self || !self->text.len || !self->lcp[self->repeat]) {
+        return (str_view) { "", 0 };
+    }
+
+    return (str_view) {
+        self->text.data + self->sa[self->repeat], self->lcp[self->repeat],
+    };
+}
+
+bool str_index_save(str_index* self, str* out) {
+    if (!self || !out) {
+        return false;
+    }
+
+    size_t n = self->text.len;
+
+    /* overflow */
+    if (n > (SIZE_MAX - 24) / 16) {
+        return false;
+    }
+
+    if (!str_reserve(out, 24 + 16 * n)
+            || !str_append_view(out, (str_view) { STR_INDEX_MAGIC, 8 })
+            || !append_u64(out, n)
+            || !append_u64(out, checksum(self->text))) {
+        return false;
+    }
+
+    for (size_t r = 0; r < n; ++r) {
+        append_u64(out, self->sa[r]);
+    }
+
+    for (size_t r = 0; r < n; ++r) {
+        append_u64(out, self->lcp[r]);
+    }
+
+    return true;
+}
+
+str_index* str_index_load(str* s, str_view data) {
+    struct str_index* self = alloc(s);
+
+    if (!self) {
+        return (void*) 0;
+    }
+
+    size_t n = self->text.len;
+
+    if (!data.data || data.len < 24 || (data.len - 24) / 16 != n
+            || (data.len - 24) % 16
+            || memcmp(data.data, STR_INDEX_MAGIC, 8)
+            || read_u64(data.data + 8) != n
+            || read_u64(data.data + 16) != checksum(self->text)) {
+        str_index_del(self);
+        return (void*) 0;
+    }
+
+    char const* sa = data.data + 24;
+    char const* lcp = sa + 8 * n;
+
+    /* bounds every entry so malformed data can't reach past the text */
+    for (size_t r = 0; r < n; ++r) {
+        uint64_t pos = read_u64(sa + 8 * r);
+        uint64_t len = read_u64(lcp + 8 * r);
+
+        if (pos >= n || len > n - pos) {
+            str_index_del(self);
+            return (void*) 0;
+        }
+
+        self->sa[r] = (size_t) pos;
+        self->lcp[r] = (size_t) len;
+    }
+
+    find_repeat(self);
+
+    return self;
+}
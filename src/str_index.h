@@ -0,0 +1,136 @@
+/** str's Suffix Array Index
+ * @file str_index.h */
+#ifndef STR_INDEX_H
+#define STR_INDEX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "str.h"
+#include "str_par.h"
+
+/** Opaque str_index Structure
+ * @note       It holds the suffix array and the LCP array of a str,
+ *             and answers substring queries in O(m log n). */
+typedef struct str_index str_index;
+
+/** Builds index of str.
+ * @warning    The user has to free the object after usage with
+ *             str_index_del.
+ *
+ * @warning    The index refers to the characters of s, which must
+ *             not be modified or deleted while the index is in use.
+ *
+ * @note       The suffix array is built by SA-IS in linear time.
+ *
+ * @param s    A pointer to a str object.
+ *
+ * @return     A pointer to a str_index object.
+ *
+ * @see str_index_build_par str_index_del */
+str_index* str_index_build(str* s);
+
+/** Builds index of str in parallel.
+ * @warning    The user has to free the object after usage with
+ *             str_index_del.
+ *
+ * @warning    The index refers to the characters of s, which must
+ *             not be modified or deleted while the index is in use.
+ *
+ * @note       SA-IS runs in the calling thread, the LCP array is
+ *             computed across the pool.
+ *
+ * @note       If the pool is null, it runs in the calling thread.
+ *
+ * @param pool A pointer to a str_par_pool object.
+ * @param s    A pointer to a str object.
+ *
+ * @return     A pointer to a str_index object.
+ *
+ * @see str_index_build str_index_del */
+str_index* str_index_build_par(str_par_pool* pool, str* s);
+
+/** Deletes index.
+ * @param self A pointer to a str_index object. */
+void str_index_del(str_index* self);
+
+/** Counts occurrences of a needle.
+ * @note       Occurrences may overlap, so "aaaa" contains
+ *             three occurrences of "aa".
+ *
+ * @note       An empty needle has no occurrences.
+ *
+ * @param self   A pointer to a str_index object.
+ * @param needle A view to search for.
+ *
+ * @return       Number of occurrences.
+ *
+ * @see str_index_find_all */
+size_t str_index_count(str_index* self, str_view needle);
+
+/** Finds all occurrences of a needle.
+ * @warning    The user has to free the positions after usage with
+ *             free.
+ *
+ * @note       Occurrences may overlap, as in str_par_find_all.
+ *
+ * @note       An empty needle has no occurrences.
+ *
+ * @param self      A pointer to a str_index object.
+ * @param needle    A view to search for.
+ * @param positions Receives an ascending array of indexes.
+ * @param n         Receives the number of indexes.
+ *
+ * @return          true if successful.
+ *
+ * @see str_index_count */
+bool str_index_find_all(str_index* self, str_view needle,
+        size_t** positions, size_t* n);
+
+/** Returns longest substring occurring at least twice.
+ * @note       The occurrences may overlap, and the first one in suffix
+ *             order is returned.
+ *
+ * @param self A pointer to a str_index object.
+ *
+ * @return     A view into the indexed str, empty if no character
+ *             repeats. */
+str_view str_index_longest_repeat(str_index* self);
+
+/** Appends serialized index to str.
+ * @note       The characters of the indexed str are not included,
+ *             only their length and checksum.
+ *
+ * @param self A pointer to a str_index object.
+ * @param out  A pointer to a str object.
+ *
+ * @return     true if successful.
+ *
+ * @see str_index_load */
+bool str_index_save(str_index* self, str* out);
+
+/** Loads serialized index of str.
+ * @warning    The user has to free the object after usage with
+ *             str_index_del.
+ *
+ * @warning    The index refers to the characters of s, which must
+ *             not be modified or deleted while the index is in use.
+ *
+ * @param s    A pointer to the str object the index was built from.
+ * @param data A view over the output of str_index_save.
+ *
+ * @return     A pointer to a str_index object or null if data is
+ *             malformed or was built from a different str.
+ *
+ * @see str_index_save str_index_del */
+str_index* str_index_load(str* s, str_view data);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* STR_INDEX_H */
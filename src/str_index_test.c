@@ -0,0 +1,210 @@
+#include <assert.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cmocka.h>
+
+#include "str.h"
+#include "str_index.h"
+#include "str_par.h"
+
+/* big enough to be split in several LCP chunks */
+static const size_t CORPUS_SIZE = 1 << 18;
+
+static str* random_str(size_t size, char const* alphabet, size_t k) {
+    str* s = str_new();
+
+    str_reserve(s, size);
+
+    for (size_t i = 0; i < size; ++i) {
+        str_append_char(s, alphabet[(size_t) rand() % k]);
+    }
+
+    return s;
+}
+
+static size_t naive_count(str* s, str_view needle) {
+    str_view hay = str_view_of(s);
+    size_t count = 0;
+
+    for (size_t i = 0; needle.len && i + needle.len <= hay.len; ++i) {
+        count += !memcmp(hay.data + i, needle.data, needle.len);
+    }
+
+    return count;
+}
+
+/* length of the longest substring occurring twice */
+static size_t naive_repeat(str* s) {
+    str_view v = str_view_of(s);
+    size_t best = 0;
+
+    for (size_t i = 0; i < v.len; ++i) {
+        for (size_t j = i + 1; j < v.len; ++j) {
+            size_t h = 0;
+
+            while (j + h < v.len && v.data[i + h] == v.data[j + h]) {
+                h++;
+            }
+
+            best = h > best ? h : best;
+        }
+    }
+
+    return best;
+}
+
+static void str_index_empty_test(void** state) {
+    (void) state;
+
+    str* s = str_new();
+    str_index* index = str_index_build(s);
+    size_t* positions;
+    size_t n;
+
+    assert_non_null(index);
+    assert_int_equal(str_index_count(index, str_view_of("a")), 0);
+    assert_int_equal(str_index_longest_repeat(index).len, 0);
+    assert_true(str_index_find_all(index, str_view_of("a"), &positions, &n));
+    assert_int_equal(n, 0);
+
+    free(positions);
+    str_index_del(index);
+    str_index_del((void*) 0);
+    str_del(s);
+}
+
+static void str_index_find_test(void** state) {
+    (void) state;
+
+    str* s = str_from("banana bandana");
+    str_index* index = str_index_build(s);
+    size_t* positions;
+    size_t n;
+
+    assert_int_equal(str_index_count(index, str_view_of("an")), 4);
+    assert_int_equal(str_index_count(index, str_view_of("ana")), 3);
+    assert_int_equal(str_index_count(index, str_view_of("banana bandana")), 1);
+    assert_int_equal(str_index_count(index, str_view_of("bandanas")), 0);
+    assert_int_equal(str_index_count(index, str_view_of("x")), 0);
+    assert_int_equal(str_index_count(index, str_view_of("")), 0);
+
+    assert_true(str_index_find_all(index, str_view_of("ana"), &positions,
+                &n));
+    assert_int_equal(n, 3);
+    assert_int_equal(positions[0], 1);
+    assert_int_equal(positions[1], 3);
+    assert_int_equal(positions[2], 11);
+    free(positions);
+
+    str_view repeat = str_index_longest_repeat(index);
+
+    /* "ana" or "ban" */
+    assert_int_equal(repeat.len, 3);
+    assert_true(naive_count(s, repeat) >= 2);
+
+    str_index_del(index);
+    str_del(s);
+}
+
+static void str_index_random_test(void** state) {
+    (void) state;
+
+    srand(35);
+
+    for (int round = 0; round < 50; ++round) {
+        str* s = random_str((size_t) rand() % 200, "ab\0c",
+                round % 2 ? 2 : 4);
+        str_index* index = str_index_build(s);
+
+        assert_non_null(index);
+        assert_int_equal(str_index_longest_repeat(index).len,
+                naive_repeat(s));
+
+        for (int query = 0; query < 20; ++query) {
+            str* needle = random_str(1 + (size_t) rand() % 4, "ab\0c", 4);
+
+            assert_int_equal(str_index_count(index, str_view_of(needle)),
+                    naive_count(s, str_view_of(needle)));
+            str_del(needle);
+        }
+
+        str_index_del(index);
+        str_del(s);
+    }
+}
+
+static void str_index_par_test(void** state) {
+    (void) state;
+
+    srand(1);
+
+    str* s = random_str(CORPUS_SIZE, "ab", 2);
+    str_par_pool* pool = str_par_pool_new(4);
+    str_index* serial = str_index_build(s);
+    str_index* parallel = str_index_build_par(pool, s);
+    str* a = str_new();
+    str* b = str_new();
+
+    /* the serialized forms hold the whole suffix and LCP arrays */
+    assert_true(str_index_save(serial, a));
+    assert_true(str_index_save(parallel, b));
+    assert_true(str_equal(a, b));
+
+    str_view needle = str_view_of("abbabaab");
+
+    assert_int_equal(str_index_count(parallel, needle),
+            naive_count(s, needle));
+
+    str_index_del(serial);
+    str_index_del(parallel);
+    str_par_pool_del(pool);
+    str_del(a);
+    str_del(b);
+    str_del(s);
+}
+
+static void str_index_save_test(void** state) {
+    (void) state;
+
+    str* s = str_from("mississippi");
+    str* other = str_from("mississippa");
+    str_index* index = str_index_build(s);
+    str* data = str_new();
+
+    assert_true(str_index_save(index, data));
+    assert_int_equal(str_len(data), 24 + 16 * 11);
+
+    str_index* loaded = str_index_load(s, str_view_of(data));
+
+    assert_non_null(loaded);
+    assert_int_equal(str_index_count(loaded, str_view_of("issi")), 2);
+    assert_int_equal(str_index_longest_repeat(loaded).len, 4);
+
+    /* refuses another str and truncated data */
+    assert_null(str_index_load(other, str_view_of(data)));
+    assert_null(str_index_load(s, (str_view) { str_cstr(data), 100 }));
+
+    str_index_del(loaded);
+    str_index_del(index);
+    str_del(data);
+    str_del(other);
+    str_del(s);
+}
+
+
+int main(void) {
+    struct CMUnitTest const tests[] = {
+        cmocka_unit_test(str_index_empty_test),
+        cmocka_unit_test(str_index_find_test),
+        cmocka_unit_test(str_index_random_test),
+        cmocka_unit_test(str_index_par_test),
+        cmocka_unit_test(str_index_save_test),
+    };
+
+
+    return cmocka_run_group_tests(tests, (void*) 0, (void*) 0);
+}
@@ -0,0 +1,506 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "str_lines.h"
+#include "str_simd.h"
+
+/* a full offset is kept every BLOCK lines */
+#define BLOCK 64
+
+/* newlines gathered per scan */
+#define FOUND 256
+
+/* bytes per task of a parallel build */
+#define CHUNK ((size_t) 1 << 20)
+
+struct str_line_index {
+    str* s;
+    /* characters indexed */
+    size_t len;
+
+    /* line starts, at 0 and one past every \n, and room for them */
+    size_t starts;
+    size_t max;
+
+    /* the low 32 bits of every start and every BLOCK-th start in full,
+     * or if a block spans 4 GiB or more, every start in full */
+    bool wide;
+    uint32_t* low;
+    size_t* base;
+    size_t* offsets;
+};
+
+/* -- Private Interface -- */
+
+/* -- Newline Kernels -- */
+
+#ifdef STR_SIMD_X86
+
+STR_SIMD_TARGET("avx2")
+static size_t scan_avx2(char const* s, size_t i, size_t n, size_t* found,
+        size_t* k) {
+    __m256i const nl = _mm256_set1_epi8('\n');
+    size_t j = *k;
+
+    for (; i + 32 <= n && j + 32 <= FOUND; i += 32) {
+        uint32_t mask = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(
+                    _mm256_loadu_si256((__m256i const*) (s + i)), nl));
+
+        for (; mask; mask &= mask - 1) {
+            found[j++] = i + (size_t) __builtin_ctz(mask);
+        }
+    }
+
+    *k = j;
+
+    return i;
+}
+
+static size_t scan_sse2(char const* s, size_t i, size_t n, size_t* found,
+        size_t* k) {
+    __m128i const nl = _mm_set1_epi8('\n');
+    size_t j = *k;
+
+    for (; i + 16 <= n && j + 16 <= FOUND; i += 16) {
+        unsigned mask = (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(
+                    _mm_loadu_si128((__m128i const*) (s + i)), nl));
+
+        for (; mask; mask &= mask - 1) {
+            found[j++] = i + (size_t) __builtin_ctz(mask);
+        }
+    }
+
+    *k = j;
+
+    return i;
+}
+
+STR_SIMD_TARGET("avx2")
+static size_t count_avx2(char const* s, size_t n, size_t* count) {
+    __m256i const nl = _mm256_set1_epi8('\n');
+    size_t i = 0;
+    size_t c = 0;
+
+    for (; i + 32 <= n; i += 32) {
+        c += (size_t) __builtin_popcount((unsigned) _mm256_movemask_epi8(
+                    _mm256_cmpeq_epi8(
+                        _mm256_loadu_si256((__m256i const*) (s + i)), nl)));
+    }
+
+    *count += c;
+
+    return i;
+}
+
+static size_t count_sse2(char const* s, size_t i, size_t n, size_t* count) {
+    __m128i const nl = _mm_set1_epi8('\n');
+    size_t c = 0;
+
+    for (; i + 16 <= n; i += 16) {
+        c += (size_t) __builtin_popcount((unsigned) _mm_movemask_epi8(
+                    _mm_cmpeq_epi8(
+                        _mm_loadu_si128((__m128i const*) (s + i)), nl)));
+    }
+
+    *count += c;
+
+    return i;
+}
+
+#endif /* STR_SIMD_X86 */
+
+/* gathers positions of newlines of [i, n) into found from k on until
+ * it fills up, and returns where it stopped */
+static size_t scan(enum str_simd simd, char const* s, size_t i, size_t n,
+        size_t* found, size_t* k) {
+#ifdef STR_SIMD_X86
+    if (simd == STR_SIMD_AVX2) {
+        i = scan_avx2(s, i, n, found, k);
+    }
+
+    i = scan_sse2(s, i, n, found, k);
+#else
+    (void) simd;
+#endif /* STR_SIMD_X86 */
+
+    /* the tail, or elsewhere everything */
+    while (i < n && *k < FOUND) {
+        char const* p = memchr(s + i, '\n', n - i);
+
+        if (!p) {
+            return n;
+        }
+
+        found[(*k)++] = (size_t) (p - s);
+        i = (size_t) (p - s) + 1;
+    }
+
+    return i;
+}
+
+static size_t count(enum str_simd simd, char const* s, size_t n) {
+    size_t c = 0;
+    size_t i = 0;
+
+#ifdef STR_SIMD_X86
+    if (simd == STR_SIMD_AVX2) {
+        i = count_avx2(s, n, &c);
+    }
+
+    i = count_sse2(s, i, n, &c);
+#else
+    (void) simd;
+#endif /* STR_SIMD_X86 */
+
+    for (char const* p; i < n && (p = memchr(s + i, '\n', n - i));) {
+        c++;
+        i = (size_t) (p - s) + 1;
+    }
+
+    return c;
+}
+
+/* -- Offsets -- */
+
+static size_t start(str_line_index const* self, size_t i) {
+    if (self->wide) {
+        return self->offsets[i];
+    }
+
+    size_t base = self->base[i / BLOCK];
+
+    /* the start is less than 4 GiB past the base */
+    return base + (uint32_t) (self->low[i] - (uint32_t) base);
+}
+
+static void set(str_line_index* self, size_t i, size_t offset) {
+    if (self->wide) {
+        self->offsets[i] = offset;
+        return;
+    }
+
+    self->low[i] = (uint32_t) offset;
+
+    if (i % BLOCK == 0) {
+        self->base[i / BLOCK] = offset;
+    }
+}
+
+static bool grow(str_line_index* self, size_t n) {
+    if (n <= self->max) {
+        return true;
+    }
+
+    size_t max = self->max ? self->max : BLOCK;
+
+    while (max < n) {
+        /* overflow */
+        if (max > SIZE_MAX / 2 / sizeof (size_t)) {
+            return false;
+        }
+
+        max *= 2;
+    }
+
+    if (self->wide) {
+        size_t* offsets = realloc(self->offsets, max * sizeof (size_t));
+
+        if (!offsets) {
+            return false;
+        }
+
+        self->offsets = offsets;
+    } else {
+        uint32_t* low = realloc(self->low, max * sizeof (uint32_t));
+
+        if (!low) {
+            return false;
+        }
+
+        self->low = low;
+
+        size_t* base = realloc(self->base, max / BLOCK * sizeof (size_t));
+
+        if (!base) {
+            return false;
+        }
+
+        self->base = base;
+    }
+
+    self->max = max;
+
+    return true;
+}
+
+/* switches to full offsets */
+static bool widen(str_line_index* self) {
+    size_t* offsets = malloc(self->max * sizeof (size_t));
+
+    if (!offsets) {
+        return false;
+    }
+
+    for (size_t i = 0; i < self->starts; ++i) {
+        offsets[i] = start(self, i);
+    }
+
+    free(self->low);
+    free(self->base);
+
+    self->low = (void*) 0;
+    self->base = (void*) 0;
+    self->offsets = offsets;
+    self->wide = true;
+
+    return true;
+}
+
+static bool push(str_line_index* self, size_t offset) {
+    size_t i = self->starts;
+
+    if (!grow(self, i + 1)) {
+        return false;
+    }
+
+    if (!self->wide && i % BLOCK
+            && offset - self->base[i / BLOCK] > UINT32_MAX && !widen(self)) {
+        return false;
+    }
+
+    set(self, i, offset);
+    self->starts++;
+
+    return true;
+}
+
+/* forgets everything but the first line */
+static bool reset(str_line_index* self) {
+    free(self->low);
+    free(self->base);
+    free(self->offsets);
+
+    self->len = 0;
+    self->starts = 0;
+    self->max = 0;
+    self->wide = false;
+    self->low = (void*) 0;
+    self->base = (void*) 0;
+    self->offsets = (void*) 0;
+
+    return push(self, 0);
+}
+
+/* indexes s from len up to n */
+static bool extend(str_line_index* self, char const* s, size_t n) {
+    enum str_simd simd = str_simd_detect();
+    size_t found[FOUND];
+
+    for (size_t i = self->len; i < n;) {
+        size_t k = 0;
+
+        i = scan(simd, s, i, n, found, &k);
+
+        if (!grow(self, self->starts + k)) {
+            return false;
+        }
+
+        for (size_t j = 0; j < k; ++j) {
+            if (!push(self, found[j] + 1)) {
+                return false;
+            }
+        }
+    }
+
+    self->len = n;
+
+    return true;
+}
+
+/* -- Parallel Build -- */
+
+struct build {
+    str_line_index* self;
+    enum str_simd simd;
+    char const* s;
+    size_t len;
+    /* newlines of every chunk, then index of its first start */
+    size_t* counts;
+};
+
+static void count_task(void* ctx, size_t c) {
+    struct build* b = ctx;
+    size_t from = c * CHUNK;
+    size_t n = b->len - from < CHUNK ? b->len - from : CHUNK;
+
+    b->counts[c] = count(b->simd, b->s + from, n);
+}
+
+static void write_task(void* ctx, size_t c) {
+    struct build* b = ctx;
+    size_t k = b->counts[c];
+    size_t to = b->len - c * CHUNK < CHUNK ? b->len : c * CHUNK + CHUNK;
+    size_t found[FOUND];
+
+    for (size_t i = c * CHUNK; i < to;) {
+        size_t m = 0;
+
+        i = scan(b->simd, b->s, i, to, found, &m);
+
+        for (size_t j = 0; j < m; ++j) {
+            set(b->self, k++, found[j] + 1);
+        }
+    }
+}
+
+static bool build_par(str_par_pool* pool, str_line_index* self, str_view v) {
+    size_t chunks = (v.len + CHUNK - 1) / CHUNK;
+    struct build b = {
+        self, str_simd_detect(), v.data, v.len,
+        malloc(chunks * sizeof (size_t)),
+    };
+
+    if (!b.counts) {
+        return false;
+    }
+
+    str_par_run(pool, count_task, &b, chunks);
+
+    size_t total = 1;
+
+    for (size_t c = 0; c < chunks; ++c) {
+        size_t n = b.counts[c];
+
+        b.counts[c] = total;
+        total += n;
+    }
+
+    if (!grow(self, total)) {
+        free(b.counts);
+        return false;
+    }
+
+    str_par_run(pool, write_task, &b, chunks);
+    free(b.counts);
+
+    self->starts = total;
+    self->len = v.len;
+
+    /* a block spanning 4 GiB can't be told apart by its low bits, so
+     * it takes a serial build, which widens as it goes */
+    for (size_t i = 0; i < total; i += BLOCK) {
+        size_t next = i + BLOCK < total ? start(self, i + BLOCK) : v.len;
+
+        if (next - self->base[i / BLOCK] > UINT32_MAX) {
+            return reset(self) && extend(self, v.data, v.len);
+        }
+    }
+
+    return true;
+}
+
+/* -- Public Interface Implementation -- */
+
+str_line_index* str_line_index_build(str* s) {
+    return str_line_index_build_par((void*) 0, s);
+}
+
+str_line_index* str_line_index_build_par(str_par_pool* pool, str* s) {
+    if (!s) {
+        return (void*) 0;
+    }
+
+    str_line_index* self = calloc(1, sizeof (str_line_index));
+
+    if (!self) {
+        return (void*) 0;
+    }
+
+    self->s = s;
+
+    str_view v = str_view_from_str(s);
+    bool ok = reset(self);
+
+    /* parallel only pays off over a few chunks */
+    if (ok && pool && str_par_pool_threads(pool) > 1 && v.len >= 4 * CHUNK) {
+        ok = build_par(pool, self, v);
+    } else if (ok) {
+        ok = extend(self, v.data, v.len);
+    }
+
+    if (!ok) {
+        str_line_index_del(self);
+        return (void*) 0;
+    }
+
+    return self;
+}
+
+void str_line_index_del(str_line_index* self) {
+    if (!self) {
+        return;
+    }
+
+    free(self->low);
+    free(self->base);
+    free(self->offsets);
+    free(self);
+}
+
+bool str_line_index_update(str_line_index* self) {
+    if (!self) {
+        return false;
+    }
+
+    str_view v = str_view_from_str(self->s);
+
+    if (v.len < self->len && !reset(self)) {
+        return false;
+    }
+
+    return extend(self, v.data, v.len);
+}
+
+size_t str_line_index_lines(str_line_index const* self) {
+    if (!self) {
+        return 0;
+    }
+
+    /* a start at the very end opens no line */
+    return self->starts - (start(self, self->starts - 1) == self->len);
+}
+
+str_view str_line_index_line(str_line_index const* self, size_t n) {
+    if (n >= str_line_index_lines(self)) {
+        return (str_view) { (void*) 0, 0 };
+    }
+
+    char const* data = str_view_from_str(self->s).data;
+    size_t begin = start(self, n);
+    size_t end = n + 1 < self->starts ? start(self, n + 1) - 1 : self->len;
+
+    return (str_view) { data + begin, end - begin };
+}
+
+size_t str_line_index_line_of(str_line_index const* self, size_t pos) {
+    if (!self || pos >= self->len) {
+        return STR_NPOS;
+    }
+
+    /* the last start at or before pos */
+    size_t lo = 0;
+    size_t hi = self->starts;
+
+    while (hi - lo > 1) {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (start(self, mid) <= pos) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
@@ -0,0 +1,107 @@
+/** str's Line Index
+ * @file str_lines.h
+ *
+ * Offsets of the lines of a str, for jumping to line n in constant
+ * time instead of counting newlines from the start. Newlines are found
+ * 16 or 32 bytes at a time, and an index follows a str that is only
+ * appended to by scanning just the new characters. */
+#ifndef STR_LINES_H
+#define STR_LINES_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "str.h"
+#include "str_par.h"
+
+/** Opaque str_line_index Structure
+ * @note       It keeps about 4 bytes per line: the low 32 bits of
+ *             every offset and the full offset of every 64th line. */
+typedef struct str_line_index str_line_index;
+
+/** Builds line index of str.
+ * @warning    The user has to free the object after usage with
+ *             str_line_index_del.
+ *
+ * @warning    The index refers to s, which must not be deleted while
+ *             the index is in use. Appending to s is fine, the index
+ *             then covers the characters up to the last update.
+ *
+ * @note       Lines end with \\n, which isn't part of them. A last
+ *             line without one counts as well.
+ *
+ * @param s    A pointer to a str object.
+ *
+ * @return     A pointer to a str_line_index object.
+ *
+ * @see str_line_index_build_par str_line_index_update
+ *      str_line_index_del */
+str_line_index* str_line_index_build(str* s);
+
+/** Builds line index of str in parallel.
+ * @warning    The user has to free the object after usage with
+ *             str_line_index_del.
+ *
+ * @note       Chunks of s are counted across the pool, then scanned
+ *             again to write their offsets in place.
+ *
+ * @note       If the pool is null, it runs in the calling thread.
+ *
+ * @param pool A pointer to a str_par_pool object.
+ * @param s    A pointer to a str object.
+ *
+ * @return     A pointer to a str_line_index object.
+ *
+ * @see str_line_index_build */
+str_line_index* str_line_index_build_par(str_par_pool* pool, str* s);
+
+/** Deletes line index.
+ * @param self A pointer to a str_line_index object. */
+void str_line_index_del(str_line_index* self);
+
+/** Indexes the characters appended to the str since the last update.
+ * @note       It only scans the new characters. If the str got
+ *             shorter, it indexes it again from the start.
+ *
+ * @warning    Changes to characters already indexed go unnoticed.
+ *
+ * @param self A pointer to a str_line_index object.
+ *
+ * @return     true if successful. */
+bool str_line_index_update(str_line_index* self);
+
+/** Returns number of lines.
+ * @param self A pointer to a str_line_index object.
+ *
+ * @return     Number of lines, 0 for an empty str. */
+size_t str_line_index_lines(str_line_index const* self);
+
+/** Returns a line.
+ * @note       The view is valid until the str changes.
+ *
+ * @param self A pointer to a str_line_index object.
+ * @param n    Index of the line, from 0.
+ *
+ * @return     A view over the line without its \\n, or a null view if
+ *             n is out of range. */
+str_view str_line_index_line(str_line_index const* self, size_t n);
+
+/** Returns line holding a character.
+ * @note       It runs a binary search, O(log n).
+ *
+ * @param self A pointer to a str_line_index object.
+ * @param pos  Index of the character, a \\n belonging to the line it
+ *             ends.
+ *
+ * @return     Index of the line, or STR_NPOS if pos is out of range. */
+size_t str_line_index_line_of(str_line_index const* self, size_t pos);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* STR_LINES_H */
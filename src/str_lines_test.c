@@ -0,0 +1,185 @@
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cmocka.h>
+
+#include "str.h"
+#include "str_lines.h"
+
+/* checks the index against splitting s by hand */
+static void assert_lines(str_line_index const* index, str* s) {
+    str_view v = str_view_of(s);
+    size_t n = 0;
+    size_t begin = 0;
+
+    for (size_t i = 0; i <= v.len; ++i) {
+        if (i < v.len && v.data[i] != '\n') {
+            continue;
+        }
+
+        if (i == v.len && begin == v.len) {
+            break;
+        }
+
+        str_view line = str_line_index_line(index, n);
+
+        assert_ptr_equal(line.data, v.data + begin);
+        assert_int_equal(line.len, i - begin);
+        assert_int_equal(str_line_index_line_of(index, begin), n);
+        assert_int_equal(str_line_index_line_of(index, i == v.len ? i - 1 : i),
+                n);
+
+        n++;
+        begin = i + 1;
+    }
+
+    assert_int_equal(str_line_index_lines(index), n);
+    assert_null(str_line_index_line(index, n).data);
+    assert_int_equal(str_line_index_line_of(index, v.len), STR_NPOS);
+}
+
+/* random text with long lines and runs of empty ones */
+static str* random_text(size_t len) {
+    str* s = str_new();
+
+    str_reserve(s, len + 400);
+
+    while (str_len(s) < len) {
+        switch (rand() % 4) {
+        case 0:
+            str_fill(s, '\n', (size_t) rand() % 40);
+            break;
+        case 1:
+            str_fill(s, 'x', (size_t) rand() % 300);
+            break;
+        default:
+            str_fill(s, 'a' + rand() % 26, (size_t) rand() % 8);
+            str_append_char(s, '\n');
+        }
+    }
+
+    return s;
+}
+
+static void str_line_index_test(void** state) {
+    (void) state;
+
+    char const* cases[] = {
+        "", "\n", "\n\n", "one", "one\n", "one\ntwo", "one\ntwo\n",
+        "\none\n\ntwo\n\n",
+    };
+    size_t lines[] = { 0, 1, 2, 1, 1, 2, 2, 5 };
+
+    for (size_t i = 0; i < sizeof cases / sizeof *cases; ++i) {
+        str* s = str_from(cases[i]);
+        str_line_index* index = str_line_index_build(s);
+
+        assert_non_null(index);
+        assert_int_equal(str_line_index_lines(index), lines[i]);
+        assert_lines(index, s);
+
+        str_line_index_del(index);
+        str_del(s);
+    }
+
+    str* s = str_from("first\nsecond\nthird");
+    str_line_index* index = str_line_index_build(s);
+    str_view line = str_line_index_line(index, 1);
+
+    assert_int_equal(line.len, 6);
+    assert_memory_equal(line.data, "second", 6);
+    assert_int_equal(str_line_index_line_of(index, 5), 0);
+    assert_int_equal(str_line_index_line_of(index, 6), 1);
+
+    str_line_index_del(index);
+    str_del(s);
+
+    assert_null(str_line_index_build((void*) 0));
+    assert_int_equal(str_line_index_lines((void*) 0), 0);
+    assert_false(str_line_index_update((void*) 0));
+}
+
+static void str_line_index_random_test(void** state) {
+    (void) state;
+    srand(46);
+
+    for (int round = 0; round < 200; ++round) {
+        str* s = random_text((size_t) rand() % (round < 150 ? 500 : 20000));
+        str_line_index* index = str_line_index_build(s);
+
+        assert_non_null(index);
+        assert_lines(index, s);
+
+        str_line_index_del(index);
+        str_del(s);
+    }
+}
+
+static void str_line_index_update_test(void** state) {
+    (void) state;
+    srand(47);
+
+    str* s = str_new();
+    str_line_index* index = str_line_index_build(s);
+
+    for (int round = 0; round < 300; ++round) {
+        str* more = random_text((size_t) rand() % 200);
+
+        /* splitting lines as well as ending them */
+        if (rand() % 2) {
+            str_append_char(more, 'y');
+        }
+
+        str_append_str(s, more);
+        assert_true(str_line_index_update(index));
+        assert_lines(index, s);
+
+        str_del(more);
+    }
+
+    /* shrinking starts over */
+    str_truncate(s, str_len(s) / 3);
+    assert_true(str_line_index_update(index));
+    assert_lines(index, s);
+
+    str_line_index_del(index);
+    str_del(s);
+}
+
+static void str_line_index_par_test(void** state) {
+    (void) state;
+    srand(48);
+
+    str_par_pool* pool = str_par_pool_new(4);
+    str* s = random_text((size_t) 9 << 20);
+    str_line_index* index = str_line_index_build_par(pool, s);
+
+    assert_non_null(index);
+    assert_lines(index, s);
+
+    /* and the index carries on serially */
+    str_append_view(s, str_view_of("tail\nend"));
+    assert_true(str_line_index_update(index));
+    assert_lines(index, s);
+
+    str_line_index_del(index);
+    str_del(s);
+    str_par_pool_del(pool);
+}
+
+
+int main(void) {
+    struct CMUnitTest const tests[] = {
+        cmocka_unit_test(str_line_index_test),
+        cmocka_unit_test(str_line_index_random_test),
+        cmocka_unit_test(str_line_index_update_test),
+        cmocka_unit_test(str_line_index_par_test),
+    };
+
+
+    return cmocka_run_group_tests(tests, (void*) 0, (void*) 0);
+}
@@ -0,0 +1,488 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <unistd.h>
+
+#include "str_par.h"
+
+/* chunks smaller than this are not worth a thread */
+static const size_t STR_PAR_MIN_CHUNK = 1 << 16;
+
+/* leading matches a chunk keeps when it doesn't collect them all, enough
+ * for a realigned greedy chain to meet one of them */
+#define STR_PAR_HEAD 64
+
+struct str_par_pool {
+    pthread_t* workers;
+    size_t n_workers;
+
+    /* serializes callers sharing the pool */
+    pthread_mutex_t run_lock;
+
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+
+    void (*task)(void* ctx, size_t i);
+    void* ctx;
+    size_t next;
+    size_t count;
+    size_t finished;
+    bool stop;
+};
+
+struct chunk {
+    /* matches starting in [begin, end) belong to the chunk */
+    size_t begin;
+    size_t end;
+
+    size_t count;
+    size_t first;
+    size_t last_end;
+    size_t head[STR_PAR_HEAD];
+
+    size_t* positions;
+    size_t used;
+    size_t max;
+    bool failed;
+};
+
+struct search {
+    str_view haystack;
+    str_view needle;
+    bool overlapping;
+    bool collect;
+    struct chunk* chunks;
+};
+
+/* -- Private Interface -- */
+
+static void* work(void* arg) {
+    struct str_par_pool* self = arg;
+
+    pthread_mutex_lock(&self->lock);
+
+    for (;;) {
+        while (!self->stop && self->next >= self->count) {
+            pthread_cond_wait(&self->wake, &self->lock);
+        }
+
+        if (self->stop) {
+            break;
+        }
+
+        size_t i = self->next++;
+
+        pthread_mutex_unlock(&self->lock);
+        self->task(self->ctx, i);
+        pthread_mutex_lock(&self->lock);
+
+        if (++self->finished == self->count) {
+            pthread_cond_signal(&self->done);
+        }
+    }
+
+    pthread_mutex_unlock(&self->lock);
+
+    return (void*) 0;
+}
+
+static bool record(struct chunk* chunk, size_t position) {
+    assert(chunk != (void*) 0);
+
+    if (chunk->used >= chunk->max) {
+        size_t max = chunk->max ? chunk->max * 2 : 64;
+        size_t* positions = realloc(chunk->positions, max * sizeof (size_t));
+
+        if (!positions) {
+            return false;
+        }
+
+        chunk->positions = positions;
+        chunk->max = max;
+    }
+
+    chunk->positions[chunk->used++] = position;
+
+    return true;
+}
+
+static str_view bounds(struct search* search, struct chunk* chunk) {
+    str_view needle = search->needle;
+    str_view haystack = search->haystack;
+
+    /* matches straddling the end of the chunk are its own */
+    if (haystack.len - chunk->end > needle.len - 1) {
+        haystack.len = chunk->end + needle.len - 1;
+    }
+
+    return haystack;
+}
+
+static void scan(struct search* search, struct chunk* chunk, size_t from) {
+    assert(search != (void*) 0);
+    assert(chunk != (void*) 0);
+
+    str_view needle = search->needle;
+    str_view haystack = bounds(search, chunk);
+
+    chunk->count = 0;
+    chunk->first = STR_NPOS;
+    chunk->last_end = 0;
+    chunk->used = 0;
+
+    size_t step = search->overlapping ? 1 : needle.len;
+
+    for (size_t i = str_view_find(haystack, needle, from);
+            i != STR_NPOS;
+            i = str_view_find(haystack, needle, i + step)) {
+        if (!chunk->count) {
+            chunk->first = i;
+        }
+
+        if (chunk->count < STR_PAR_HEAD) {
+            chunk->head[chunk->count] = i;
+        }
+
+        chunk->count++;
+        chunk->last_end = i + needle.len;
+
+        if (search->collect && !record(chunk, i)) {
+            chunk->failed = true;
+            return;
+        }
+    }
+}
+
+/* redoes the non-overlapping matching of a chunk from where the previous
+ * chunk's last match ends, until the new greedy chain lands on a match
+ * the chunk found by itself: from there on both chains are the same */
+static void realign(struct search* search, struct chunk* chunk,
+        size_t from) {
+    assert(search != (void*) 0);
+    assert(chunk != (void*) 0);
+    assert(!search->overlapping);
+
+    str_view needle = search->needle;
+    str_view haystack = bounds(search, chunk);
+
+    size_t const* known = search->collect ? chunk->positions : chunk->head;
+    size_t n_known = search->collect ? chunk->used
+            : chunk->count < STR_PAR_HEAD ? chunk->count : STR_PAR_HEAD;
+    size_t k = 0;
+
+    struct chunk fresh = { 0 };
+
+    fresh.first = STR_NPOS;
+
+    for (size_t i = str_view_find(haystack, needle, from);
+            i != STR_NPOS;
+            i = str_view_find(haystack, needle, i + needle.len)) {
+        while (k < n_known && known[k] < i) {
+            k++;
+        }
+
+        if (!fresh.count) {
+            fresh.first = i;
+        }
+
+        if (k < n_known && known[k] == i) {
+            fresh.count += chunk->count - k;
+            fresh.last_end = chunk->last_end;
+
+            while (search->collect && !fresh.failed && k < n_known) {
+                fresh.failed = !record(&fresh, known[k++]);
+            }
+
+            break;
+        }
+
+        fresh.count++;
+        fresh.last_end = i + needle.len;
+
+        if (search->collect && !record(&fresh, i)) {
+            fresh.failed = true;
+            break;
+        }
+    }
+
+    free(chunk->positions);
+
+    chunk->count = fresh.count;
+    chunk->first = fresh.first;
+    chunk->last_end = fresh.last_end;
+    chunk->positions = fresh.positions;
+    chunk->used = fresh.used;
+    chunk->max = fresh.max;
+    chunk->failed = chunk->failed || fresh.failed;
+}
+
+static void scan_task(void* ctx, size_t i) {
+    struct search* search = ctx;
+    struct chunk* chunk = &search->chunks[i];
+
+    scan(search, chunk, chunk->begin);
+}
+
+static size_t split(str_par_pool* pool, size_t len) {
+    size_t n = str_par_pool_threads(pool);
+
+    if (len / n < STR_PAR_MIN_CHUNK) {
+        n = len / STR_PAR_MIN_CHUNK;
+    }
+
+    return n ? n : 1;
+}
+
+static bool search(str_par_pool* pool, struct search* search,
+        size_t* count, size_t** positions) {
+    assert(search != (void*) 0);
+    assert(search->needle.len);
+
+    size_t len = search->haystack.len;
+    size_t n = split(pool, len);
+
+    search->chunks = calloc(n, sizeof (struct chunk));
+
+    if (!search->chunks) {
+        return false;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        search->chunks[i].begin = len / n * i;
+        search->chunks[i].end = i + 1 < n ? len / n * (i + 1) : len;
+    }
+
+    str_par_run(pool, scan_task, search, n);
+
+    bool ok = true;
+    size_t total = 0;
+    size_t prev_end = 0;
+
+    /* merges in order, a non-overlapping match straddling into the
+     * next chunk shifts where that chunk's greedy matching starts */
+    for (size_t i = 0; i < n; ++i) {
+        struct chunk* chunk = &search->chunks[i];
+
+        if (!search->overlapping && chunk->first < prev_end) {
+            realign(search, chunk, prev_end);
+        }
+
+        ok = ok && !chunk->failed;
+        total += chunk->count;
+
+        if (chunk->count) {
+            prev_end = chunk->last_end;
+        }
+    }
+
+    if (ok && positions) {
+        *positions = malloc((total ? total : 1) * sizeof (size_t));
+        ok = *positions != (void*) 0;
+
+        for (size_t i = 0, used = 0; ok && i < n; ++i) {
+            struct chunk* chunk = &search->chunks[i];
+
+            if (chunk->used) {
+                memcpy(*positions + used, chunk->positions,
+                        chunk->used * sizeof (size_t));
+            }
+
+            used += chunk->used;
+        }
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        free(search->chunks[i].positions);
+    }
+
+    free(search->chunks);
+
+    *count = total;
+
+    return ok;
+}
+
+static bool find(str_par_pool* pool, str* self, str_view needle,
+        bool overlapping, size_t** positions, size_t* n) {
+    if (!self || !positions || !n) {
+        return false;
+    }
+
+    *positions = (void*) 0;
+    *n = 0;
+
+    if (!needle.len) {
+        *positions = malloc(sizeof (size_t));
+        return *positions != (void*) 0;
+    }
+
+    struct search s = {
+        str_view_from_str(self), needle, overlapping, true, (void*) 0
+    };
+
+    if (!search(pool, &s, n, positions)) {
+        free(*positions);
+        *positions = (void*) 0;
+        *n = 0;
+        return false;
+    }
+
+    return true;
+}
+
+/* -- Public Interface Implementation -- */
+
+struct str_par_pool* str_par_pool_new(size_t threads) {
+    if (!threads) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = online > 0 ? (size_t) online : 1;
+    }
+
+    struct str_par_pool* pool = malloc(sizeof (struct str_par_pool));
+
+    if (!pool) {
+        return (void*) 0;
+    }
+
+    pool->n_workers = 0;
+    pool->task = (void*) 0;
+    pool->ctx = (void*) 0;
+    pool->next = 0;
+    pool->count = 0;
+    pool->finished = 0;
+    pool->stop = false;
+
+    pool->workers = malloc(threads * sizeof (pthread_t));
+
+    if (!pool->workers) {
+        free(pool);
+        return (void*) 0;
+    }
+
+    pthread_mutex_init(&pool->run_lock, (void*) 0);
+    pthread_mutex_init(&pool->lock, (void*) 0);
+    pthread_cond_init(&pool->wake, (void*) 0);
+    pthread_cond_init(&pool->done, (void*) 0);
+
+    for (size_t i = 0; i + 1 < threads; ++i) {
+        if (pthread_create(&pool->workers[i], (void*) 0, work, pool)) {
+            str_par_pool_del(pool);
+            return (void*) 0;
+        }
+
+        pool->n_workers++;
+    }
+
+    return pool;
+}
+
+void str_par_pool_del(struct str_par_pool* self) {
+    if (!self) {
+        return;
+    }
+
+    pthread_mutex_lock(&self->lock);
+    self->stop = true;
+    pthread_cond_broadcast(&self->wake);
+    pthread_mutex_unlock(&self->lock);
+
+    for (size_t i = 0; i < self->n_workers; ++i) {
+        pthread_join(self->workers[i], (void*) 0);
+    }
+
+    pthread_cond_destroy(&self->done);
+    pthread_cond_destroy(&self->wake);
+    pthread_mutex_destroy(&self->lock);
+    pthread_mutex_destroy(&self->run_lock);
+
+    free(self->workers);
+    free(self);
+}
+
+size_t str_par_pool_threads(struct str_par_pool* self) {
+    if (!self) {
+        return 1;
+    }
+
+    return self->n_workers + 1;
+}
+
+void str_par_run(struct str_par_pool* self,
+        void (*task)(void* ctx, size_t i), void* ctx, size_t n) {
+    if (!task) {
+        return;
+    }
+
+    if (!self || !self->n_workers || n < 2) {
+        for (size_t i = 0; i < n; ++i) {
+            task(ctx, i);
+        }
+
+        return;
+    }
+
+    pthread_mutex_lock(&self->run_lock);
+    pthread_mutex_lock(&self->lock);
+
+    self->task = task;
+    self->ctx = ctx;
+    self->next = 0;
+    self->count = n;
+    self->finished = 0;
+
+    pthread_cond_broadcast(&self->wake);
+
+    /* the calling thread takes tasks as well */
+    while (self->next < self->count) {
+        size_t i = self->next++;
+
+        pthread_mutex_unlock(&self->lock);
+        task(ctx, i);
+        pthread_mutex_lock(&self->lock);
+
+        self->finished++;
+    }
+
+    while (self->finished < self->count) {
+        pthread_cond_wait(&self->done, &self->lock);
+    }
+
+    self->count = 0;
+    self->next = 0;
+
+    pthread_mutex_unlock(&self->lock);
+    pthread_mutex_unlock(&self->run_lock);
+}
+
+size_t str_par_count(str_par_pool* pool, str* self, str_view needle) {
+    if (!self || !needle.len) {
+        return 0;
+    }
+
+    struct search s = {
+        str_view_from_str(self), needle, false, false, (void*) 0
+    };
+
+    size_t count = 0;
+
+    if (!search(pool, &s, &count, (void*) 0)) {
+        return str_count(self, needle);
+    }
+
+    return count;
+}
+
+bool str_par_find_all(str_par_pool* pool, str* self, str_view needle,
+        size_t** positions, size_t* n) {
+    return find(pool, self, needle, true, positions, n);
+}
+
+bool str_par_split_index(str_par_pool* pool, str* self, str_view delim,
+        size_t** positions, size_t* n) {
+    return find(pool, self, delim, false, positions, n);
+}
@@ -0,0 +1,126 @@
+/** str's Parallel Search
+ * @file str_par.h */
+#ifndef STR_PAR_H
+#define STR_PAR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "str.h"
+
+/** Opaque str_par_pool Structure */
+typedef struct str_par_pool str_par_pool;
+
+/** Creates pool of worker threads.
+ * @warning    The user has to free the object after usage with
+ *             str_par_pool_del.
+ *
+ * @note       The calling thread takes part in the work, so a pool
+ *             of n threads starts n - 1 workers.
+ *
+ * @note       If threads is zero, it uses the number of online
+ *             processors.
+ *
+ * @param threads Number of threads.
+ *
+ * @return     A pointer to a str_par_pool object.
+ *
+ * @see str_par_pool_del */
+str_par_pool* str_par_pool_new(size_t threads);
+
+/** Stops the workers and deletes the pool.
+ * @param self A pointer to a str_par_pool object. */
+void str_par_pool_del(str_par_pool* self);
+
+/** Returns number of threads in pool.
+ * @note       A null pool counts as a single thread.
+ *
+ * @param self A pointer to a str_par_pool object.
+ *
+ * @return     Number of threads, including the calling one. */
+size_t str_par_pool_threads(str_par_pool* self);
+
+/** Runs a task in parallel.
+ * @note       Calls task(ctx, i) once for every i in [0, n),
+ *             spread across the pool, and returns when all the
+ *             calls returned.
+ *
+ * @note       If the pool is null, the calls run in the calling
+ *             thread.
+ *
+ * @param self A pointer to a str_par_pool object.
+ * @param task Function to call.
+ * @param ctx  Argument passed to task.
+ * @param n    Number of calls. */
+void str_par_run(str_par_pool* self, void (*task)(void* ctx, size_t i),
+        void* ctx, size_t n);
+
+/** Counts non-overlapping occurrences of a needle in parallel.
+ * @note       The result is the same as str_count.
+ *
+ * @note       If the pool is null, it runs in the calling thread.
+ *
+ * @param pool   A pointer to a str_par_pool object.
+ * @param self   A pointer to a str object.
+ * @param needle A view to search for.
+ *
+ * @return       Number of occurrences.
+ *
+ * @see str_count */
+size_t str_par_count(str_par_pool* pool, str* self, str_view needle);
+
+/** Finds all occurrences of a needle in parallel.
+ * @warning    The user has to free the positions after usage with
+ *             free.
+ *
+ * @note       Occurrences may overlap, so "aaaa" contains
+ *             three occurrences of "aa".
+ *
+ * @note       An empty needle has no occurrences.
+ *
+ * @note       If the pool is null, it runs in the calling thread.
+ *
+ * @param pool      A pointer to a str_par_pool object.
+ * @param self      A pointer to a str object.
+ * @param needle    A view to search for.
+ * @param positions Receives an ascending array of indexes.
+ * @param n         Receives the number of indexes.
+ *
+ * @return          true if successful.
+ *
+ * @see str_par_split_index */
+bool str_par_find_all(str_par_pool* pool, str* self, str_view needle,
+        size_t** positions, size_t* n);
+
+/** Finds the delimiters splitting str in parallel.
+ * @warning    The user has to free the positions after usage with
+ *             free.
+ *
+ * @note       Delimiters don't overlap, they are matched greedily
+ *             from the left as in str_count.
+ *
+ * @note       An empty delimiter has no occurrences.
+ *
+ * @note       If the pool is null, it runs in the calling thread.
+ *
+ * @param pool      A pointer to a str_par_pool object.
+ * @param self      A pointer to a str object.
+ * @param delim     A view to split on.
+ * @param positions Receives an ascending array of delimiter indexes.
+ * @param n         Receives the number of delimiters.
+ *
+ * @return          true if successful.
+ *
+ * @see str_par_find_all str_par_count */
+bool str_par_split_index(str_par_pool* pool, str* self, str_view delim,
+        size_t** positions, size_t* n);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* STR_PAR_H */
@@ -0,0 +1,99 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <unistd.h>
+
+#include "str.h"
+#include "str_par.h"
+
+/* Scaling benchmark of str_par_count.
+ *
+ * Usage: str_par_bench [MiB] [max threads] */
+
+static double now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+static str* make_log(size_t size) {
+    char const* lines[] = {
+        "2024-01-01T00:00:00Z INFO request served in 12ms\n",
+        "2024-01-01T00:00:01Z DEBUG cache hit for key user:42\n",
+        "2024-01-01T00:00:02Z ERROR upstream timed out after 30s\n",
+        "2024-01-01T00:00:03Z INFO request served in 7ms\n",
+    };
+
+    str* s = str_new();
+
+    if (!s || !str_reserve(s, size)) {
+        str_del(s);
+        return (void*) 0;
+    }
+
+    for (size_t i = 0; str_len(s) < size; ++i) {
+        str_append(s, lines[i * 7 % 4]);
+    }
+
+    return s;
+}
+
+int main(int argc, char const** argv) {
+    size_t mib = argc > 1 ? strtoul(argv[1], (void*) 0, 10) : 256;
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t max_threads = argc > 2
+        ? strtoul(argv[2], (void*) 0, 10)
+        : (online > 0 ? (size_t) online : 1);
+
+    str* s = make_log(mib << 20);
+
+    if (!s) {
+        return EXIT_FAILURE;
+    }
+
+    str_view needle = str_view_of("ERROR");
+    double base = 0;
+
+    printf("threads,seconds,gib_per_s,speedup,count\n");
+
+    /* doubles the threads up to max_threads, which is always run */
+    for (size_t threads = 1; threads <= max_threads;
+            threads = threads * 2 > max_threads ? max_threads : threads * 2) {
+        str_par_pool* pool = str_par_pool_new(threads);
+
+        /* warm up */
+        size_t count = str_par_count(pool, s, needle);
+
+        double best = 1e30;
+
+        for (int round = 0; round < 5; ++round) {
+            double start = now();
+            count = str_par_count(pool, s, needle);
+            double elapsed = now() - start;
+
+            best = elapsed < best ? elapsed : best;
+        }
+
+        if (threads == 1) {
+            base = best;
+        }
+
+        printf("%zu,%.6f,%.3f,%.2f,%zu\n", threads, best,
+                (double) str_len(s) / best / (1 << 30), base / best, count);
+
+        str_par_pool_del(pool);
+
+        if (threads == max_threads) {
+            break;
+        }
+    }
+
+    str_del(s);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,229 @@
+#include <assert.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cmocka.h>
+
+#include "str.h"
+#include "str_par.h"
+
+/* big enough to be split in several chunks */
+static const size_t HAYSTACK_SIZE = 1 << 20;
+
+static str* random_haystack(unsigned seed) {
+    str* s = str_new();
+
+    srand(seed);
+    str_reserve(s, HAYSTACK_SIZE);
+
+    for (size_t i = 0; i < HAYSTACK_SIZE; ++i) {
+        str_append(s, rand() % 4 ? 'a' : 'b');
+    }
+
+    return s;
+}
+
+static size_t naive_find_all(str* s, str_view needle, size_t* positions) {
+    char const* data = str_cstr(s);
+    size_t n = 0;
+
+    for (size_t i = 0; i + needle.len <= str_len(s); ++i) {
+        if (memcmp(data + i, needle.data, needle.len) == 0) {
+            positions[n++] = i;
+        }
+    }
+
+    return n;
+}
+
+static void str_par_pool_test(void** state) {
+    (void) state;
+
+    str_par_pool* pool = str_par_pool_new(3);
+
+    assert_non_null(pool);
+    assert_int_equal(str_par_pool_threads(pool), 3);
+    assert_int_equal(str_par_pool_threads((str_par_pool*) 0), 1);
+
+    str_par_pool_del(pool);
+}
+
+static void sum_task(void* ctx, size_t i) {
+    size_t* slots = ctx;
+
+    slots[i] = i * i;
+}
+
+static void str_par_run_reuse_test(void** state) {
+    (void) state;
+
+    str_par_pool* pool = str_par_pool_new(4);
+    size_t slots[100];
+
+    for (int round = 0; round < 50; ++round) {
+        memset(slots, 0, sizeof slots);
+        str_par_run(pool, sum_task, slots, 100);
+
+        for (size_t i = 0; i < 100; ++i) {
+            assert_int_equal(slots[i], i * i);
+        }
+    }
+
+    str_par_pool_del(pool);
+}
+
+static void str_par_count_test(void** state) {
+    (void) state;
+
+    str* s = random_haystack(7);
+    char const* needles[] = { "a", "aa", "aaa", "aaaaaaa", "aba", "bb" };
+
+    for (size_t threads = 1; threads <= 7; ++threads) {
+        str_par_pool* pool = str_par_pool_new(threads);
+
+        for (size_t i = 0; i < sizeof needles / sizeof needles[0]; ++i) {
+            str_view needle = str_view_of(needles[i]);
+
+            assert_int_equal(str_par_count(pool, s, needle),
+                    str_count(s, needle));
+        }
+
+        str_par_pool_del(pool);
+    }
+
+    str_del(s);
+}
+
+static void str_par_find_all_test(void** state) {
+    (void) state;
+
+    str* s = random_haystack(11);
+    size_t* expected = malloc(HAYSTACK_SIZE * sizeof (size_t));
+    str_par_pool* pool = str_par_pool_new(5);
+
+    str_view needle = str_view_of("aaa");
+    size_t n_expected = naive_find_all(s, needle, expected);
+
+    size_t* positions;
+    size_t n;
+
+    assert_true(str_par_find_all(pool, s, needle, &positions, &n));
+    assert_int_equal(n, n_expected);
+    assert_memory_equal(positions, expected, n * sizeof (size_t));
+
+    free(positions);
+    free(expected);
+    str_par_pool_del(pool);
+    str_del(s);
+}
+
+static void str_par_split_index_test(void** state) {
+    (void) state;
+
+    str* s = random_haystack(13);
+    str_par_pool* pool = str_par_pool_new(6);
+    str_view delim = str_view_of("aaaa");
+
+    size_t* positions;
+    size_t n;
+
+    assert_true(str_par_split_index(pool, s, delim, &positions, &n));
+    assert_int_equal(n, str_count(s, delim));
+
+    /* greedy and non-overlapping, the same as a sequential scan */
+    size_t from = 0;
+
+    for (size_t i = 0; i < n; ++i) {
+        size_t expected = str_find(s, delim, from);
+
+        assert_int_equal(positions[i], expected);
+        from = expected + delim.len;
+    }
+
+    free(positions);
+    str_par_pool_del(pool);
+    str_del(s);
+}
+
+static void str_par_periodic_test(void** state) {
+    (void) state;
+
+    /* chunk boundaries fall inside matches, so most chunks are realigned;
+     * the new chains meet the chunks' own ones ("aaa" over "aaaa...") or
+     * never do ("aa" shifted by one) */
+    char const* periods[] = { "a", "ab", "aab" };
+    char const* needles[] = { "aa", "aaa", "abab", "aabaa" };
+
+    for (size_t p = 0; p < sizeof periods / sizeof periods[0]; ++p) {
+        str* s = str_repeat(str_view_of(periods[p]),
+                HAYSTACK_SIZE / strlen(periods[p]));
+
+        for (size_t threads = 2; threads <= 7; ++threads) {
+            str_par_pool* pool = str_par_pool_new(threads);
+
+            for (size_t i = 0; i < sizeof needles / sizeof needles[0]; ++i) {
+                str_view needle = str_view_of(needles[i]);
+                size_t n_expected = str_count(s, needle);
+
+                size_t* positions;
+                size_t n;
+
+                assert_int_equal(str_par_count(pool, s, needle), n_expected);
+                assert_true(str_par_split_index(pool, s, needle,
+                        &positions, &n));
+                assert_int_equal(n, n_expected);
+
+                for (size_t j = 0, from = 0; j < n; ++j) {
+                    size_t expected = str_find(s, needle, from);
+
+                    assert_int_equal(positions[j], expected);
+                    from = expected + needle.len;
+                }
+
+                free(positions);
+            }
+
+            str_par_pool_del(pool);
+        }
+
+        str_del(s);
+    }
+}
+
+static void str_par_small_test(void** state) {
+    (void) state;
+
+    str* s = str_from("one,two,,three");
+    size_t* positions;
+    size_t n;
+
+    assert_int_equal(str_par_count((str_par_pool*) 0, s, str_view_of(",")), 3);
+
+    assert_true(str_par_split_index((str_par_pool*) 0, s, str_view_of(","),
+                &positions, &n));
+    assert_int_equal(n, 3);
+    assert_int_equal(positions[0], 3);
+    assert_int_equal(positions[1], 7);
+    assert_int_equal(positions[2], 8);
+
+    free(positions);
+    str_del(s);
+}
+
+int main(void) {
+    struct CMUnitTest const tests[] = {
+        cmocka_unit_test(str_par_pool_test),
+        cmocka_unit_test(str_par_run_reuse_test),
+        cmocka_unit_test(str_par_count_test),
+        cmocka_unit_test(str_par_find_all_test),
+        cmocka_unit_test(str_par_split_index_test),
+        cmocka_unit_test(str_par_periodic_test),
+        cmocka_unit_test(str_par_small_test),
+    };
+
+
+    return cmocka_run_group_tests(tests, (void*) 0, (void*) 0);
+}
@@ -0,0 +1,488 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "str_pool.h"
+#include "str_private.h"
+
+/* smallest capacities allocated for the arena, the index and the table */
+static const size_t STR_POOL_MIN_BYTES = 64;
+static const size_t STR_POOL_MIN_STRINGS = 16;
+
+/* the length of a removed string */
+#define REMOVED STR_NPOS
+
+struct str_pool {
+    /* characters of all strings, back to back */
+    char* data;
+    size_t used;
+    size_t max;
+
+    /* string i is data[offsets[i], offsets[i] + lengths[i]) */
+    size_t* offsets;
+    size_t* lengths;
+    size_t n;
+    size_t cap;
+
+    /* open addressing hash table of index + 1, zero when empty,
+     * only built by the first call to str_pool_intern */
+    size_t* table;
+    size_t table_used;
+    size_t table_max;
+    /* the table met a string already in it, which it doesn't index */
+    bool duplicates;
+};
+
+/* -- Private Interface -- */
+
+static uint64_t hash(str_view v) {
+    return str_fnv1a(STR_FNV1A_BASIS, v.data, v.len);
+}
+
+static str_view at(struct str_pool const* self, size_t i) {
+    assert(self != (void*) 0);
+    assert(i < self->n);
+
+    if (self->lengths[i] == REMOVED) {
+        return (str_view) { "", 0 };
+    }
+
+    return (str_view) { self->data + self->offsets[i], self->lengths[i] };
+}
+
+static bool reserve_bytes(struct str_pool* self, size_t n) {
+    assert(self != (void*) 0);
+
+    if (n <= self->max - self->used) {
+        return true;
+    }
+
+    /* overflow */
+    if (n > SIZE_MAX / 2 - self->used) {
+        return false;
+    }
+
+    size_t max = self->max ? self->max : STR_POOL_MIN_BYTES;
+
+    while (max < self->used + n) {
+        max *= 2;
+    }
+
+    char* data = realloc(self->data, max);
+
+    if (!data) {
+        return false;
+    }
+
+    self->data = data;
+    self->max = max;
+
+    return true;
+}
+
+static bool reserve_index(struct str_pool* self) {
+    assert(self != (void*) 0);
+
+    if (self->n < self->cap) {
+        return true;
+    }
+
+    size_t cap = self->cap ? self->cap * 2 : STR_POOL_MIN_STRINGS;
+
+    /* overflow */
+    if (cap > SIZE_MAX / sizeof (size_t)) {
+        return false;
+    }
+
+    size_t* offsets = realloc(self->offsets, cap * sizeof (size_t));
+
+    if (!offsets) {
+        return false;
+    }
+
+    self->offsets = offsets;
+
+    size_t* lengths = realloc(self->lengths, cap * sizeof (size_t));
+
+    if (!lengths) {
+        return false;
+    }
+
+    self->lengths = lengths;
+    self->cap = cap;
+
+    return true;
+}
+
+static void* shrink(void* p, size_t size) {
+    if (!size) {
+        free(p);
+        return (void*) 0;
+    }
+
+    void* q = realloc(p, size);
+
+    /* a failed shrink keeps the old block */
+    return q ? q : p;
+}
+
+/* returns the slot holding an equal string, or the empty one ending
+ * the probe sequence */
+static size_t* probe(struct str_pool* self, str_view v, uint64_t h) {
+    assert(self != (void*) 0);
+    assert(self->table != (void*) 0);
+
+    size_t mask = self->table_max - 1;
+
+    for (size_t slot = (size_t) h & mask;; slot = (slot + 1) & mask) {
+        size_t entry = self->table[slot];
+
+        if (!entry) {
+            return &self->table[slot];
+        }
+
+        size_t i = entry - 1;
+
+        /* removed strings never match, their length is REMOVED */
+        if (self->lengths[i] == v.len
+                && !memcmp(self->data + self->offsets[i], v.data, v.len)) {
+            return &self->table[slot];
+        }
+    }
+}
+
+/* fills a table of the given size, which has to be a power of two,
+ * with the strings of the pool */
+static bool rehash(struct str_pool* self, size_t table_max) {
+    assert(self != (void*) 0);
+
+    size_t* table = calloc(table_max, sizeof (size_t));
+
+    if (!table) {
+        return false;
+    }
+
+    free(self->table);
+
+    self->table = table;
+    self->table_max = table_max;
+    self->table_used = 0;
+    self->duplicates = false;
+
+    for (size_t i = 0; i < self->n; ++i) {
+        if (self->lengths[i] == REMOVED) {
+            continue;
+        }
+
+        str_view v = at(self, i);
+        size_t* slot = probe(self, v, hash(v));
+
+        if (!*slot) {
+            *slot = i + 1;
+            self->table_used++;
+        } else {
+            self->duplicates = true;
+        }
+    }
+
+    return true;
+}
+
+/* the next str_pool_intern builds it again */
+static void drop_table(struct str_pool* self) {
+    assert(self != (void*) 0);
+
+    free(self->table);
+    self->table = (void*) 0;
+    self->table_used = 0;
+    self->table_max = 0;
+}
+
+/* keeps the table at most half full */
+static bool reserve_table(struct str_pool* self, size_t n) {
+    assert(self != (void*) 0);
+
+    if (self->table && (self->table_used + n) * 2 <= self->table_max) {
+        return true;
+    }
+
+    size_t table_max = STR_POOL_MIN_STRINGS;
+
+    while (table_max / 2 < self->table_used + n) {
+        /* overflow */
+        if (table_max > SIZE_MAX / 2 / sizeof (size_t)) {
+            return false;
+        }
+
+        table_max *= 2;
+    }
+
+    return rehash(self, table_max);
+}
+
+/* appends v, whose hash h is only used if the pool has a table */
+static size_t add(struct str_pool* self, str_view v, uint64_t h) {
+    assert(self != (void*) 0);
+
+    uintptr_t begin = (uintptr_t) self->data;
+    uintptr_t p = (uintptr_t) v.data;
+    bool inside = self->data && p >= begin && p < begin + self->used;
+
+    if (!reserve_bytes(self, v.len) || !reserve_index(self)
+            || (self->table && !reserve_table(self, 1))) {
+        return STR_NPOS;
+    }
+
+    /* v pointed into the arena, which might have moved */
+    if (inside) {
+        v.data = self->data + (p - begin);
+    }
+
+    size_t i = self->n++;
+
+    self->offsets[i] = self->used;
+    self->lengths[i] = v.len;
+
+    if (v.len) {
+        memcpy(self->data + self->used, v.data, v.len);
+        self->used += v.len;
+    }
+
+    if (self->table) {
+        size_t* slot = probe(self, v, h);
+
+        if (!*slot) {
+            *slot = i + 1;
+            self->table_used++;
+        } else {
+            self->duplicates = true;
+        }
+    }
+
+    return i;
+}
+
+/* -- Public Interface Implementation -- */
+
+str_pool* str_pool_new(void) {
+    str_pool* self = malloc(sizeof (str_pool));
+
+    if (!self) {
+        return (void*) 0;
+    }
+
+    *self = (str_pool) { 0 };
+
+    return self;
+}
+
+str_pool* str_pool_from_strs(str* const* arr, size_t n, bool dedup) {
+    if (!arr && n) {
+        return (void*) 0;
+    }
+
+    str_pool* self = str_pool_new();
+
+    if (!self) {
+        return (void*) 0;
+    }
+
+    size_t bytes = 0;
+
+    for (size_t i = 0; i < n; ++i) {
+        bytes += str_len(arr[i]);
+    }
+
+    /* sizes the arena once, a dedup pool might need less */
+    if (!reserve_bytes(self, bytes)) {
+        str_pool_del(self);
+        return (void*) 0;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        str_view v = str_view_from_str(arr[i]);
+        size_t index = dedup ? str_pool_intern(self, v)
+            : str_pool_add(self, v);
+
+        if (index == STR_NPOS) {
+            str_pool_del(self);
+            return (void*) 0;
+        }
+    }
+
+    return self;
+}
+
+void str_pool_del(str_pool* self) {
+    if (!self) {
+        return;
+    }
+
+    free(self->data);
+    free(self->offsets);
+    free(self->lengths);
+    free(self->table);
+    free(self);
+}
+
+size_t str_pool_len(str_pool* self) {
+    return self ? self->n : 0;
+}
+
+size_t str_pool_bytes(str_pool* self) {
+    return self ? self->used : 0;
+}
+
+size_t str_pool_add(str_pool* self, str_view v) {
+    if (!self || (!v.data && v.len)) {
+        return STR_NPOS;
+    }
+
+    return add(self, v, self->table ? hash(v) : 0);
+}
+
+size_t str_pool_intern(str_pool* self, str_view v) {
+    if (!self || (!v.data && v.len)) {
+        return STR_NPOS;
+    }
+
+    if (!self->table && !reserve_table(self, self->n + 1)) {
+        return STR_NPOS;
+    }
+
+    uint64_t h = hash(v);
+    size_t* slot = probe(self, v, h);
+
+    if (*slot) {
+        return *slot - 1;
+    }
+
+    return add(self, v, h);
+}
+
+str_view str_pool_at(str_pool* self, size_t i) {
+    if (!self || i >= self->n) {
+        return (str_view) { "", 0 };
+    }
+
+    return at(self, i);
+}
+
+size_t str_pool_views(str_pool* self, size_t start, str_view* out, size_t n) {
+    if (!self || !out || start >= self->n) {
+        return 0;
+    }
+
+    if (n > self->n - start) {
+        n = self->n - start;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = at(self, start + i);
+    }
+
+    return n;
+}
+
+size_t str_pool_foreach(str_pool* self,
+        bool (*fn)(void* ctx, size_t i, str_view v), void* ctx) {
+    if (!self || !fn) {
+        return 0;
+    }
+
+    size_t calls = 0;
+
+    for (size_t i = 0; i < self->n; ++i) {
+        if (self->lengths[i] == REMOVED) {
+            continue;
+        }
+
+        calls++;
+
+        if (!fn(ctx, i, at(self, i))) {
+            break;
+        }
+    }
+
+    return calls;
+}
+
+str* str_pool_to_str(str_pool* self, size_t i) {
+    if (!self || i >= self->n || self->lengths[i] == REMOVED) {
+        return (void*) 0;
+    }
+
+    return str_from_view(at(self, i));
+}
+
+bool str_pool_remove(str_pool* self, size_t i) {
+    if (!self || i >= self->n || self->lengths[i] == REMOVED) {
+        return false;
+    }
+
+    /* the table entry stays until the next rehash,
+     * probe skips it as nothing has a length of REMOVED,
+     * unless it hides a copy of the string the table skipped */
+    if (self->table && self->duplicates) {
+        str_view v = at(self, i);
+
+        if (*probe(self, v, hash(v)) == i + 1) {
+            drop_table(self);
+        }
+    }
+
+    self->lengths[i] = REMOVED;
+
+    return true;
+}
+
+bool str_pool_compact(str_pool* self, size_t* remap) {
+    if (!self) {
+        return false;
+    }
+
+    size_t n = 0;
+    size_t used = 0;
+
+    /* strings are stored in index order, so moving them
+     * down in place never overwrites one still to move */
+    for (size_t i = 0; i < self->n; ++i) {
+        size_t len = self->lengths[i];
+
+        if (len == REMOVED) {
+            if (remap) {
+                remap[i] = STR_NPOS;
+            }
+
+            continue;
+        }
+
+        if (len) {
+            memmove(self->data + used, self->data + self->offsets[i], len);
+        }
+
+        self->offsets[n] = used;
+        self->lengths[n] = len;
+
+        if (remap) {
+            remap[i] = n;
+        }
+
+        used += len;
+        n++;
+    }
+
+    self->n = n;
+    self->used = used;
+
+    self->data = shrink(self->data, used);
+    self->max = used;
+    self->offsets = shrink(self->offsets, n * sizeof (size_t));
+    self->lengths = shrink(self->lengths, n * sizeof (size_t));
+    self->cap = n;
+
+    drop_table(self);
+
+    return true;
+}
@@ -0,0 +1,170 @@
+/** str's String Table
+ * @file str_pool.h */
+#ifndef STR_POOL_H
+#define STR_POOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "str.h"
+
+/** Opaque str_pool Structure
+ * @note       The characters of every string are stored back to back
+ *             in one buffer, next to arrays of offsets and lengths. */
+typedef struct str_pool str_pool;
+
+/** Creates empty pool.
+ * @warning    The user has to free the object after usage with
+ *             str_pool_del.
+ *
+ * @return     A pointer to a str_pool object.
+ *
+ * @see str_pool_del */
+str_pool* str_pool_new(void);
+
+/** Creates pool from array of str objects.
+ * @warning    The user has to free the object after usage with
+ *             str_pool_del.
+ *
+ * @note       The string at index i of the pool is arr[i], unless
+ *             dedup is set, in which case equal strings share an index.
+ *
+ * @param arr   A pointer to an array of str objects.
+ * @param n     Number of str objects.
+ * @param dedup Whether equal strings are stored once.
+ *
+ * @return      A pointer to a str_pool object.
+ *
+ * @see str_pool_add str_pool_intern str_pool_del */
+str_pool* str_pool_from_strs(str* const* arr, size_t n, bool dedup);
+
+/** Deletes pool.
+ * @param self A pointer to a str_pool object. */
+void str_pool_del(str_pool* self);
+
+/** Returns number of indexes in pool.
+ * @note       Removed strings keep their index until compaction.
+ *
+ * @param self A pointer to a str_pool object.
+ *
+ * @see str_pool_compact */
+size_t str_pool_len(str_pool* self);
+
+/** Returns number of characters stored in pool.
+ * @param self A pointer to a str_pool object. */
+size_t str_pool_bytes(str_pool* self);
+
+/** Appends string to pool.
+ * @note       The view may point into the pool itself.
+ *
+ * @param self A pointer to a str_pool object.
+ * @param v    A view.
+ *
+ * @return     Index of the new string or STR_NPOS on failure.
+ *
+ * @see str_pool_intern */
+size_t str_pool_add(str_pool* self, str_view v);
+
+/** Appends string to pool unless it is already there.
+ * @note       The first call builds a hash table of the strings in
+ *             the pool, which is kept up to date until compaction.
+ *
+ * @param self A pointer to a str_pool object.
+ * @param v    A view.
+ *
+ * @return     Index of the equal string or of the new one, or
+ *             STR_NPOS on failure.
+ *
+ * @see str_pool_add */
+size_t str_pool_intern(str_pool* self, str_view v);
+
+/** Returns view over string of pool.
+ * @warning    Adding strings may move the characters of the pool,
+ *             which invalidates the view.
+ *
+ * @note       If i is out of range or removed, it returns an empty view.
+ *
+ * @param self A pointer to a str_pool object.
+ * @param i    Index of the string.
+ *
+ * @return     A view over the string.
+ *
+ * @see str_pool_views str_pool_to_str */
+str_view str_pool_at(str_pool* self, size_t i);
+
+/** Copies views over many strings of pool.
+ * @warning    Adding strings may move the characters of the pool,
+ *             which invalidates the views.
+ *
+ * @note       Removed strings get empty views.
+ *
+ * @param self  A pointer to a str_pool object.
+ * @param start Index of the first string.
+ * @param out   A pointer to an array receiving the views.
+ * @param n     Capacity of out.
+ *
+ * @return      Number of views copied.
+ *
+ * @see str_pool_at str_pool_foreach */
+size_t str_pool_views(str_pool* self, size_t start, str_view* out, size_t n);
+
+/** Calls function for every string of pool in order.
+ * @note       Removed strings are skipped, and the iteration stops
+ *             once fn returns false.
+ *
+ * @param self A pointer to a str_pool object.
+ * @param fn   Function receiving ctx, the index and the string.
+ * @param ctx  Argument passed to fn.
+ *
+ * @return     Number of calls to fn.
+ *
+ * @see str_pool_views */
+size_t str_pool_foreach(str_pool* self,
+        bool (*fn)(void* ctx, size_t i, str_view v), void* ctx);
+
+/** Creates str from string of pool.
+ * @warning    The user has to free the object after usage with
+ *             str_del.
+ *
+ * @param self A pointer to a str_pool object.
+ * @param i    Index of the string.
+ *
+ * @return     A pointer to a str object or null if i is out of
+ *             range or removed.
+ *
+ * @see str_pool_at str_del */
+str* str_pool_to_str(str_pool* self, size_t i);
+
+/** Removes string from pool.
+ * @note       The characters are only released by str_pool_compact.
+ *
+ * @param self A pointer to a str_pool object.
+ * @param i    Index of the string.
+ *
+ * @return     true if the string was removed.
+ *
+ * @see str_pool_compact */
+bool str_pool_remove(str_pool* self, size_t i);
+
+/** Drops removed strings and releases unused memory.
+ * @note       The remaining strings keep their order but get new
+ *             indexes, remap[old] receives the new index of every
+ *             old one or STR_NPOS if it was removed.
+ *
+ * @param self  A pointer to a str_pool object.
+ * @param remap A pointer to an array of str_pool_len entries, or null.
+ *
+ * @return      true if successful.
+ *
+ * @see str_pool_remove */
+bool str_pool_compact(str_pool* self, size_t* remap);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* STR_POOL_H */
@@ -0,0 +1,247 @@
+#include <assert.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <cmocka.h>
+
+#include "str.h"
+#include "str_pool.h"
+
+static bool view_equal(str_view v, char const* cstr) {
+    return v.len == strlen(cstr) && !memcmp(v.data, cstr, v.len);
+}
+
+static bool count_calls(void* ctx, size_t i, str_view v) {
+    (void) i;
+    (void) v;
+
+    return ++*(size_t*) ctx < 2;
+}
+
+static bool sum_lengths(void* ctx, size_t i, str_view v) {
+    (void) i;
+
+    *(size_t*) ctx += v.len;
+
+    return true;
+}
+
+static void str_pool_add_test(void** state) {
+    (void) state;
+
+    str_pool* pool = str_pool_new();
+
+    assert_non_null(pool);
+    assert_int_equal(str_pool_len(pool), 0);
+
+    assert_int_equal(str_pool_add(pool, str_view_of("foo")), 0);
+    assert_int_equal(str_pool_add(pool, str_view_of("")), 1);
+    assert_int_equal(str_pool_add(pool, str_view_of("bar")), 2);
+    assert_int_equal(str_pool_add(pool, str_view_of("foo")), 3);
+
+    assert_int_equal(str_pool_len(pool), 4);
+    assert_int_equal(str_pool_bytes(pool), 9);
+
+    assert_true(view_equal(str_pool_at(pool, 0), "foo"));
+    assert_true(view_equal(str_pool_at(pool, 1), ""));
+    assert_true(view_equal(str_pool_at(pool, 2), "bar"));
+    assert_true(view_equal(str_pool_at(pool, 3), "foo"));
+    assert_true(view_equal(str_pool_at(pool, 4), ""));
+
+    /* a view into the pool survives the arena moving */
+    for (size_t i = 0; i < 100; ++i) {
+        assert_int_not_equal(str_pool_add(pool, str_pool_at(pool, 2)),
+                STR_NPOS);
+    }
+
+    assert_true(view_equal(str_pool_at(pool, 103), "bar"));
+    assert_int_equal(str_pool_add((void*) 0, str_view_of("foo")), STR_NPOS);
+
+    str_pool_del(pool);
+    str_pool_del((void*) 0);
+}
+
+static void str_pool_intern_test(void** state) {
+    (void) state;
+
+    str_pool* pool = str_pool_new();
+    char buffer[16];
+
+    assert_int_equal(str_pool_add(pool, str_view_of("before")), 0);
+    assert_int_equal(str_pool_intern(pool, str_view_of("before")), 0);
+
+    for (size_t i = 0; i < 1000; ++i) {
+        snprintf(buffer, sizeof buffer, "key%zu", i % 100);
+
+        size_t index = str_pool_intern(pool, str_view_of(buffer));
+
+        assert_int_equal(index, 1 + i % 100);
+        assert_true(view_equal(str_pool_at(pool, index), buffer));
+    }
+
+    assert_int_equal(str_pool_len(pool), 101);
+
+    /* added strings are found once the table exists */
+    assert_int_equal(str_pool_add(pool, str_view_of("after")), 101);
+    assert_int_equal(str_pool_intern(pool, str_view_of("after")), 101);
+
+    /* removed strings are not */
+    assert_true(str_pool_remove(pool, 101));
+    assert_int_equal(str_pool_intern(pool, str_view_of("after")), 102);
+
+    str_pool_del(pool);
+
+    /* removing the interned copy leaves the others to be found */
+    pool = str_pool_new();
+
+    assert_int_equal(str_pool_add(pool, str_view_of("x")), 0);
+    assert_int_equal(str_pool_add(pool, str_view_of("x")), 1);
+    assert_int_equal(str_pool_intern(pool, str_view_of("x")), 0);
+    assert_true(str_pool_remove(pool, 0));
+    assert_int_equal(str_pool_intern(pool, str_view_of("x")), 1);
+    assert_int_equal(str_pool_len(pool), 2);
+
+    /* also when the copy came after the table */
+    assert_int_equal(str_pool_add(pool, str_view_of("x")), 2);
+    assert_true(str_pool_remove(pool, 1));
+    assert_int_equal(str_pool_intern(pool, str_view_of("x")), 2);
+    assert_int_equal(str_pool_len(pool), 3);
+
+    str_pool_del(pool);
+}
+
+static void str_pool_views_test(void** state) {
+    (void) state;
+
+    str_pool* pool = str_pool_new();
+    str_view views[8];
+
+    str_pool_add(pool, str_view_of("a"));
+    str_pool_add(pool, str_view_of("bb"));
+    str_pool_add(pool, str_view_of("ccc"));
+
+    assert_int_equal(str_pool_views(pool, 1, views, 8), 2);
+    assert_true(view_equal(views[0], "bb"));
+    assert_true(view_equal(views[1], "ccc"));
+    assert_int_equal(str_pool_views(pool, 0, views, 1), 1);
+    assert_true(view_equal(views[0], "a"));
+    assert_int_equal(str_pool_views(pool, 3, views, 8), 0);
+
+    size_t sum = 0;
+
+    assert_int_equal(str_pool_foreach(pool, sum_lengths, &sum), 3);
+    assert_int_equal(sum, 6);
+
+    size_t calls = 0;
+
+    assert_int_equal(str_pool_foreach(pool, count_calls, &calls), 2);
+
+    str_pool_del(pool);
+}
+
+static void str_pool_remove_test(void** state) {
+    (void) state;
+
+    str_pool* pool = str_pool_new();
+    size_t remap[5];
+
+    str_pool_add(pool, str_view_of("zero"));
+    str_pool_add(pool, str_view_of("one"));
+    str_pool_add(pool, str_view_of("two"));
+    str_pool_add(pool, str_view_of("three"));
+    str_pool_add(pool, str_view_of("four"));
+
+    assert_true(str_pool_remove(pool, 1));
+    assert_true(str_pool_remove(pool, 3));
+    assert_false(str_pool_remove(pool, 3));
+    assert_false(str_pool_remove(pool, 5));
+
+    assert_true(view_equal(str_pool_at(pool, 1), ""));
+    assert_null(str_pool_to_str(pool, 1));
+    assert_int_equal(str_pool_len(pool), 5);
+
+    size_t sum = 0;
+
+    assert_int_equal(str_pool_foreach(pool, sum_lengths, &sum), 3);
+    assert_int_equal(sum, 11);
+
+    assert_true(str_pool_compact(pool, remap));
+
+    assert_int_equal(remap[0], 0);
+    assert_int_equal(remap[1], STR_NPOS);
+    assert_int_equal(remap[2], 1);
+    assert_int_equal(remap[3], STR_NPOS);
+    assert_int_equal(remap[4], 2);
+
+    assert_int_equal(str_pool_len(pool), 3);
+    assert_int_equal(str_pool_bytes(pool), 11);
+    assert_true(view_equal(str_pool_at(pool, 0), "zero"));
+    assert_true(view_equal(str_pool_at(pool, 1), "two"));
+    assert_true(view_equal(str_pool_at(pool, 2), "four"));
+
+    /* still usable after compaction */
+    assert_int_equal(str_pool_intern(pool, str_view_of("two")), 1);
+    assert_int_equal(str_pool_add(pool, str_view_of("five")), 3);
+
+    for (size_t i = 0; i < 4; ++i) {
+        str_pool_remove(pool, i);
+    }
+
+    assert_true(str_pool_compact(pool, (void*) 0));
+    assert_int_equal(str_pool_len(pool), 0);
+    assert_int_equal(str_pool_bytes(pool), 0);
+    assert_int_equal(str_pool_add(pool, str_view_of("six")), 0);
+
+    str_pool_del(pool);
+}
+
+static void str_pool_str_test(void** state) {
+    (void) state;
+
+    str* arr[] = {
+        str_from("foo"), str_from("bar"), str_from("foo"), str_new(),
+    };
+
+    str_pool* pool = str_pool_from_strs(arr, 4, false);
+
+    assert_int_equal(str_pool_len(pool), 4);
+    assert_int_equal(str_pool_bytes(pool), 9);
+
+    for (size_t i = 0; i < 4; ++i) {
+        str* s = str_pool_to_str(pool, i);
+
+        assert_true(str_equal(s, arr[i]));
+        str_del(s);
+    }
+
+    str_pool_del(pool);
+
+    pool = str_pool_from_strs(arr, 4, true);
+
+    assert_int_equal(str_pool_len(pool), 3);
+    assert_int_equal(str_pool_bytes(pool), 6);
+    assert_int_equal(str_pool_intern(pool, str_view_of(arr[2])), 0);
+
+    str_pool_del(pool);
+
+    for (size_t i = 0; i < 4; ++i) {
+        str_del(arr[i]);
+    }
+}
+
+
+int main(void) {
+    struct CMUnitTest const tests[] = {
+        cmocka_unit_test(str_pool_add_test),
+        cmocka_unit_test(str_pool_intern_test),
+        cmocka_unit_test(str_pool_views_test),
+        cmocka_unit_test(str_pool_remove_test),
+        cmocka_unit_test(str_pool_str_test),
+    };
+
+
+    return cmocka_run_group_tests(tests, (void*) 0, (void*) 0);
+}
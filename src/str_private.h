@@ -0,0 +1,45 @@
+/* str's private helpers shared between modules
+ *
+ * Nothing here is part of the library's interface: the functions are
+ * either inline or defined in str.c for the modules built with it. */
+#ifndef STR_PRIVATE_H
+#define STR_PRIVATE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "str.h"
+
+/* FNV-1a offset basis, the hash of nothing */
+static const uint64_t STR_FNV1A_BASIS = 0xcbf29ce484222325u;
+
+/* reserves n characters in self, and moves v along if it pointed into
+ * self's buffer, so it stays valid when the buffer moves */
+bool str_reserve_view(str* self, str_view* v, size_t n);
+
+/* drops what a failed decoding appended past len, returns false */
+static inline bool str_rollback(str* self, size_t len) {
+    str_remove(self, len, str_len(self));
+    return false;
+}
+
+/* returns the value of hex digit c, or -1 */
+static inline int str_hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/* folds len bytes into FNV-1a hash h, which starts at STR_FNV1A_BASIS */
+static inline uint64_t str_fnv1a(uint64_t h, char const* data, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        h ^= (unsigned char) data[i];
+        h *= 0x100000001b3u;
+    }
+
+    return h;
+}
+
+#endif /* STR_PRIVATE_H */
@@ -0,0 +1,1517 @@
+#include <assert.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "str_regex.h"
+#include "str_private.h"
+
+/* largest count of a {n,m} repetition */
+static const size_t STR_REGEX_MAX_REPEAT = 1000;
+/* deepest nesting of groups */
+static const size_t STR_REGEX_MAX_DEPTH = 256;
+/* largest compiled program, forward and reverse together */
+static const size_t STR_REGEX_MAX_INSTS = 1 << 16;
+/* the DFA cache is flushed once it holds this many states */
+static const size_t STR_REGEX_MAX_STATES = 1 << 11;
+/* states allocated up front, so a flushed cache always has room */
+static const size_t STR_REGEX_MIN_STATES = 16;
+
+#define NONE SIZE_MAX
+
+/* transitions not computed yet, state 0 is the dead one */
+#define UNKNOWN (-1)
+#define DEAD 0
+
+enum kind {
+    NODE_EMPTY,
+    NODE_SET,
+    NODE_CAT,
+    NODE_ALT,
+    NODE_REPEAT,
+    NODE_GROUP,
+};
+
+struct node {
+    enum kind kind;
+    size_t a;
+    size_t b;
+    size_t set;
+    /* max is NONE for unbounded repetitions */
+    size_t min;
+    size_t max;
+    bool greedy;
+    /* NONE for non-capturing groups */
+    size_t group;
+};
+
+struct set {
+    uint64_t bits[4];
+};
+
+enum op {
+    /* consumes a byte of set x */
+    OP_BYTE,
+    /* follows x first, then y */
+    OP_SPLIT,
+    OP_JMP,
+    /* records the position in capture slot x */
+    OP_SAVE,
+    OP_MATCH,
+};
+
+struct inst {
+    enum op op;
+    size_t x;
+    size_t y;
+};
+
+struct parser {
+    str_view p;
+    size_t i;
+    bool failed;
+
+    struct node* nodes;
+    size_t n_nodes;
+    size_t max_nodes;
+
+    struct set* sets;
+    size_t n_sets;
+    size_t max_sets;
+
+    size_t groups;
+    size_t depth;
+    bool anchored;
+    bool end_anchored;
+    /* a | outside of any group */
+    bool alternated;
+};
+
+struct state {
+    /* the ordered BYTE and MATCH instructions of the state
+     * are lists[list, list + n) */
+    size_t list;
+    size_t n;
+    bool match;
+};
+
+struct dfa {
+    struct str_regex const* re;
+    /* leftmost-first, instructions after a MATCH are dropped */
+    bool cut;
+
+    size_t* lists;
+    size_t lists_used;
+    size_t lists_max;
+
+    struct state* states;
+    int32_t* trans;
+    size_t n_states;
+    size_t max_states;
+
+    /* open addressing hash table of state + 1 */
+    size_t* table;
+    size_t table_max;
+
+    /* start states by start instruction, or NONE */
+    size_t starts[2];
+
+    /* scratch of the closure */
+    size_t* stack;
+    size_t* dense;
+    size_t* sparse;
+    size_t n_dense;
+    size_t* list;
+    size_t n_list;
+    bool list_match;
+};
+
+struct str_regex {
+    struct inst* insts;
+    size_t n_insts;
+    struct set* sets;
+    size_t n_sets;
+
+    size_t groups;
+    bool anchored;
+    bool end_anchored;
+
+    /* the forward program starts with an unanchored .*? loop at 0,
+     * the pattern itself starts at pattern_pc and the reversed
+     * pattern, without captures, at reverse_pc */
+    size_t pattern_pc;
+    size_t reverse_pc;
+
+    /* bytes every match starts with */
+    str* prefix;
+
+    unsigned char classes[UCHAR_MAX + 1];
+    size_t n_classes;
+
+    struct dfa forward;
+    struct dfa reverse;
+};
+
+/* -- Private Interface -- */
+
+static void set_add(struct set* set, unsigned char c) {
+    set->bits[c / 64] |= (uint64_t) 1 << (c % 64);
+}
+
+static void set_range(struct set* set, unsigned char lo, unsigned char hi) {
+    for (unsigned c = lo; c <= hi; ++c) {
+        set_add(set, (unsigned char) c);
+    }
+}
+
+static bool set_has(struct set const* set, unsigned char c) {
+    return set->bits[c / 64] >> (c % 64) & 1;
+}
+
+static void set_negate(struct set* set) {
+    for (size_t i = 0; i < 4; ++i) {
+        set->bits[i] = ~set->bits[i];
+    }
+}
+
+static void set_union(struct set* set, struct set const* other) {
+    for (size_t i = 0; i < 4; ++i) {
+        set->bits[i] |= other->bits[i];
+    }
+}
+
+/* -- Parser -- */
+
+static size_t new_node(struct parser* p, struct node node) {
+    assert(p != (void*) 0);
+
+    if (p->failed) {
+        return NONE;
+    }
+
+    if (p->n_nodes == p->max_nodes) {
+        size_t max = p->max_nodes ? p->max_nodes * 2 : 64;
+        struct node* nodes = realloc(p->nodes, max * sizeof (struct node));
+
+        if (!nodes) {
+            p->failed = true;
+            return NONE;
+        }
+
+        p->nodes = nodes;
+        p->max_nodes = max;
+    }
+
+    p->nodes[p->n_nodes] = node;
+
+    return p->n_nodes++;
+}
+
+static size_t new_set(struct parser* p) {
+    assert(p != (void*) 0);
+
+    if (p->failed) {
+        return NONE;
+    }
+
+    if (p->n_sets == p->max_sets) {
+        size_t max = p->max_sets ? p->max_sets * 2 : 16;
+        struct set* sets = realloc(p->sets, max * sizeof (struct set));
+
+        if (!sets) {
+            p->failed = true;
+            return NONE;
+        }
+
+        p->sets = sets;
+        p->max_sets = max;
+    }
+
+    p->sets[p->n_sets] = (struct set) { { 0, 0, 0, 0 } };
+
+    return p->n_sets++;
+}
+
+static size_t set_node(struct parser* p, size_t set) {
+    return new_node(p, (struct node) { NODE_SET, NONE, NONE, set, 0, 0,
+            false, NONE });
+}
+
+static bool more(struct parser const* p) {
+    return !p->failed && p->i < p->p.len;
+}
+
+static char peek(struct parser const* p) {
+    return p->p.data[p->i];
+}
+
+/* parses the escape after a backslash, it returns the byte it stands
+ * for, or 256 for a class added to set, or -1 if it is invalid */
+static int escape(struct parser* p, struct set* set) {
+    assert(p != (void*) 0);
+
+    if (!more(p)) {
+        return -1;
+    }
+
+    char c = p->p.data[p->i++];
+    struct set class = { { 0, 0, 0, 0 } };
+
+    switch (c) {
+    case 'n': return '\n';
+    case 'r': return '\r';
+    case 't': return '\t';
+    case 'f': return '\f';
+    case 'v': return '\v';
+    case 'x': {
+        if (p->i + 2 > p->p.len) {
+            return -1;
+        }
+
+        int hi = str_hex_digit(p->p.data[p->i]);
+        int lo = str_hex_digit(p->p.data[p->i + 1]);
+
+        if (hi < 0 || lo < 0) {
+            return -1;
+        }
+
+        p->i += 2;
+
+        return hi * 16 + lo;
+    }
+    case 'd': case 'D':
+        set_range(&class, '0', '9');
+        break;
+    case 'w': case 'W':
+        set_range(&class, '0', '9');
+        set_range(&class, 'A', 'Z');
+        set_range(&class, 'a', 'z');
+        set_add(&class, '_');
+        break;
+    case 's': case 'S':
+        set_range(&class, '\t', '\r');
+        set_add(&class, ' ');
+        break;
+    default:
+        /* escaped letters and digits are reserved */
+        if ((c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z')
+                || (c >= 'a' && c <= 'z')) {
+            return -1;
+        }
+
+        return (unsigned char) c;
+    }
+
+    if (c == 'D' || c == 'W' || c == 'S') {
+        set_negate(&class);
+    }
+
+    set_union(set, &class);
+
+    return 256;
+}
+
+static size_t parse_class(struct parser* p) {
+    assert(p != (void*) 0);
+
+    size_t set = new_set(p);
+
+    if (set == NONE) {
+        return NONE;
+    }
+
+    struct set s = { { 0, 0, 0, 0 } };
+    bool negate = more(p) && peek(p) == '^';
+
+    if (negate) {
+        p->i++;
+    }
+
+    /* a ] right after [ or [^ is a member */
+    for (bool first = true; more(p) && (first || peek(p) != ']');
+            first = false) {
+        int lo = (unsigned char) p->p.data[p->i++];
+
+        if (lo == '\\') {
+            lo = escape(p, &s);
+        }
+
+        if (lo < 0) {
+            p->failed = true;
+            return NONE;
+        }
+
+        if (lo == 256) {
+            continue;
+        }
+
+        if (p->i + 1 < p->p.len && peek(p) == '-'
+                && p->p.data[p->i + 1] != ']') {
+            p->i++;
+
+            int hi = (unsigned char) p->p.data[p->i++];
+
+            if (hi == '\\') {
+                hi = escape(p, &s);
+            }
+
+            if (hi < lo || hi == 256) {
+                p->failed = true;
+                return NONE;
+            }
+
+            set_range(&s, (unsigned char) lo, (unsigned char) hi);
+        } else {
+            set_add(&s, (unsigned char) lo);
+        }
+    }
+
+    /* unterminated */
+    if (!more(p)) {
+        p->failed = true;
+        return NONE;
+    }
+
+    p->i++;
+
+    if (negate) {
+        set_negate(&s);
+    }
+
+    p->sets[set] = s;
+
+    return set_node(p, set);
+}
+
+static size_t parse_alt(struct parser* p);
+
+static size_t parse_atom(struct parser* p) {
+    assert(p != (void*) 0);
+
+    char c = p->p.data[p->i++];
+
+    switch (c) {
+    case '(': {
+        size_t group = NONE;
+
+        if (++p->depth > STR_REGEX_MAX_DEPTH) {
+            p->failed = true;
+            return NONE;
+        }
+
+        if (p->i + 1 < p->p.len && peek(p) == '?'
+                && p->p.data[p->i + 1] == ':') {
+            p->i += 2;
+        } else {
+            group = p->groups++;
+        }
+
+        size_t inner = parse_alt(p);
+
+        if (!more(p) || peek(p) != ')') {
+            p->failed = true;
+            return NONE;
+        }
+
+        p->i++;
+        p->depth--;
+
+        return new_node(p, (struct node) { NODE_GROUP, inner, NONE, NONE,
+                0, 0, false, group });
+    }
+    case '*': case '+': case '?': case '^': case '$': case ')':
+        p->failed = true;
+        return NONE;
+    case '[':
+        return parse_class(p);
+    }
+
+    size_t set = new_set(p);
+
+    if (set == NONE) {
+        return NONE;
+    }
+
+    if (c == '.') {
+        set_add(&p->sets[set], '\n');
+        set_negate(&p->sets[set]);
+    } else if (c == '\\') {
+        int e = escape(p, &p->sets[set]);
+
+        if (e < 0) {
+            p->failed = true;
+            return NONE;
+        }
+
+        if (e < 256) {
+            set_add(&p->sets[set], (unsigned char) e);
+        }
+    } else {
+        set_add(&p->sets[set], (unsigned char) c);
+    }
+
+    return set_node(p, set);
+}
+
+static bool parse_number(struct parser* p, size_t* n) {
+    size_t start = p->i;
+
+    *n = 0;
+
+    while (more(p) && peek(p) >= '0' && peek(p) <= '9') {
+        *n = *n * 10 + (size_t) (peek(p) - '0');
+        p->i++;
+
+        if (*n > STR_REGEX_MAX_REPEAT) {
+            p->failed = true;
+            return false;
+        }
+    }
+
+    return p->i > start;
+}
+
+/* parses {n}, {n,} or {n,m} after the brace, and leaves the
+ * position alone if it is none of them */
+static bool parse_count(struct parser* p, size_t* min, size_t* max) {
+    size_t start = p->i;
+
+    if (parse_number(p, min)) {
+        *max = *min;
+
+        if (more(p) && peek(p) == ',') {
+            p->i++;
+
+            if (!parse_number(p, max)) {
+                *max = NONE;
+            }
+        }
+
+        if (more(p) && peek(p) == '}') {
+            p->i++;
+            return true;
+        }
+    }
+
+    p->i = start;
+
+    return false;
+}
+
+static size_t parse_repeat(struct parser* p) {
+    assert(p != (void*) 0);
+
+    size_t atom = parse_atom(p);
+
+    while (more(p)) {
+        char c = peek(p);
+        size_t min;
+        size_t max;
+
+        if (c == '*') {
+            min = 0;
+            max = NONE;
+        } else if (c == '+') {
+            min = 1;
+            max = NONE;
+        } else if (c == '?') {
+            min = 0;
+            max = 1;
+        } else if (c == '{') {
+            p->i++;
+
+            /* a brace starting no count is a literal */
+            if (!parse_count(p, &min, &max)) {
+                p->i--;
+                break;
+            }
+
+            p->i--;
+
+            if (max != NONE && max < min) {
+                p->failed = true;
+                return NONE;
+            }
+        } else {
+            break;
+        }
+
+        p->i++;
+
+        bool greedy = true;
+
+        if (more(p) && peek(p) == '?') {
+            greedy = false;
+            p->i++;
+        }
+
+        atom = new_node(p, (struct node) { NODE_REPEAT, atom, NONE, NONE,
+                min, max, greedy, NONE });
+    }
+
+    return atom;
+}
+
+static size_t parse_cat(struct parser* p) {
+    assert(p != (void*) 0);
+
+    size_t left = new_node(p, (struct node) { NODE_EMPTY, NONE, NONE, NONE,
+            0, 0, false, NONE });
+
+    while (more(p) && peek(p) != '|' && peek(p) != ')') {
+        if (peek(p) == '$' && p->i + 1 == p->p.len) {
+            p->end_anchored = true;
+            p->i++;
+            break;
+        }
+
+        size_t right = parse_repeat(p);
+
+        if (p->failed) {
+            return NONE;
+        }
+
+        left = p->nodes[left].kind == NODE_EMPTY ? right
+            : new_node(p, (struct node) { NODE_CAT, left, right, NONE,
+                    0, 0, false, NONE });
+    }
+
+    return left;
+}
+
+static size_t parse_alt(struct parser* p) {
+    assert(p != (void*) 0);
+
+    size_t left = parse_cat(p);
+
+    while (more(p) && peek(p) == '|') {
+        p->alternated |= !p->depth;
+        p->i++;
+
+        size_t right = parse_cat(p);
+
+        left = new_node(p, (struct node) { NODE_ALT, left, right, NONE,
+                0, 0, false, NONE });
+    }
+
+    return left;
+}
+
+/* -- Compiler -- */
+
+struct compiler {
+    struct parser const* p;
+    struct inst* insts;
+    size_t n;
+    size_t max;
+    bool failed;
+};
+
+static size_t emit_inst(struct compiler* c, enum op op, size_t x, size_t y) {
+    assert(c != (void*) 0);
+
+    if (c->failed || c->n >= STR_REGEX_MAX_INSTS) {
+        c->failed = true;
+        return NONE;
+    }
+
+    if (c->n == c->max) {
+        size_t max = c->max ? c->max * 2 : 64;
+        struct inst* insts = realloc(c->insts, max * sizeof (struct inst));
+
+        if (!insts) {
+            c->failed = true;
+            return NONE;
+        }
+
+        c->insts = insts;
+        c->max = max;
+    }
+
+    c->insts[c->n] = (struct inst) { op, x, y };
+
+    return c->n++;
+}
+
+static void patch_split(struct compiler* c, size_t split, size_t body,
+        size_t out, bool greedy) {
+    if (c->failed) {
+        return;
+    }
+
+    c->insts[split].x = greedy ? body : out;
+    c->insts[split].y = greedy ? out : body;
+}
+
+static void emit(struct compiler* c, size_t node, bool reverse);
+
+/* emits count nested optional copies of node, x(x(x)?)? for 3 */
+static void emit_optional(struct compiler* c, struct node const* node,
+        size_t count, bool reverse) {
+    if (!count || c->failed) {
+        return;
+    }
+
+    size_t split = emit_inst(c, OP_SPLIT, 0, 0);
+
+    emit(c, node->a, reverse);
+    emit_optional(c, node, count - 1, reverse);
+    patch_split(c, split, split + 1, c->n, node->greedy);
+}
+
+static void emit(struct compiler* c, size_t index, bool reverse) {
+    assert(c != (void*) 0);
+
+    if (c->failed) {
+        return;
+    }
+
+    struct node const* node = &c->p->nodes[index];
+
+    switch (node->kind) {
+    case NODE_EMPTY:
+        break;
+    case NODE_SET:
+        emit_inst(c, OP_BYTE, node->set, 0);
+        break;
+    case NODE_CAT:
+        emit(c, reverse ? node->b : node->a, reverse);
+        emit(c, reverse ? node->a : node->b, reverse);
+        break;
+    case NODE_ALT: {
+        size_t split = emit_inst(c, OP_SPLIT, 0, 0);
+
+        emit(c, node->a, reverse);
+
+        size_t jmp = emit_inst(c, OP_JMP, 0, 0);
+        size_t second = c->n;
+
+        emit(c, node->b, reverse);
+        patch_split(c, split, split + 1, second, true);
+
+        if (!c->failed) {
+            c->insts[jmp].x = c->n;
+        }
+
+        break;
+    }
+    case NODE_REPEAT:
+        for (size_t i = 0; i < node->min; ++i) {
+            emit(c, node->a, reverse);
+        }
+
+        if (node->max == NONE) {
+            size_t split = emit_inst(c, OP_SPLIT, 0, 0);
+
+            emit(c, node->a, reverse);
+            emit_inst(c, OP_JMP, split, 0);
+            patch_split(c, split, split + 1, c->n, node->greedy);
+        } else {
+            emit_optional(c, node, node->max - node->min, reverse);
+        }
+
+        break;
+    case NODE_GROUP:
+        if (!reverse && node->group != NONE) {
+            emit_inst(c, OP_SAVE, 2 * node->group, 0);
+            emit(c, node->a, reverse);
+            emit_inst(c, OP_SAVE, 2 * node->group + 1, 0);
+        } else {
+            emit(c, node->a, reverse);
+        }
+
+        break;
+    }
+}
+
+/* appends the bytes every match of node starts with, and returns
+ * whether node is a plain literal, so what follows it counts too */
+static bool literal_prefix(struct parser const* p, size_t index, str* out) {
+    struct node const* node = &p->nodes[index];
+
+    switch (node->kind) {
+    case NODE_EMPTY:
+        return true;
+    case NODE_SET: {
+        struct set const* set = &p->sets[node->set];
+        size_t count = 0;
+        unsigned char byte = 0;
+
+        for (unsigned c = 0; c <= UCHAR_MAX; ++c) {
+            if (set_has(set, (unsigned char) c)) {
+                byte = (unsigned char) c;
+                count++;
+            }
+        }
+
+        return count == 1 && str_append_char(out, (char) byte);
+    }
+    case NODE_CAT:
+        return literal_prefix(p, node->a, out)
+            && literal_prefix(p, node->b, out);
+    case NODE_GROUP:
+        return literal_prefix(p, node->a, out);
+    case NODE_REPEAT:
+        for (size_t i = 0; i < node->min; ++i) {
+            if (!literal_prefix(p, node->a, out)) {
+                return false;
+            }
+        }
+
+        return node->min == node->max;
+    case NODE_ALT:
+        break;
+    }
+
+    return false;
+}
+
+/* splits the bytes in classes no instruction tells apart */
+static void byte_classes(struct str_regex* re) {
+    bool boundary[UCHAR_MAX + 1] = { false };
+
+    for (size_t i = 0; i < re->n_sets; ++i) {
+        for (unsigned c = 1; c <= UCHAR_MAX; ++c) {
+            if (set_has(&re->sets[i], (unsigned char) c)
+                    != set_has(&re->sets[i], (unsigned char) (c - 1))) {
+                boundary[c] = true;
+            }
+        }
+    }
+
+    re->classes[0] = 0;
+
+    for (unsigned c = 1; c <= UCHAR_MAX; ++c) {
+        re->classes[c] = (unsigned char) (re->classes[c - 1] + boundary[c]);
+    }
+
+    re->n_classes = (size_t) re->classes[UCHAR_MAX] + 1;
+}
+
+/* -- Lazy DFA -- */
+
+static void dfa_del(struct dfa* d) {
+    free(d->lists);
+    free(d->states);
+    free(d->trans);
+    free(d->table);
+    free(d->stack);
+    free(d->dense);
+    free(d->sparse);
+    free(d->list);
+}
+
+static void flush(struct dfa* d) {
+    assert(d != (void*) 0);
+
+    d->n_states = 1;
+    d->lists_used = 0;
+    d->states[DEAD] = (struct state) { 0, 0, false };
+    d->starts[0] = NONE;
+    d->starts[1] = NONE;
+
+    memset(d->table, 0, d->table_max * sizeof (size_t));
+
+    /* the dead state stays dead */
+    for (size_t c = 0; c < d->re->n_classes; ++c) {
+        d->trans[c] = DEAD;
+    }
+}
+
+static bool grow_states(struct dfa* d, size_t max) {
+    assert(d != (void*) 0);
+
+    size_t n_classes = d->re->n_classes;
+    struct state* states = realloc(d->states, max * sizeof (struct state));
+
+    if (!states) {
+        return false;
+    }
+
+    d->states = states;
+
+    int32_t* trans = realloc(d->trans, max * n_classes * sizeof (int32_t));
+
+    if (!trans) {
+        return false;
+    }
+
+    d->trans = trans;
+
+    /* rehashes into a table twice as large as the states */
+    size_t* table = calloc(2 * max, sizeof (size_t));
+
+    if (!table) {
+        return false;
+    }
+
+    free(d->table);
+    d->table = table;
+    d->table_max = 2 * max;
+    d->max_states = max;
+
+    for (size_t s = 1; s < d->n_states; ++s) {
+        uint64_t h = 0xcbf29ce484222325u;
+
+        for (size_t k = 0; k < d->states[s].n; ++k) {
+            h = (h ^ d->lists[d->states[s].list + k]) * 0x100000001b3u;
+        }
+
+        size_t slot = (size_t) h & (d->table_max - 1);
+
+        while (d->table[slot]) {
+            slot = (slot + 1) & (d->table_max - 1);
+        }
+
+        d->table[slot] = s + 1;
+    }
+
+    return true;
+}
+
+static bool dfa_new(struct dfa* d, struct str_regex const* re, bool cut) {
+    assert(d != (void*) 0);
+
+    size_t n = re->n_insts;
+
+    *d = (struct dfa) { 0 };
+    d->re = re;
+    d->cut = cut;
+
+    d->lists_max = 4 * n;
+    d->lists = malloc(d->lists_max * sizeof (size_t));
+    d->stack = malloc((2 * n + 1) * sizeof (size_t));
+    d->dense = malloc(n * sizeof (size_t));
+    d->sparse = calloc(n, sizeof (size_t));
+    d->list = malloc(n * sizeof (size_t));
+
+    if (!d->lists || !d->stack || !d->dense || !d->sparse || !d->list
+            || !grow_states(d, STR_REGEX_MIN_STATES)) {
+        dfa_del(d);
+        return false;
+    }
+
+    flush(d);
+
+    return true;
+}
+
+/* appends the BYTE and MATCH instructions reachable from pc to the
+ * list in priority order, and returns true if a MATCH cut it short */
+static bool follow(struct dfa* d, size_t pc) {
+    assert(d != (void*) 0);
+
+    struct inst const* insts = d->re->insts;
+    size_t top = 0;
+
+    d->stack[top++] = pc;
+
+    while (top) {
+        pc = d->stack[--top];
+
+        size_t k = d->sparse[pc];
+
+        if (k < d->n_dense && d->dense[k] == pc) {
+            continue;
+        }
+
+        d->sparse[pc] = d->n_dense;
+        d->dense[d->n_dense++] = pc;
+
+        switch (insts[pc].op) {
+        case OP_JMP:
+            d->stack[top++] = insts[pc].x;
+            break;
+        case OP_SPLIT:
+            d->stack[top++] = insts[pc].y;
+            d->stack[top++] = insts[pc].x;
+            break;
+        case OP_SAVE:
+            d->stack[top++] = pc + 1;
+            break;
+        case OP_BYTE:
+            d->list[d->n_list++] = pc;
+            break;
+        case OP_MATCH:
+            d->list[d->n_list++] = pc;
+            d->list_match = true;
+
+            if (d->cut) {
+                return true;
+            }
+
+            break;
+        }
+    }
+
+    return false;
+}
+
+static void reset(struct dfa* d) {
+    d->n_dense = 0;
+    d->n_list = 0;
+    d->list_match = false;
+}
+
+/* returns the state of the list, or NONE if the cache is full */
+static size_t intern(struct dfa* d) {
+    assert(d != (void*) 0);
+
+    if (!d->n_list) {
+        return DEAD;
+    }
+
+    uint64_t h = 0xcbf29ce484222325u;
+
+    for (size_t k = 0; k < d->n_list; ++k) {
+        h = (h ^ d->list[k]) * 0x100000001b3u;
+    }
+
+    size_t slot = (size_t) h & (d->table_max - 1);
+
+    for (; d->table[slot]; slot = (slot + 1) & (d->table_max - 1)) {
+        struct state const* s = &d->states[d->table[slot] - 1];
+
+        if (s->n == d->n_list && !memcmp(d->lists + s->list, d->list,
+                    d->n_list * sizeof (size_t))) {
+            return d->table[slot] - 1;
+        }
+    }
+
+    if (d->n_states == d->max_states) {
+        if (d->max_states >= STR_REGEX_MAX_STATES
+                || !grow_states(d, 2 * d->max_states)) {
+            return NONE;
+        }
+
+        /* the table was rebuilt */
+        return intern(d);
+    }
+
+    if (d->lists_used + d->n_list > d->lists_max) {
+        size_t max = 2 * d->lists_max;
+        size_t* lists = realloc(d->lists, max * sizeof (size_t));
+
+        if (!lists) {
+            return NONE;
+        }
+
+        d->lists = lists;
+        d->lists_max = max;
+    }
+
+    size_t s = d->n_states++;
+
+    memcpy(d->lists + d->lists_used, d->list, d->n_list * sizeof (size_t));
+    d->states[s] = (struct state) { d->lists_used, d->n_list, d->list_match };
+    d->lists_used += d->n_list;
+    d->table[slot] = s + 1;
+
+    memset(d->trans + s * d->re->n_classes, UNKNOWN & 0xff,
+            d->re->n_classes * sizeof (int32_t));
+
+    return s;
+}
+
+/* interns the list, flushing the cache if it is full */
+static size_t intern_or_flush(struct dfa* d) {
+    size_t s = intern(d);
+
+    if (s == NONE) {
+        /* the list survives the flush, which always leaves room */
+        flush(d);
+        s = intern(d);
+    }
+
+    assert(s != NONE);
+
+    return s;
+}
+
+static size_t start(struct dfa* d, size_t pc, size_t slot) {
+    assert(d != (void*) 0);
+
+    if (d->starts[slot] == NONE) {
+        reset(d);
+        follow(d, pc);
+        d->starts[slot] = intern_or_flush(d);
+    }
+
+    return d->starts[slot];
+}
+
+static size_t step(struct dfa* d, size_t s, unsigned char byte) {
+    assert(d != (void*) 0);
+
+    size_t n_classes = d->re->n_classes;
+    int32_t next = d->trans[s * n_classes + d->re->classes[byte]];
+
+    if (next != UNKNOWN) {
+        return (size_t) next;
+    }
+
+    struct inst const* insts = d->re->insts;
+    struct state state = d->states[s];
+
+    reset(d);
+
+    for (size_t k = 0; k < state.n; ++k) {
+        size_t pc = d->lists[state.list + k];
+
+        if (insts[pc].op == OP_BYTE
+                && set_has(&d->re->sets[insts[pc].x], byte)
+                && follow(d, pc + 1)) {
+            break;
+        }
+    }
+
+    size_t t = intern(d);
+
+    if (t == NONE) {
+        /* s goes with the flush, so the transition isn't cached */
+        flush(d);
+        t = intern(d);
+        assert(t != NONE);
+        return t;
+    }
+
+    d->trans[s * n_classes + d->re->classes[byte]] = (int32_t) t;
+
+    return t;
+}
+
+/* -- Search -- */
+
+/* returns the end of the leftmost-first match starting at or after
+ * from, or NONE */
+static size_t forward(struct str_regex* re, str_view subject, size_t from) {
+    struct dfa* d = &re->forward;
+    size_t pc = re->anchored ? re->pattern_pc : 0;
+    size_t slot = re->anchored ? 0 : 1;
+    size_t s = start(d, pc, slot);
+    /* anchored matches can't be skipped to */
+    str_view prefix = re->anchored ? str_view_of("")
+        : str_view_of(re->prefix);
+    size_t last = d->states[s].match ? from : NONE;
+
+    for (size_t i = from; i < subject.len; ++i) {
+        /* nothing in progress, skips to where a match could start */
+        if (prefix.len && s == start(d, pc, slot)) {
+            i = str_view_find(subject, prefix, i);
+
+            if (i == STR_NPOS) {
+                break;
+            }
+        }
+
+        s = step(d, s, (unsigned char) subject.data[i]);
+
+        if (s == DEAD) {
+            break;
+        }
+
+        if (d->states[s].match) {
+            last = i + 1;
+        }
+    }
+
+    return last;
+}
+
+/* returns the smallest start in [from, end] of a match ending at end,
+ * or NONE */
+static size_t backward(struct str_regex* re, str_view subject, size_t from,
+        size_t end) {
+    struct dfa* d = &re->reverse;
+    size_t s = start(d, re->reverse_pc, 0);
+    size_t first = d->states[s].match ? end : NONE;
+
+    for (size_t i = end; i > from; --i) {
+        s = step(d, s, (unsigned char) subject.data[i - 1]);
+
+        if (s == DEAD) {
+            break;
+        }
+
+        if (d->states[s].match) {
+            first = i - 1;
+        }
+    }
+
+    return first;
+}
+
+static bool find(struct str_regex* re, str_view subject, size_t from,
+        str_regex_span* span) {
+    assert(re != (void*) 0);
+
+    if ((!subject.data && subject.len) || from > subject.len) {
+        return false;
+    }
+
+    /* ^ only matches at the start of the subject */
+    if (re->anchored && from) {
+        return false;
+    }
+
+    size_t begin;
+    size_t end;
+
+    if (re->end_anchored) {
+        /* the match ends at the end, and starts as far left as possible */
+        end = subject.len;
+        begin = backward(re, subject, from, end);
+
+        if (begin == NONE || (re->anchored && begin)) {
+            return false;
+        }
+    } else {
+        end = forward(re, subject, from);
+
+        if (end == NONE) {
+            return false;
+        }
+
+        begin = re->anchored ? 0 : backward(re, subject, from, end);
+    }
+
+    assert(begin != NONE);
+
+    if (span) {
+        *span = (str_regex_span) { begin, end };
+    }
+
+    return true;
+}
+
+/* -- Pike VM -- */
+
+struct pike_list {
+    size_t* dense;
+    size_t* sparse;
+    size_t n;
+    /* capture slots of the thread at dense[k] are caps[k * n_caps] */
+    size_t* caps;
+};
+
+struct pike_job {
+    size_t pc;
+    /* restores cap[slot] to old once pc is done, if slot isn't NONE */
+    size_t slot;
+    size_t old;
+};
+
+struct pike {
+    struct str_regex const* re;
+    size_t n_caps;
+    struct pike_list lists[2];
+    struct pike_job* stack;
+    size_t* cap;
+};
+
+static void pike_add(struct pike* vm, struct pike_list* list, size_t pc,
+        size_t pos) {
+    struct inst const* insts = vm->re->insts;
+    size_t top = 0;
+
+    vm->stack[top++] = (struct pike_job) { pc, NONE, 0 };
+
+    while (top) {
+        struct pike_job job = vm->stack[--top];
+
+        if (job.slot != NONE) {
+            vm->cap[job.slot] = job.old;
+            continue;
+        }
+
+        pc = job.pc;
+
+        size_t k = list->sparse[pc];
+
+        if (k < list->n && list->dense[k] == pc) {
+            continue;
+        }
+
+        k = list->n++;
+        list->sparse[pc] = k;
+        list->dense[k] = pc;
+
+        switch (insts[pc].op) {
+        case OP_JMP:
+            vm->stack[top++] = (struct pike_job) { insts[pc].x, NONE, 0 };
+            break;
+        case OP_SPLIT:
+            vm->stack[top++] = (struct pike_job) { insts[pc].y, NONE, 0 };
+            vm->stack[top++] = (struct pike_job) { insts[pc].x, NONE, 0 };
+            break;
+        case OP_SAVE:
+            vm->stack[top++] = (struct pike_job) { 0, insts[pc].x,
+                vm->cap[insts[pc].x] };
+            vm->stack[top++] = (struct pike_job) { pc + 1, NONE, 0 };
+            vm->cap[insts[pc].x] = pos;
+            break;
+        case OP_BYTE:
+        case OP_MATCH:
+            memcpy(list->caps + k * vm->n_caps, vm->cap,
+                    vm->n_caps * sizeof (size_t));
+            break;
+        }
+    }
+}
+
+static void pike_del(struct pike* vm) {
+    for (size_t i = 0; i < 2; ++i) {
+        free(vm->lists[i].dense);
+        free(vm->lists[i].sparse);
+        free(vm->lists[i].caps);
+    }
+
+    free(vm->stack);
+    free(vm->cap);
+}
+
+static bool pike_new(struct pike* vm, struct str_regex const* re) {
+    size_t n = re->n_insts;
+
+    *vm = (struct pike) { 0 };
+    vm->re = re;
+    vm->n_caps = 2 * re->groups;
+
+    bool ok = true;
+
+    for (size_t i = 0; i < 2; ++i) {
+        vm->lists[i].dense = malloc(n * sizeof (size_t));
+        vm->lists[i].sparse = calloc(n, sizeof (size_t));
+        vm->lists[i].caps = malloc(n * vm->n_caps * sizeof (size_t));
+
+        ok = ok && vm->lists[i].dense && vm->lists[i].sparse
+            && vm->lists[i].caps;
+    }
+
+    vm->stack = malloc((3 * n + 1) * sizeof (struct pike_job));
+    vm->cap = malloc(vm->n_caps * sizeof (size_t));
+
+    if (!ok || !vm->stack || !vm->cap) {
+        pike_del(vm);
+        return false;
+    }
+
+    return true;
+}
+
+/* resolves the captures of the leftmost-first match
+ * spanning [begin, end) into out */
+static void pike_run(struct pike* vm, str_view subject, size_t begin,
+        size_t end, size_t* out) {
+    struct str_regex const* re = vm->re;
+    struct pike_list* clist = &vm->lists[0];
+    struct pike_list* nlist = &vm->lists[1];
+
+    for (size_t i = 0; i < vm->n_caps; ++i) {
+        vm->cap[i] = NONE;
+        out[i] = NONE;
+    }
+
+    clist->n = 0;
+    pike_add(vm, clist, re->pattern_pc, begin);
+
+    for (size_t pos = begin; clist->n; ++pos) {
+        nlist->n = 0;
+
+        for (size_t k = 0; k < clist->n; ++k) {
+            struct inst const* inst = &re->insts[clist->dense[k]];
+            size_t* caps = clist->caps + k * vm->n_caps;
+
+            if (inst->op == OP_MATCH
+                    && (!re->end_anchored || pos == subject.len)) {
+                /* the lower priority threads are cut */
+                memcpy(out, caps, vm->n_caps * sizeof (size_t));
+                break;
+            }
+
+            if (inst->op == OP_BYTE && pos < end
+                    && set_has(&re->sets[inst->x],
+                        (unsigned char) subject.data[pos])) {
+                memcpy(vm->cap, caps, vm->n_caps * sizeof (size_t));
+                pike_add(vm, nlist, clist->dense[k] + 1, pos + 1);
+            }
+        }
+
+        if (pos == end) {
+            break;
+        }
+
+        struct pike_list* t = clist;
+        clist = nlist;
+        nlist = t;
+    }
+}
+
+/* -- Public Interface Implementation -- */
+
+str_regex* str_regex_new(str_view pattern) {
+    if (!pattern.data && pattern.len) {
+        return (void*) 0;
+    }
+
+    struct parser p = { .p = pattern, .groups = 1 };
+
+    if (more(&p) && peek(&p) == '^') {
+        p.anchored = true;
+        p.i++;
+    }
+
+    size_t root = parse_alt(&p);
+
+    /* a ) without its ( stops the parser early, and anchors bind to
+     * the whole pattern, so ^a|b would silently read ^(?:a|b) */
+    if (p.failed || p.i != pattern.len || root == NONE
+            || (p.alternated && (p.anchored || p.end_anchored))) {
+        free(p.nodes);
+        free(p.sets);
+        return (void*) 0;
+    }
+
+    struct str_regex* re = calloc(1, sizeof (struct str_regex));
+    struct compiler c = { &p, (void*) 0, 0, 0, false };
+
+    /* .*? loop, the pattern within group 0, and its reverse */
+    size_t any = new_set(&p);
+
+    if (any != NONE) {
+        set_negate(&p.sets[any]);
+    }
+
+    emit_inst(&c, OP_SPLIT, 3, 1);
+    emit_inst(&c, OP_BYTE, any, 0);
+    emit_inst(&c, OP_JMP, 0, 0);
+    emit_inst(&c, OP_SAVE, 0, 0);
+    emit(&c, root, false);
+    emit_inst(&c, OP_SAVE, 1, 0);
+    emit_inst(&c, OP_MATCH, 0, 0);
+
+    size_t reverse_pc = c.n;
+
+    emit(&c, root, true);
+    emit_inst(&c, OP_MATCH, 0, 0);
+
+    if (!re || p.failed || c.failed) {
+        free(re);
+        free(c.insts);
+        free(p.nodes);
+        free(p.sets);
+        return (void*) 0;
+    }
+
+    re->insts = c.insts;
+    re->n_insts = c.n;
+    re->sets = p.sets;
+    re->n_sets = p.n_sets;
+    re->groups = p.groups;
+    re->anchored = p.anchored;
+    re->end_anchored = p.end_anchored;
+    re->pattern_pc = 3;
+    re->reverse_pc = reverse_pc;
+    re->prefix = str_new();
+
+    byte_classes(re);
+
+    if (re->prefix) {
+        literal_prefix(&p, root, re->prefix);
+    }
+
+    free(p.nodes);
+
+    bool forward_ok = re->prefix && dfa_new(&re->forward, re, true);
+
+    if (!forward_ok || !dfa_new(&re->reverse, re, false)) {
+        if (forward_ok) {
+            dfa_del(&re->forward);
+        }
+
+        str_del(re->prefix);
+        free(re->insts);
+        free(re->sets);
+        free(re);
+        return (void*) 0;
+    }
+
+    return re;
+}
+
+void str_regex_del(str_regex* self) {
+    if (!self) {
+        return;
+    }
+
+    dfa_del(&self->forward);
+    dfa_del(&self->reverse);
+    str_del(self->prefix);
+    free(self->insts);
+    free(self->sets);
+    free(self);
+}
+
+size_t str_regex_groups(str_regex* self) {
+    return self ? self->groups : 0;
+}
+
+bool str_regex_match(str_regex* self, str_view subject) {
+    if (!self || (!subject.data && subject.len)) {
+        return false;
+    }
+
+    /* ^ and $ hold at the edges of a full match */
+    return backward(self, subject, 0, subject.len) == 0;
+}
+
+bool str_regex_find(str_regex* self, str_view subject, size_t from,
+        str_regex_span* span) {
+    if (!self) {
+        return false;
+    }
+
+    return find(self, subject, from, span);
+}
+
+bool str_regex_captures(str_regex* self, str_view subject, size_t from,
+        str_regex_span* groups, size_t n) {
+    if (!self || (!groups && n)) {
+        return false;
+    }
+
+    str_regex_span span;
+
+    if (!find(self, subject, from, &span)) {
+        return false;
+    }
+
+    struct pike vm;
+
+    if (!pike_new(&vm, self)) {
+        return false;
+    }
+
+    size_t* caps = malloc(vm.n_caps * sizeof (size_t));
+
+    if (!caps) {
+        pike_del(&vm);
+        return false;
+    }
+
+    pike_run(&vm, subject, span.begin, span.end, caps);
+
+    for (size_t i = 0; i < n; ++i) {
+        bool set = i < self->groups && caps[2 * i] != NONE
+            && caps[2 * i + 1] != NONE;
+
+        groups[i] = set ? (str_regex_span) { caps[2 * i], caps[2 * i + 1] }
+            : (str_regex_span) { STR_NPOS, STR_NPOS };
+    }
+
+    free(caps);
+    pike_del(&vm);
+
+    return true;
+}
@@ -0,0 +1,120 @@
+/** str's Regular Expressions
+ * @file str_regex.h
+ *
+ * Patterns are compiled to a Thompson NFA, which is searched by a
+ * DFA built lazily from it and cached, so matching takes linear time
+ * in the length of the subject. Capture groups are resolved by a Pike
+ * VM over the span found by the DFA.
+ *
+ * The syntax works on bytes:
+ *
+ *     c          the byte c, or any of \ . [ ] ( ) | * + ? { ^ $ escaped
+ *     .          any byte but '\n'
+ *     [a-z_]     any byte of the class, [^...] any byte outside of it
+ *     \d \w \s   digits, word bytes and white space, \D \W \S negated
+ *     \n \t ...  \n \r \t \f \v and \xHH
+ *     (re)       capture group, (?:re) non-capturing group
+ *     re|re      alternation, the leftmost alternative that matches wins
+ *     re* re+ re? re{n} re{n,} re{n,m}
+ *                repetition, greedy unless followed by ?
+ *     ^ $        start and end of the subject, only as the first and
+ *                last byte of the pattern, which they anchor as a
+ *                whole, so alternatives next to them must be grouped:
+ *                ^(?:a|b)$ compiles, ^a|b$ doesn't
+ *
+ * Matches follow the leftmost-first semantics of Perl, but for loops
+ * whose body can match the empty string. Perl ends a loop on its first
+ * empty iteration, here empty iterations are skipped: (|b)* matches all
+ * of "bb", where Perl matches nothing, and (a*)* leaves group 1 unset on
+ * "b", where Perl sets it to [0, 0). */
+#ifndef STR_REGEX_H
+#define STR_REGEX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "str.h"
+
+/** Opaque str_regex Structure
+ * @warning    Matching updates the DFA cache of the object, so it must
+ *             not be shared between threads without synchronization. */
+typedef struct str_regex str_regex;
+
+/** Span of a match or a capture group.
+ * @note       Groups that took no part in the match span
+ *             [STR_NPOS, STR_NPOS). */
+typedef struct str_regex_span {
+    size_t begin;
+    size_t end;
+} str_regex_span;
+
+/** Compiles regular expression.
+ * @warning    The user has to free the object after usage with
+ *             str_regex_del.
+ *
+ * @param pattern A view over the pattern.
+ *
+ * @return     A pointer to a str_regex object or null if the pattern is
+ *             invalid or too large.
+ *
+ * @see str_regex_del */
+str_regex* str_regex_new(str_view pattern);
+
+/** Deletes regular expression.
+ * @param self A pointer to a str_regex object. */
+void str_regex_del(str_regex* self);
+
+/** Returns number of capture groups.
+ * @note       Group 0 is the whole match, so it is at least one.
+ *
+ * @param self A pointer to a str_regex object. */
+size_t str_regex_groups(str_regex* self);
+
+/** Checks whether regular expression matches the whole subject.
+ * @param self    A pointer to a str_regex object.
+ * @param subject A view.
+ *
+ * @return        true if the subject matches.
+ *
+ * @see str_regex_find */
+bool str_regex_match(str_regex* self, str_view subject);
+
+/** Finds the leftmost match in subject.
+ * @note       Matches start at or after from, to iterate over all the
+ *             matches pass the end of the previous one, plus one if
+ *             it was empty.
+ *
+ * @param self    A pointer to a str_regex object.
+ * @param subject A view.
+ * @param from    Index where the search starts.
+ * @param span    Receives the span of the match, may be null.
+ *
+ * @return        true if a match was found.
+ *
+ * @see str_regex_captures */
+bool str_regex_find(str_regex* self, str_view subject, size_t from,
+        str_regex_span* span);
+
+/** Finds the leftmost match in subject and its capture groups.
+ * @param self    A pointer to a str_regex object.
+ * @param subject A view.
+ * @param from    Index where the search starts.
+ * @param groups  A pointer to an array receiving the spans of the
+ *                groups, starting with the whole match.
+ * @param n       Number of spans to receive.
+ *
+ * @return        true if a match was found.
+ *
+ * @see str_regex_find str_regex_groups */
+bool str_regex_captures(str_regex* self, str_view subject, size_t from,
+        str_regex_span* groups, size_t n);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* STR_REGEX_H */
@@ -0,0 +1,305 @@
+#include <assert.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cmocka.h>
+
+#include "str.h"
+#include "str_regex.h"
+
+/* returns the span of the first match as "begin-end", or "none" */
+static char const* find(char const* pattern, char const* subject,
+        size_t from) {
+    static char buf[64];
+    str_regex* re = str_regex_new(str_view_of(pattern));
+    str_regex_span span;
+
+    assert_non_null(re);
+
+    if (!str_regex_find(re, str_view_of(subject), from, &span)) {
+        str_regex_del(re);
+        return "none";
+    }
+
+    str_regex_del(re);
+    snprintf(buf, sizeof buf, "%zu-%zu", span.begin, span.end);
+
+    return buf;
+}
+
+static void str_regex_find_test(void** state) {
+    (void) state;
+
+    assert_string_equal(find("abc", "xxabcxx", 0), "2-5");
+    assert_string_equal(find("abc", "xxabxx", 0), "none");
+    assert_string_equal(find("a.c", "a\nc abc", 0), "4-7");
+    assert_string_equal(find("[0-9]+", "abc 123 45", 0), "4-7");
+    assert_string_equal(find("[0-9]+", "abc 123 45", 7), "8-10");
+    assert_string_equal(find("[^a-c]+", "abcdefabc", 0), "3-6");
+    assert_string_equal(find("[]x]+", "ab]x]c", 0), "2-5");
+    assert_string_equal(find("\\d\\s\\w", "x1 y", 0), "1-4");
+    assert_string_equal(find("\\x41\\.", "xA.", 0), "1-3");
+    assert_string_equal(find("a{2,3}", "aaaa", 0), "0-3");
+    assert_string_equal(find("a{2}", "abaa", 0), "2-4");
+    assert_string_equal(find("a{2,}b", "aaaab", 0), "0-5");
+    assert_string_equal(find("a{,2}", "a{,2}", 0), "0-5");
+    assert_string_equal(find("x*", "abc", 0), "0-0");
+    assert_string_equal(find("", "abc", 3), "3-3");
+    assert_string_equal(find("", "abc", 4), "none");
+}
+
+static void str_regex_leftmost_first_test(void** state) {
+    (void) state;
+
+    /* the first alternative wins, not the longest */
+    assert_string_equal(find("a|ab", "ab", 0), "0-1");
+    assert_string_equal(find("ab|a", "ab", 0), "0-2");
+    assert_string_equal(find("(?:a|ab)c", "abc", 0), "0-3");
+
+    /* the leftmost start wins over a longer match later */
+    assert_string_equal(find("b+|a", "ab", 0), "0-1");
+
+    assert_string_equal(find("a+", "aaa", 0), "0-3");
+    assert_string_equal(find("a+?", "aaa", 0), "0-1");
+    assert_string_equal(find("a*?b", "aab", 0), "0-3");
+    assert_string_equal(find("<.*>", "<a><b>", 0), "0-6");
+    assert_string_equal(find("<.*?>", "<a><b>", 0), "0-3");
+    assert_string_equal(find("a??", "a", 0), "0-0");
+
+    /* unlike Perl, an iteration matching nothing doesn't end the loop */
+    assert_string_equal(find("(|b)*", "bb", 0), "0-2");
+    assert_string_equal(find("(?:b|)*", "bb", 0), "0-2");
+}
+
+static void str_regex_anchor_test(void** state) {
+    (void) state;
+
+    assert_string_equal(find("^ab", "abab", 0), "0-2");
+    assert_string_equal(find("^ab", "abab", 1), "none");
+    assert_string_equal(find("^b", "ab", 0), "none");
+    assert_string_equal(find("ab$", "abab", 0), "2-4");
+    assert_string_equal(find("a+$", "aabaa", 0), "3-5");
+    assert_string_equal(find("^a+$", "aaa", 0), "0-3");
+    assert_string_equal(find("^a+$", "aab", 0), "none");
+    assert_string_equal(find("^$", "", 0), "0-0");
+    assert_string_equal(find("^(?:a|b)$", "ba", 0), "none");
+    assert_string_equal(find("^(?:a|b)", "xb", 0), "none");
+    assert_string_equal(find("(?:a|b)$", "xb", 0), "1-2");
+    assert_string_equal(find("^(?:a|b)", "ab", 0), "0-1");
+    assert_string_equal(find("^(?:a|b)$", "ab", 0), "none");
+    assert_string_equal(find("a\\$", "a$", 0), "0-2");
+
+    char const* invalid[] = {
+        "a^", "a$b", "(a$)", "(ab", "ab)", "[ab", "a(", "*a", "a|*",
+        "\\", "\\q", "\\x4", "[b-a]", "a{3,2}", "a{1001}",
+        /* anchors next to a | outside of any group */
+        "^a|b$", "^a|b", "a|b$", "^|a", "a|$",
+    };
+
+    for (size_t i = 0; i < sizeof invalid / sizeof *invalid; ++i) {
+        assert_null(str_regex_new(str_view_of(invalid[i])));
+    }
+}
+
+static void str_regex_match_test(void** state) {
+    (void) state;
+
+    str_regex* re = str_regex_new(str_view_of("[a-z]+@[a-z]+\\.(?:com|org)"));
+
+    assert_non_null(re);
+    assert_true(str_regex_match(re, str_view_of("joe@example.com")));
+    assert_true(str_regex_match(re, str_view_of("ann@site.org")));
+    assert_false(str_regex_match(re, str_view_of("joe@example.net")));
+    assert_false(str_regex_match(re, str_view_of(" joe@example.com")));
+    assert_false(str_regex_match(re, str_view_of("joe@example.comx")));
+    assert_false(str_regex_match(re, str_view_of("")));
+
+    str_regex_del(re);
+
+    re = str_regex_new(str_view_of("a|ab"));
+
+    /* unlike find, which stops at the first alternative */
+    assert_true(str_regex_match(re, str_view_of("ab")));
+
+    str_regex_del(re);
+
+    re = str_regex_new(str_view_of(""));
+
+    assert_true(str_regex_match(re, str_view_of("")));
+    assert_false(str_regex_match(re, str_view_of("a")));
+    assert_int_equal(str_regex_groups(re), 1);
+
+    str_regex_del(re);
+    str_regex_del((void*) 0);
+}
+
+static void str_regex_captures_test(void** state) {
+    (void) state;
+
+    str_regex* re = str_regex_new(str_view_of(
+                "(\\w+)=(?:(\\d+)|(\\w+))(;)?"));
+    str_regex_span g[6];
+
+    assert_non_null(re);
+    assert_int_equal(str_regex_groups(re), 5);
+
+    str_view s = str_view_of("  key=value;x=42");
+
+    assert_true(str_regex_captures(re, s, 0, g, 6));
+    assert_int_equal(g[0].begin, 2);
+    assert_int_equal(g[0].end, 12);
+    assert_int_equal(g[1].begin, 2);
+    assert_int_equal(g[1].end, 5);
+    assert_int_equal(g[2].begin, STR_NPOS);
+    assert_int_equal(g[2].end, STR_NPOS);
+    assert_int_equal(g[3].begin, 6);
+    assert_int_equal(g[3].end, 11);
+    assert_int_equal(g[4].begin, 11);
+    assert_int_equal(g[4].end, 12);
+    /* past the groups of the pattern */
+    assert_int_equal(g[5].begin, STR_NPOS);
+
+    assert_true(str_regex_captures(re, s, g[0].end, g, 5));
+    assert_int_equal(g[0].begin, 12);
+    assert_int_equal(g[0].end, 16);
+    assert_int_equal(g[2].begin, 14);
+    assert_int_equal(g[2].end, 16);
+    assert_int_equal(g[3].begin, STR_NPOS);
+    assert_int_equal(g[4].begin, STR_NPOS);
+
+    assert_false(str_regex_captures(re, s, 16, g, 5));
+
+    str_regex_del(re);
+
+    /* the last iteration of a repeated group is kept */
+    re = str_regex_new(str_view_of("(?:(a)|(b))+$"));
+
+    assert_true(str_regex_captures(re, str_view_of("xab"), 0, g, 3));
+    assert_int_equal(g[0].begin, 1);
+    assert_int_equal(g[1].begin, 1);
+    assert_int_equal(g[2].begin, 2);
+
+    str_regex_del(re);
+
+    re = str_regex_new(str_view_of("(a*)(a*)"));
+
+    assert_true(str_regex_captures(re, str_view_of("aaa"), 0, g, 3));
+    assert_int_equal(g[1].end, 3);
+    assert_int_equal(g[2].begin, 3);
+    assert_int_equal(g[2].end, 3);
+
+    str_regex_del(re);
+
+    /* unlike Perl, an iteration matching nothing doesn't set its groups */
+    re = str_regex_new(str_view_of("(a*)*"));
+
+    assert_true(str_regex_captures(re, str_view_of("b"), 0, g, 2));
+    assert_int_equal(g[0].begin, 0);
+    assert_int_equal(g[0].end, 0);
+    assert_int_equal(g[1].begin, STR_NPOS);
+    assert_int_equal(g[1].end, STR_NPOS);
+
+    assert_true(str_regex_captures(re, str_view_of("aab"), 0, g, 2));
+    assert_int_equal(g[1].begin, 0);
+    assert_int_equal(g[1].end, 2);
+
+    str_regex_del(re);
+}
+
+static void str_regex_iterate_test(void** state) {
+    (void) state;
+
+    str_regex* re = str_regex_new(str_view_of("a*"));
+    str_view s = str_view_of("baac");
+    str_regex_span span;
+    size_t from = 0;
+    str* out = str_new();
+
+    /* empty matches step over a byte */
+    while (str_regex_find(re, s, from, &span)) {
+        char buf[32];
+
+        snprintf(buf, sizeof buf, "%zu-%zu ", span.begin, span.end);
+        str_append_view(out, str_view_of(buf));
+        from = span.end + (span.begin == span.end);
+    }
+
+    assert_string_equal(str_cstr(out), "0-0 1-3 3-3 4-4 ");
+
+    str_del(out);
+    str_regex_del(re);
+}
+
+static void str_regex_large_test(void** state) {
+    (void) state;
+
+    size_t n = 1 << 20;
+    char* data = malloc(n);
+
+    memset(data, 'a', n);
+
+    str_view s = { data, n };
+
+    /* exponential for a backtracking matcher */
+    str_regex* re = str_regex_new(str_view_of("(a*)*b"));
+
+    assert_non_null(re);
+    assert_false(str_regex_find(re, s, 0, (void*) 0));
+
+    str_regex_del(re);
+
+    /* the literal prefix skips through the subject */
+    memcpy(data + n - 9, "needle=42", 9);
+    re = str_regex_new(str_view_of("needle=(\\d+)"));
+
+    str_regex_span g[2];
+
+    assert_true(str_regex_captures(re, s, 0, g, 2));
+    assert_int_equal(g[0].begin, n - 9);
+    assert_int_equal(g[1].begin, n - 2);
+    assert_int_equal(g[1].end, n);
+
+    str_regex_del(re);
+
+    /* enough states to flush the cache */
+    re = str_regex_new(str_view_of("[ab]*a[ab]{12}c"));
+
+    for (size_t i = 0; i < n; ++i) {
+        data[i] = "ab"[(i * 7 + i / 3) % 5 % 2];
+    }
+
+    data[n - 1] = 'c';
+    data[n - 14] = 'a';
+
+    assert_true(str_regex_find(re, s, 0, g));
+    assert_int_equal(g[0].begin, 0);
+    assert_int_equal(g[0].end, n);
+
+    data[n - 14] = 'b';
+
+    assert_false(str_regex_find(re, s, 0, g));
+
+    str_regex_del(re);
+    free(data);
+}
+
+
+int main(void) {
+    struct CMUnitTest const tests[] = {
+        cmocka_unit_test(str_regex_find_test),
+        cmocka_unit_test(str_regex_leftmost_first_test),
+        cmocka_unit_test(str_regex_anchor_test),
+        cmocka_unit_test(str_regex_match_test),
+        cmocka_unit_test(str_regex_captures_test),
+        cmocka_unit_test(str_regex_iterate_test),
+        cmocka_unit_test(str_regex_large_test),
+    };
+
+
+    return cmocka_run_group_tests(tests, (void*) 0, (void*) 0);
+}
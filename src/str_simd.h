@@ -0,0 +1,37 @@
+/* str's private SIMD helpers
+ *
+ * Kernels are compiled for their instruction set with the target
+ * attribute and picked at run time, so the library itself builds for
+ * the baseline of the platform. Elsewhere only the scalar code is
+ * built. */
+#ifndef STR_SIMD_H
+#define STR_SIMD_H
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define STR_SIMD_X86 1
+#include <immintrin.h>
+#define STR_SIMD_TARGET(isa) __attribute__((target(isa)))
+#endif /* __x86_64__ */
+
+enum str_simd {
+    STR_SIMD_SCALAR,
+    STR_SIMD_SSSE3,
+    STR_SIMD_AVX2,
+};
+
+/* returns the widest instruction set the cpu runs */
+static inline enum str_simd str_simd_detect(void) {
+#ifdef STR_SIMD_X86
+    if (__builtin_cpu_supports("avx2")) {
+        return STR_SIMD_AVX2;
+    }
+
+    if (__builtin_cpu_supports("ssse3")) {
+        return STR_SIMD_SSSE3;
+    }
+#endif /* STR_SIMD_X86 */
+
+    return STR_SIMD_SCALAR;
+}
+
+#endif /* STR_SIMD_H */
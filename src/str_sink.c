@@ -0,0 +1,263 @@
+#define _XOPEN_SOURCE 700
+
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/uio.h>
+
+#include "str_sink.h"
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+static const size_t STR_SINK_FLUSH_BYTES = 1 << 16;
+static const size_t STR_SINK_FLUSH_IOVECS = 256;
+static const size_t STR_SINK_COPY_BELOW = 64;
+static const size_t STR_SINK_BUFFER_SIZE = 1 << 12;
+
+struct str_sink {
+    int fd;
+    str_sink_config config;
+    str_sink_stats stats;
+
+    struct iovec* iov;
+    size_t iov_used;
+    size_t pending;
+
+    /* staging buffer for copied pieces, it never moves
+     * so the iovecs can point straight into it */
+    char* buffer;
+    size_t buffer_used;
+};
+
+/* -- Private Interface -- */
+
+static bool write_all(struct str_sink* self) {
+    assert(self != (void*) 0);
+
+    struct iovec* iov = self->iov;
+    size_t count = self->iov_used;
+
+    self->stats.last_syscalls = 0;
+
+    while (count) {
+        int batch = count > IOV_MAX ? IOV_MAX : (int) count;
+        ssize_t written = writev(self->fd, iov, batch);
+
+        self->stats.syscalls++;
+        self->stats.last_syscalls++;
+
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return false;
+        }
+
+        self->stats.bytes += (size_t) written;
+
+        /* skips the fully written iovecs and
+         * advances into the partially written one */
+        size_t left = (size_t) written;
+
+        while (count && left >= iov->iov_len) {
+            left -= iov->iov_len;
+            iov++;
+            count--;
+        }
+
+        if (count) {
+            iov->iov_base = (char*) iov->iov_base + left;
+            iov->iov_len -= left;
+        }
+    }
+
+    return true;
+}
+
+static bool push(struct str_sink* self, char const* data, size_t len) {
+    assert(self != (void*) 0);
+    assert(self->iov_used < self->config.flush_iovecs);
+
+    self->iov[self->iov_used].iov_base = (char*) data;
+    self->iov[self->iov_used].iov_len = len;
+    self->iov_used++;
+    self->pending += len;
+
+    if (self->iov_used >= self->config.flush_iovecs
+            || self->pending >= self->config.flush_bytes) {
+        return str_sink_flush(self);
+    }
+
+    return true;
+}
+
+static bool copy(struct str_sink* self, char const* data, size_t len) {
+    assert(self != (void*) 0);
+    assert(len <= self->config.buffer_size);
+
+    if (self->buffer_used + len > self->config.buffer_size) {
+        if (!str_sink_flush(self)) {
+            return false;
+        }
+    }
+
+    char* dest = self->buffer + self->buffer_used;
+
+    memcpy(dest, data, len);
+    self->buffer_used += len;
+    self->stats.copied++;
+
+    /* coalesces with the previous piece if it was also copied */
+    if (self->iov_used) {
+        struct iovec* last = &self->iov[self->iov_used - 1];
+
+        if ((char*) last->iov_base + last->iov_len == dest) {
+            last->iov_len += len;
+            self->pending += len;
+
+            if (self->pending >= self->config.flush_bytes) {
+                return str_sink_flush(self);
+            }
+
+            return true;
+        }
+    }
+
+    return push(self, dest, len);
+}
+
+/* -- Public Interface Implementation -- */
+
+struct str_sink* str_sink_new(int fd, str_sink_config const* config) {
+    struct str_sink* sink = malloc(sizeof (struct str_sink));
+
+    if (!sink) {
+        return (void*) 0;
+    }
+
+    sink->fd = fd;
+    sink->config = config ? *config : (str_sink_config) { 0, 0, 0, 0 };
+    sink->stats = (str_sink_stats) { 0, 0, 0, 0, 0, 0 };
+
+    if (!sink->config.flush_bytes) {
+        sink->config.flush_bytes = STR_SINK_FLUSH_BYTES;
+    }
+
+    if (!sink->config.flush_iovecs) {
+        sink->config.flush_iovecs = STR_SINK_FLUSH_IOVECS;
+    }
+
+    if (sink->config.flush_iovecs > IOV_MAX) {
+        sink->config.flush_iovecs = IOV_MAX;
+    }
+
+    if (!sink->config.copy_below) {
+        sink->config.copy_below = STR_SINK_COPY_BELOW;
+    }
+
+    if (!sink->config.buffer_size) {
+        sink->config.buffer_size = STR_SINK_BUFFER_SIZE;
+    }
+
+    if (sink->config.copy_below > sink->config.buffer_size) {
+        sink->config.copy_below = sink->config.buffer_size;
+    }
+
+    sink->iov_used = 0;
+    sink->pending = 0;
+    sink->buffer_used = 0;
+
+    sink->iov = malloc(sink->config.flush_iovecs * sizeof (struct iovec));
+    sink->buffer = malloc(sink->config.buffer_size);
+
+    if (!sink->iov || !sink->buffer) {
+        free(sink->iov);
+        free(sink->buffer);
+        free(sink);
+        return (void*) 0;
+    }
+
+    return sink;
+}
+
+bool str_sink_close(struct str_sink* self) {
+    if (!self) {
+        return false;
+    }
+
+    bool flushed = str_sink_flush(self);
+
+    free(self->iov);
+    free(self->buffer);
+    free(self);
+
+    return flushed;
+}
+
+bool str_sink_flush(struct str_sink* self) {
+    if (!self) {
+        return false;
+    }
+
+    if (!self->iov_used) {
+        return true;
+    }
+
+    bool written = write_all(self);
+
+    self->stats.flushes++;
+
+    self->iov_used = 0;
+    self->pending = 0;
+    self->buffer_used = 0;
+
+    return written;
+}
+
+bool str_sink_write_view(struct str_sink* self, str_view v) {
+    if (!self) {
+        return false;
+    }
+
+    if (!v.len) {
+        return true;
+    }
+
+    if (v.len < self->config.copy_below) {
+        return copy(self, v.data, v.len);
+    }
+
+    self->stats.referenced++;
+
+    return push(self, v.data, v.len);
+}
+
+bool str_sink_write_str(struct str_sink* self, str* s) {
+    if (!self || !s) {
+        return false;
+    }
+
+    return str_sink_write_view(self, str_view_from_str(s));
+}
+
+bool str_sink_write_cstr(struct str_sink* self, char const* s) {
+    if (!self || !s) {
+        return false;
+    }
+
+    return str_sink_write_view(self, str_view_from_cstr(s));
+}
+
+str_sink_stats str_sink_stats_get(struct str_sink* self) {
+    if (!self) {
+        return (str_sink_stats) { 0, 0, 0, 0, 0, 0 };
+    }
+
+    return self->stats;
+}
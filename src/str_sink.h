@@ -0,0 +1,157 @@
+/** str's Buffered Output Sink
+ * @file str_sink.h */
+#ifndef STR_SINK_H
+#define STR_SINK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "str.h"
+
+/** Opaque str_sink Structure */
+typedef struct str_sink str_sink;
+
+/** Flush thresholds of a str_sink.
+ * @note       A zero field selects its default value.
+ *
+ * @see str_sink_new */
+typedef struct str_sink_config {
+    /** Flushes automatically once this many bytes are pending. */
+    size_t flush_bytes;
+    /** Flushes automatically once this many pieces are pending,
+     *  it is capped at IOV_MAX. */
+    size_t flush_iovecs;
+    /** Pieces shorter than this are copied instead of referenced. */
+    size_t copy_below;
+    /** Capacity of the buffer holding the copied pieces. */
+    size_t buffer_size;
+} str_sink_config;
+
+/** Counters of a str_sink.
+ *
+ * @see str_sink_stats_get */
+typedef struct str_sink_stats {
+    /** Number of flushed batches. */
+    size_t flushes;
+    /** Number of writev calls over all batches. */
+    size_t syscalls;
+    /** Number of writev calls of the last flushed batch. */
+    size_t last_syscalls;
+    /** Number of bytes written. */
+    size_t bytes;
+    /** Number of pieces written by reference. */
+    size_t referenced;
+    /** Number of pieces written by copy. */
+    size_t copied;
+} str_sink_stats;
+
+/** Creates sink writing to a file descriptor.
+ * @warning    The user has to free the object after usage with
+ *             str_sink_close.
+ *
+ * @note       If config is null, the default thresholds are used.
+ *
+ * @note       The sink never closes fd.
+ *
+ * @param fd     A file descriptor open for writing.
+ * @param config A pointer to the flush thresholds.
+ *
+ * @return       A pointer to a str_sink object.
+ *
+ * @see str_sink_close */
+str_sink* str_sink_new(int fd, str_sink_config const* config);
+
+/** Flushes and deletes the sink.
+ * @note       The sink is deleted even if the flush fails.
+ *
+ * @param self A pointer to a str_sink object.
+ *
+ * @return     true if the pending data was written.
+ *
+ * @see str_sink_flush */
+bool str_sink_close(str_sink* self);
+
+/** Writes all pending pieces with as few writev calls as possible.
+ * @note       On failure, the pending pieces are discarded.
+ *
+ * @param self A pointer to a str_sink object.
+ *
+ * @return     true if successful.
+ *
+ * @see str_sink_close */
+bool str_sink_flush(str_sink* self);
+
+/** Queues a view to be written.
+ * @warning    Unless it is shorter than the copy threshold, the
+ *             view is written by reference, so its data must stay
+ *             alive and unmodified until the next flush.
+ *
+ * @param self A pointer to a str_sink object.
+ * @param v    A view.
+ *
+ * @return     true if successful.
+ *
+ * @see str_sink_write str_sink_write_str str_sink_write_cstr */
+bool str_sink_write_view(str_sink* self, str_view v);
+
+/** Queues a str object to be written.
+ * @warning    Unless it is shorter than the copy threshold, the
+ *             str object is written by reference, so it must not be
+ *             modified nor deleted until the next flush.
+ *
+ * @note       If the str s is null, it doesn't write anything.
+ *
+ * @param self A pointer to a str_sink object.
+ * @param s    A pointer to a str object.
+ *
+ * @return     true if successful.
+ *
+ * @see str_sink_write str_sink_write_view str_sink_write_cstr */
+bool str_sink_write_str(str_sink* self, str* s);
+
+/** Queues a null terminated C string to be written.
+ * @warning    Unless it is shorter than the copy threshold, the
+ *             C string is written by reference, so it must stay
+ *             alive and unmodified until the next flush.
+ *
+ * @note       If the C string s is null, it doesn't write anything.
+ *
+ * @param self A pointer to a str_sink object.
+ * @param s    A pointer to a C string.
+ *
+ * @return     true if successful.
+ *
+ * @see str_sink_write str_sink_write_view str_sink_write_str */
+bool str_sink_write_cstr(str_sink* self, char const* s);
+
+/** Generic for str_sink_write_*.
+ *
+ * @param self A pointer to a str_sink object.
+ * @param T    Generic Object.
+ *
+ * @return     true if successful.
+ *
+ * @see str_sink_write_view str_sink_write_str str_sink_write_cstr */
+#define str_sink_write(self, T) _Generic((T), \
+        char*:       str_sink_write_cstr,     \
+        char const*: str_sink_write_cstr,     \
+        str*:        str_sink_write_str,      \
+        str_view:    str_sink_write_view      \
+        )(self, T)
+
+/** Returns the sink counters.
+ *
+ * @param self A pointer to a str_sink object.
+ *
+ * @return     A copy of the counters. */
+str_sink_stats str_sink_stats_get(str_sink* self);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* STR_SINK_H */
@@ -0,0 +1,193 @@
+#include <assert.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <unistd.h>
+
+#include <cmocka.h>
+
+#include "str.h"
+#include "str_sink.h"
+
+static size_t drain(int fd, char* buffer, size_t size) {
+    size_t used = 0;
+    ssize_t got;
+
+    while (used < size && (got = read(fd, buffer + used, size - used)) > 0) {
+        used += (size_t) got;
+    }
+
+    return used;
+}
+
+static void str_sink_new_close_test(void** state) {
+    (void) state;
+
+    str_sink* sink = str_sink_new(1, (void*) 0);
+
+    assert_non_null(sink);
+    assert_true(str_sink_close(sink));
+}
+
+static void str_sink_write_mixed_test(void** state) {
+    (void) state;
+
+    int fds[2];
+    assert_int_equal(pipe(fds), 0);
+
+    str* s = str_from("a fairly long string that is written by reference");
+    str_view v = { "view!", 5 };
+
+    str_sink* sink = str_sink_new(fds[1], (void*) 0);
+
+    str_sink_write(sink, s);
+    str_sink_write(sink, "|");
+    str_sink_write(sink, v);
+    str_sink_write(sink, (char const*) "|");
+
+    assert_true(str_sink_close(sink));
+    close(fds[1]);
+
+    char buffer[128];
+    size_t len = drain(fds[0], buffer, sizeof buffer);
+    close(fds[0]);
+
+    char const* expected =
+        "a fairly long string that is written by reference|view!|";
+
+    assert_int_equal(len, strlen(expected));
+    assert_memory_equal(buffer, expected, len);
+
+    str_del(s);
+}
+
+static void str_sink_batch_single_syscall_test(void** state) {
+    (void) state;
+
+    int fds[2];
+    assert_int_equal(pipe(fds), 0);
+
+    str* words[64];
+
+    for (int i = 0; i < 64; ++i) {
+        words[i] = str_from("0123456789abcdefghijklmnopqrstuvwxyz");
+    }
+
+    str_sink_config config = { 1 << 16, 1024, 8, 0 };
+    str_sink* sink = str_sink_new(fds[1], &config);
+
+    for (int i = 0; i < 64; ++i) {
+        str_sink_write(sink, words[i]);
+        str_sink_write(sink, "\n");
+    }
+
+    assert_true(str_sink_flush(sink));
+
+    str_sink_stats stats = str_sink_stats_get(sink);
+
+    assert_int_equal(stats.flushes, 1);
+    assert_int_equal(stats.last_syscalls, 1);
+    assert_int_equal(stats.bytes, 64 * 37);
+    assert_int_equal(stats.referenced, 64);
+    assert_int_equal(stats.copied, 64);
+
+    assert_true(str_sink_close(sink));
+    close(fds[1]);
+
+    char buffer[64 * 37];
+    assert_int_equal(drain(fds[0], buffer, sizeof buffer), sizeof buffer);
+    close(fds[0]);
+
+    for (int i = 0; i < 64; ++i) {
+        assert_memory_equal(buffer + i * 37,
+                "0123456789abcdefghijklmnopqrstuvwxyz\n", 37);
+        str_del(words[i]);
+    }
+}
+
+static void str_sink_coalesce_test(void** state) {
+    (void) state;
+
+    int fds[2];
+    assert_int_equal(pipe(fds), 0);
+
+    str_sink* sink = str_sink_new(fds[1], (void*) 0);
+
+    for (int i = 0; i < 100; ++i) {
+        str_sink_write(sink, "ab");
+    }
+
+    assert_true(str_sink_flush(sink));
+
+    str_sink_stats stats = str_sink_stats_get(sink);
+
+    assert_int_equal(stats.copied, 100);
+    assert_int_equal(stats.referenced, 0);
+    assert_int_equal(stats.bytes, 200);
+
+    assert_true(str_sink_close(sink));
+    close(fds[1]);
+
+    char buffer[200];
+    assert_int_equal(drain(fds[0], buffer, sizeof buffer), sizeof buffer);
+    close(fds[0]);
+
+    for (int i = 0; i < 100; ++i) {
+        assert_memory_equal(buffer + i * 2, "ab", 2);
+    }
+}
+
+static void str_sink_auto_flush_test(void** state) {
+    (void) state;
+
+    int fds[2];
+    assert_int_equal(pipe(fds), 0);
+
+    str_sink_config config = { 0, 4, 1, 0 };
+    str_sink* sink = str_sink_new(fds[1], &config);
+
+    for (int i = 0; i < 10; ++i) {
+        str_sink_write(sink, "xyz");
+    }
+
+    /* every 4 referenced pieces trigger a flush */
+    assert_int_equal(str_sink_stats_get(sink).flushes, 2);
+
+    assert_true(str_sink_close(sink));
+    close(fds[1]);
+
+    char buffer[30];
+    assert_int_equal(drain(fds[0], buffer, sizeof buffer), sizeof buffer);
+    close(fds[0]);
+}
+
+static void str_sink_write_error_test(void** state) {
+    (void) state;
+
+    int fds[2];
+    assert_int_equal(pipe(fds), 0);
+    close(fds[1]);
+
+    str_sink* sink = str_sink_new(fds[0], (void*) 0);
+
+    str_sink_write(sink, "never written");
+
+    assert_false(str_sink_close(sink));
+    close(fds[0]);
+}
+
+int main(void) {
+    struct CMUnitTest const tests[] = {
+        cmocka_unit_test(str_sink_new_close_test),
+        cmocka_unit_test(str_sink_write_mixed_test),
+        cmocka_unit_test(str_sink_batch_single_syscall_test),
+        cmocka_unit_test(str_sink_coalesce_test),
+        cmocka_unit_test(str_sink_auto_flush_test),
+        cmocka_unit_test(str_sink_write_error_test),
+    };
+
+
+    return cmocka_run_group_tests(tests, (void*) 0, (void*) 0);
+}
@@ -0,0 +1,322 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "str_sort.h"
+
+/* below this, insertion sort beats partitioning */
+static const size_t STR_SORT_INSERTION = 16;
+
+/* a tag of KEY_MORE means the string goes on past the key */
+#define KEY_BYTES 8
+#define KEY_MORE (KEY_BYTES + 1)
+
+struct entry {
+    /* next KEY_BYTES bytes at the current depth, big endian
+     * so comparing keys compares bytes */
+    uint64_t key;
+    /* bytes left at the current depth, capped to KEY_MORE */
+    size_t tag;
+    str_view v;
+    str* s;
+};
+
+/* -- Private Interface -- */
+
+static void load(struct entry* e, size_t depth) {
+    assert(e != (void*) 0);
+
+    size_t left = e->v.len > depth ? e->v.len - depth : 0;
+    size_t take = left < KEY_BYTES ? left : KEY_BYTES;
+    unsigned char const* p = (unsigned char const*) e->v.data + depth;
+
+    uint64_t key = 0;
+
+    for (size_t i = 0; i < take; ++i) {
+        key |= (uint64_t) p[i] << (8 * (KEY_BYTES - 1 - i));
+    }
+
+    e->key = key;
+    e->tag = left > KEY_BYTES ? KEY_MORE : left;
+}
+
+static int cmp_key(struct entry const* a, struct entry const* b) {
+    if (a->key != b->key) {
+        return a->key < b->key ? -1 : 1;
+    }
+
+    if (a->tag != b->tag) {
+        return a->tag < b->tag ? -1 : 1;
+    }
+
+    return 0;
+}
+
+/* compares entries whose keys were loaded at depth */
+static int cmp_full(struct entry const* a, struct entry const* b,
+        size_t depth) {
+    int c = cmp_key(a, b);
+
+    if (c || a->tag != KEY_MORE) {
+        return c;
+    }
+
+    depth += KEY_BYTES;
+
+    size_t la = a->v.len - depth;
+    size_t lb = b->v.len - depth;
+
+    c = memcmp(a->v.data + depth, b->v.data + depth, la < lb ? la : lb);
+
+    if (c) {
+        return c;
+    }
+
+    return la < lb ? -1 : la > lb;
+}
+
+static void swap(struct entry* a, struct entry* b) {
+    struct entry t = *a;
+    *a = *b;
+    *b = t;
+}
+
+static void insertion(struct entry* e, size_t n, size_t depth) {
+    for (size_t i = 1; i < n; ++i) {
+        struct entry t = e[i];
+        size_t j = i;
+
+        for (; j && cmp_full(&t, &e[j - 1], depth) < 0; --j) {
+            e[j] = e[j - 1];
+        }
+
+        e[j] = t;
+    }
+}
+
+static struct entry* median(struct entry* a, struct entry* b,
+        struct entry* c) {
+    if (cmp_key(a, b) < 0) {
+        if (cmp_key(b, c) < 0) return b;
+        return cmp_key(a, c) < 0 ? c : a;
+    }
+
+    if (cmp_key(a, c) < 0) return a;
+    return cmp_key(b, c) < 0 ? c : b;
+}
+
+/* moves e[i] down the max heap e[0, n) */
+static void sift(struct entry* e, size_t i, size_t n, size_t depth) {
+    for (size_t child; (child = 2 * i + 1) < n; i = child) {
+        if (child + 1 < n && cmp_full(&e[child], &e[child + 1], depth) < 0) {
+            child++;
+        }
+
+        if (cmp_full(&e[i], &e[child], depth) >= 0) {
+            return;
+        }
+
+        swap(&e[i], &e[child]);
+    }
+}
+
+/* sorts ranges partitioning does badly on in O(n log n) */
+static void heap(struct entry* e, size_t n, size_t depth) {
+    for (size_t i = n / 2; i-- > 0;) {
+        sift(e, i, n, depth);
+    }
+
+    for (size_t i = n; i-- > 1;) {
+        swap(&e[0], &e[i]);
+        sift(e, 0, i, depth);
+    }
+}
+
+/* partitions allowed at a key depth before falling back to heap,
+ * 2 log2(n) as in introsort */
+static size_t budget(size_t n) {
+    size_t limit = 0;
+
+    for (; n > 1; n /= 2) {
+        limit += 2;
+    }
+
+    return limit;
+}
+
+struct part {
+    struct entry* e;
+    size_t n;
+    size_t depth;
+    size_t limit;
+};
+
+static void multikey(struct entry* e, size_t n, size_t depth, size_t limit) {
+    while (n >= STR_SORT_INSERTION) {
+        if (!limit--) {
+            heap(e, n, depth);
+            return;
+        }
+
+        swap(&e[0], median(&e[0], &e[n / 2], &e[n - 1]));
+
+        struct entry pivot = e[0];
+
+        /* three-way partition into [0, lt) < pivot, [lt, gt) == pivot
+         * and [gt, n) > pivot */
+        size_t lt = 0;
+        size_t gt = n;
+
+        for (size_t i = 1; i < gt;) {
+            int c = cmp_key(&e[i], &pivot);
+
+            if (c < 0) {
+                swap(&e[lt++], &e[i++]);
+            } else if (c > 0) {
+                swap(&e[i], &e[--gt]);
+            } else {
+                i++;
+            }
+        }
+
+        /* the equal ones only differ past the key, if at all */
+        size_t eq = pivot.tag == KEY_MORE ? gt - lt : 0;
+
+        for (size_t i = lt; i < lt + eq; ++i) {
+            load(&e[i], depth + KEY_BYTES);
+        }
+
+        struct part parts[] = {
+            { e, lt, depth, limit },
+            { e + gt, n - gt, depth, limit },
+            { e + lt, eq, depth + KEY_BYTES, budget(eq) },
+        };
+
+        /* the two smaller parts hold at most n / 2 entries each, so
+         * recursing into them and looping on the largest keeps the
+         * stack O(log n) */
+        size_t largest = 0;
+
+        for (size_t i = 1; i < 3; ++i) {
+            if (parts[i].n > parts[largest].n) {
+                largest = i;
+            }
+        }
+
+        for (size_t i = 0; i < 3; ++i) {
+            if (i != largest) {
+                multikey(parts[i].e, parts[i].n, parts[i].depth,
+                        parts[i].limit);
+            }
+        }
+
+        e = parts[largest].e;
+        n = parts[largest].n;
+        depth = parts[largest].depth;
+        limit = parts[largest].limit;
+    }
+
+    insertion(e, n, depth);
+}
+
+static void merge(struct entry* e, struct entry* tmp, size_t n) {
+    for (size_t width = 1; width < n; width *= 2) {
+        for (size_t lo = 0; lo < n; lo += 2 * width) {
+            size_t mid = lo + width < n ? lo + width : n;
+            size_t hi = lo + 2 * width < n ? lo + 2 * width : n;
+
+            size_t i = lo;
+            size_t j = mid;
+            size_t k = lo;
+
+            /* takes from the left run on ties to stay stable */
+            while (i < mid && j < hi) {
+                tmp[k++] = cmp_full(&e[j], &e[i], 0) < 0 ? e[j++] : e[i++];
+            }
+
+            while (i < mid) tmp[k++] = e[i++];
+            while (j < hi) tmp[k++] = e[j++];
+        }
+
+        memcpy(e, tmp, n * sizeof (struct entry));
+    }
+}
+
+static struct entry* entries(str** arr, size_t n, size_t extra) {
+    assert(arr != (void*) 0);
+
+    /* overflow */
+    if (n > SIZE_MAX / sizeof (struct entry) / extra) {
+        return (void*) 0;
+    }
+
+    struct entry* e = malloc(n * extra * sizeof (struct entry));
+
+    if (!e) {
+        return (void*) 0;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        e[i].s = arr[i];
+        e[i].v = str_view_from_str(arr[i]);
+        load(&e[i], 0);
+    }
+
+    return e;
+}
+
+/* -- Public Interface Implementation -- */
+
+bool str_sort(str** arr, size_t n) {
+    if (!arr) {
+        return false;
+    }
+
+    if (n < 2) {
+        return true;
+    }
+
+    struct entry* e = entries(arr, n, 1);
+
+    if (!e) {
+        return false;
+    }
+
+    multikey(e, n, 0, budget(n));
+
+    for (size_t i = 0; i < n; ++i) {
+        arr[i] = e[i].s;
+    }
+
+    free(e);
+
+    return true;
+}
+
+bool str_sort_stable(str** arr, size_t n) {
+    if (!arr) {
+        return false;
+    }
+
+    if (n < 2) {
+        return true;
+    }
+
+    /* the second half is the merge buffer */
+    struct entry* e = entries(arr, n, 2);
+
+    if (!e) {
+        return false;
+    }
+
+    merge(e, e + n, n);
+
+    for (size_t i = 0; i < n; ++i) {
+        arr[i] = e[i].s;
+    }
+
+    free(e);
+
+    return true;
+}
@@ -0,0 +1,55 @@
+/** str's Sorting
+ * @file str_sort.h */
+#ifndef STR_SORT_H
+#define STR_SORT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "str.h"
+
+/** Sorts array of str objects.
+ * @note       Strings are ordered byte-wise as unsigned characters,
+ *             and a string sorts before every longer string it
+ *             prefixes, so embedded null characters are compared
+ *             like any other character.
+ *
+ * @note       Null str objects sort as empty strings.
+ *
+ * @note       It uses multikey quicksort over the next 8 bytes of
+ *             every string cached next to its pointer, which is
+ *             not stable.
+ *
+ * @param arr  A pointer to an array of str objects.
+ * @param n    Number of str objects.
+ *
+ * @return     true if successful, the array is left untouched
+ *             otherwise.
+ *
+ * @see str_sort_stable */
+bool str_sort(str** arr, size_t n);
+
+/** Sorts array of str objects preserving the order of equal strings.
+ * @note       The order is the same as str_sort.
+ *
+ * @note       It uses merge sort comparing the first 8 bytes of
+ *             every string cached next to its pointer.
+ *
+ * @param arr  A pointer to an array of str objects.
+ * @param n    Number of str objects.
+ *
+ * @return     true if successful, the array is left untouched
+ *             otherwise.
+ *
+ * @see str_sort */
+bool str_sort_stable(str** arr, size_t n);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* STR_SORT_H */
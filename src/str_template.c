@@ -0,0 +1,225 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "str_template.h"
+
+/* slot of the last segment, which no placeholder follows */
+#define NONE SIZE_MAX
+
+/* literal text in text, followed by a placeholder */
+struct segment {
+    size_t start;
+    size_t len;
+    size_t slot;
+};
+
+/* name of a slot in text */
+struct name {
+    size_t start;
+    size_t len;
+};
+
+struct str_template {
+    /* literal text of the segments, unescaped, and the names */
+    str* text;
+    size_t literal_len;
+
+    struct segment* segments;
+    size_t segments_len;
+
+    struct name* names;
+    size_t slots;
+};
+
+/* -- Private Interface -- */
+
+static size_t lookup(str_template const* self, str_view name) {
+    /* str_cstr would write the \0 into a template threads may share */
+    char const* text = str_view_from_str(self->text).data;
+
+    for (size_t i = 0; i < self->slots; ++i) {
+        if (self->names[i].len == name.len
+                && !memcmp(text + self->names[i].start, name.data, name.len)) {
+            return i;
+        }
+    }
+
+    return STR_NPOS;
+}
+
+/* parses pattern into self, whose arrays hold a segment per { */
+static bool parse(str_template* self, str_view pattern) {
+    char const* p = pattern.data;
+    size_t n = pattern.len;
+    size_t start = 0;
+
+    for (size_t i = 0; i < n;) {
+        size_t run = i;
+
+        while (run < n && p[run] != '{' && p[run] != '}') {
+            run++;
+        }
+
+        if (!str_append_view(self->text, (str_view) { p + i, run - i })) {
+            return false;
+        }
+
+        i = run;
+
+        if (i == n) {
+            break;
+        }
+
+        /* escaped braces */
+        if (i + 1 < n && p[i + 1] == p[i]) {
+            if (!str_append_char(self->text, p[i])) {
+                return false;
+            }
+
+            i += 2;
+            continue;
+        }
+
+        if (p[i] == '}') {
+            return false;
+        }
+
+        char const* close = memchr(p + i + 1, '}', n - i - 1);
+
+        if (!close) {
+            return false;
+        }
+
+        str_view name = { p + i + 1, (size_t) (close - p) - i - 1 };
+
+        if (!name.len || memchr(name.data, '{', name.len)) {
+            return false;
+        }
+
+        size_t len = str_len(self->text) - start;
+        size_t slot = lookup(self, name);
+
+        if (slot == STR_NPOS) {
+            slot = self->slots++;
+            self->names[slot] = (struct name) { str_len(self->text), name.len };
+
+            if (!str_append_view(self->text, name)) {
+                return false;
+            }
+        }
+
+        self->segments[self->segments_len++] =
+            (struct segment) { start, len, slot };
+        self->literal_len += len;
+        start = str_len(self->text);
+        i = (size_t) (close - p) + 1;
+    }
+
+    size_t len = str_len(self->text) - start;
+
+    self->segments[self->segments_len++] =
+        (struct segment) { start, len, NONE };
+    self->literal_len += len;
+
+    return true;
+}
+
+/* -- Public Interface Implementation -- */
+
+str_template* str_template_compile(str_view pattern) {
+    if (!pattern.data && pattern.len) {
+        return (void*) 0;
+    }
+
+    size_t opens = 0;
+
+    for (size_t i = 0; i < pattern.len; ++i) {
+        opens += pattern.data[i] == '{';
+    }
+
+    str_template* self = calloc(1, sizeof (str_template));
+
+    if (!self) {
+        return (void*) 0;
+    }
+
+    self->text = str_new();
+    self->segments = malloc((opens + 1) * sizeof (struct segment));
+    self->names = malloc((opens ? opens : 1) * sizeof (struct name));
+
+    if (!self->text || !self->segments || !self->names
+            || !str_reserve(self->text, pattern.len)
+            || !parse(self, pattern)) {
+        str_template_del(self);
+        return (void*) 0;
+    }
+
+    return self;
+}
+
+void str_template_del(str_template* self) {
+    if (!self) {
+        return;
+    }
+
+    str_del(self->text);
+    free(self->segments);
+    free(self->names);
+    free(self);
+}
+
+size_t str_template_slots(str_template const* self) {
+    return self ? self->slots : 0;
+}
+
+size_t str_template_slot(str_template const* self, str_view name) {
+    if (!self || (!name.data && name.len)) {
+        return STR_NPOS;
+    }
+
+    return lookup(self, name);
+}
+
+bool str_template_render(str_template const* self, str_view const* values,
+        str* out) {
+    if (!self || !out || (!values && self->slots)) {
+        return false;
+    }
+
+    size_t total = self->literal_len;
+
+    for (size_t i = 0; i + 1 < self->segments_len; ++i) {
+        size_t len = values[self->segments[i].slot].len;
+
+        /* overflow */
+        if (total + len < total) {
+            return false;
+        }
+
+        total += len;
+    }
+
+    if (!str_truncate(out, 0) || !str_reserve(out, total)) {
+        return false;
+    }
+
+    /* str_cstr would write the \0 into a template threads may share */
+    char const* text = str_view_from_str(self->text).data;
+
+    for (size_t i = 0; i < self->segments_len; ++i) {
+        struct segment const* segment = &self->segments[i];
+
+        if (segment->len && !str_append_view(out,
+                    (str_view) { text + segment->start, segment->len })) {
+            return false;
+        }
+
+        if (segment->slot != NONE && values[segment->slot].len
+                && !str_append_view(out, values[segment->slot])) {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,83 @@
+/** str's Templates
+ * @file str_template.h
+ *
+ * Templates with named placeholders, as in "Hello {name}!", parsed once
+ * and rendered many times. Rendering measures the output first and
+ * copies the literal text and values into a reused str, so rendering
+ * into the same str again doesn't allocate once it is big enough. */
+#ifndef STR_TEMPLATE_H
+#define STR_TEMPLATE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "str.h"
+
+/** Opaque str_template Structure */
+typedef struct str_template str_template;
+
+/** Compiles template.
+ * @warning    The user has to free the object after usage with
+ *             str_template_del.
+ *
+ * @note       A placeholder is a name in braces, a name may appear
+ *             several times. Literal braces are written twice, {{ and
+ *             }}.
+ *
+ * @note       Every distinct name gets a slot, numbered from 0 in
+ *             order of first appearance.
+ *
+ * @param pattern A view over the template text.
+ *
+ * @return     A pointer to a str_template object, or null if a
+ *             placeholder is empty or not closed, or a } is unpaired.
+ *
+ * @see str_template_del str_template_render */
+str_template* str_template_compile(str_view pattern);
+
+/** Deletes template.
+ * @param self A pointer to a str_template object. */
+void str_template_del(str_template* self);
+
+/** Returns number of slots of template.
+ * @param self A pointer to a str_template object.
+ *
+ * @return     Number of distinct placeholder names. */
+size_t str_template_slots(str_template const* self);
+
+/** Returns slot of a placeholder name.
+ * @param self A pointer to a str_template object.
+ * @param name A view over the name, without braces.
+ *
+ * @return     Index of the slot, or STR_NPOS if no placeholder has the
+ *             name. */
+size_t str_template_slot(str_template const* self, str_view name);
+
+/** Renders template into str.
+ * @note       The contents of out are replaced, its capacity is kept.
+ *
+ * @note       The template is only read, so threads may render the
+ *             same one at once, each into its own out.
+ *
+ * @warning    The values must not point into out.
+ *
+ * @param self   A pointer to a str_template object.
+ * @param values An array of str_template_slots views, value i filling
+ *               the placeholders of slot i.
+ * @param out    A pointer to a str object.
+ *
+ * @return       true if successful.
+ *
+ * @see str_template_slot */
+bool str_template_render(str_template const* self, str_view const* values,
+        str* out);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* STR_TEMPLATE_H */
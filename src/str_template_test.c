@@ -0,0 +1,176 @@
+#include <assert.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cmocka.h>
+#include <pthread.h>
+
+#include "str.h"
+#include "str_template.h"
+
+static void str_template_render_test(void** state) {
+    (void) state;
+
+    str_template* t = str_template_compile(
+            str_view_of("Hello {name}, you have {count} new {what}, {name}!"));
+
+    assert_non_null(t);
+    assert_int_equal(str_template_slots(t), 3);
+    assert_int_equal(str_template_slot(t, str_view_of("name")), 0);
+    assert_int_equal(str_template_slot(t, str_view_of("count")), 1);
+    assert_int_equal(str_template_slot(t, str_view_of("what")), 2);
+    assert_int_equal(str_template_slot(t, str_view_of("nam")), STR_NPOS);
+
+    str_view values[] = {
+        str_view_of("Ada"), str_view_of("3"), str_view_of("messages"),
+    };
+    str* out = str_from("previous contents");
+
+    assert_true(str_template_render(t, values, out));
+    assert_string_equal(str_cstr(out),
+            "Hello Ada, you have 3 new messages, Ada!");
+
+    values[0] = str_view_of("");
+    assert_true(str_template_render(t, values, out));
+    assert_string_equal(str_cstr(out),
+            "Hello , you have 3 new messages, !");
+
+    str_del(out);
+    str_template_del(t);
+}
+
+static void str_template_syntax_test(void** state) {
+    (void) state;
+
+    struct {
+        char const* pattern;
+        char const* rendered;
+    } const cases[] = {
+        { "", "" },
+        { "no placeholders", "no placeholders" },
+        { "{x}", "X" },
+        { "{x}{x}{x}", "XXX" },
+        { "{{x}} {{{x}}}", "{x} {X}" },
+        { "a }} b {{", "a } b {" },
+        { "{ spaced name }", "X" },
+    };
+
+    for (size_t i = 0; i < sizeof cases / sizeof *cases; ++i) {
+        str_template* t = str_template_compile(str_view_of(cases[i].pattern));
+        str_view values[] = { str_view_of("X") };
+        str* out = str_new();
+
+        assert_non_null(t);
+        assert_true(str_template_render(t, values, out));
+        assert_string_equal(str_cstr(out), cases[i].rendered);
+
+        str_del(out);
+        str_template_del(t);
+    }
+
+    char const* invalid[] = {
+        "{", "{x", "}", "x}y", "{}", "{a{b}", "{x}}",
+    };
+
+    for (size_t i = 0; i < sizeof invalid / sizeof *invalid; ++i) {
+        assert_null(str_template_compile(str_view_of(invalid[i])));
+    }
+}
+
+static void str_template_reuse_test(void** state) {
+    (void) state;
+
+    str_template* t = str_template_compile(str_view_of("<{a}|{b}>"));
+    str* out = str_new();
+    str* big = str_new();
+
+    for (int i = 0; i < 1000; ++i) {
+        str_append_char(big, 'z');
+    }
+
+    str_view values[] = { str_view_of(big), str_view_of("b") };
+
+    assert_true(str_template_render(t, values, out));
+    assert_int_equal(str_len(out), 1004);
+
+    /* shorter renders fit in the capacity already there */
+    char const* data = str_cstr(out);
+
+    values[0] = str_view_of("a");
+
+    for (int i = 0; i < 10; ++i) {
+        assert_true(str_template_render(t, values, out));
+        assert_string_equal(str_cstr(out), "<a|b>");
+        assert_ptr_equal(str_cstr(out), data);
+    }
+
+    str_del(big);
+    str_del(out);
+    str_template_del(t);
+}
+
+struct renderer {
+    str_template const* t;
+    char const* name;
+    size_t failures;
+};
+
+static void* renderer(void* arg) {
+    struct renderer* r = arg;
+    str* out = str_new();
+    str* expected = str_from("Hello ");
+
+    str_append_cstr(expected, r->name);
+    str_append_char(expected, '!');
+
+    str_view values[] = { str_view_of(r->name) };
+
+    for (int i = 0; i < 10000; ++i) {
+        /* lookups read the template as well */
+        if (str_template_slot(r->t, str_view_of("name")) != 0
+                || !str_template_render(r->t, values, out)
+                || !str_equal(out, expected)) {
+            r->failures++;
+        }
+    }
+
+    str_del(expected);
+    str_del(out);
+
+    return (void*) 0;
+}
+
+static void str_template_threads_test(void** state) {
+    (void) state;
+
+    str_template* t = str_template_compile(str_view_of("Hello {name}!"));
+    struct renderer renderers[] = { { t, "Ada", 0 }, { t, "Grace", 0 } };
+    pthread_t threads[2];
+
+    for (int i = 0; i < 2; ++i) {
+        pthread_create(&threads[i], (void*) 0, renderer, &renderers[i]);
+    }
+
+    for (int i = 0; i < 2; ++i) {
+        pthread_join(threads[i], (void*) 0);
+        assert_int_equal(renderers[i].failures, 0);
+    }
+
+    str_template_del(t);
+}
+
+
+int main(void) {
+    struct CMUnitTest const tests[] = {
+        cmocka_unit_test(str_template_render_test),
+        cmocka_unit_test(str_template_syntax_test),
+        cmocka_unit_test(str_template_reuse_test),
+        cmocka_unit_test(str_template_threads_test),
+    };
+
+
+    return cmocka_run_group_tests(tests, (void*) 0, (void*) 0);
+}
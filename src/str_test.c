@@ -1,3 +1,7 @@
+#ifdef STR_STATS
+#define _POSIX_C_SOURCE 200809L
+#endif /* STR_STATS */
+
 #include <assert.h>
 #include <setjmp.h>
 #include <stdarg.h>
@@ -6,6 +10,10 @@
 
 #include <cmocka.h>
 
+#ifdef STR_STATS
+#include <pthread.h>
+#endif /* STR_STATS */
+
 #include "str.h"
 
 static void str_new_del_test(void** state) {
@@ -151,6 +159,185 @@ static void str_clear_test(void** state) {
     str_del(s);
 }
 
+static void str_append_char_full_test(void** state) {
+    (void) state;
+
+    /* leaves exactly one free byte, which the \0 needs */
+    str* s = str_from_view(str_view_of("Hello"));
+
+    str_append_view(s, str_view_of(", "));
+    str_append_view(s, str_view_of("world"));
+    str_append_char(s, '!');
+
+    assert_string_equal(str_cstr(s), "Hello, world!");
+
+    str_del(s);
+}
+
+static void str_truncate_test(void** state) {
+    (void) state;
+
+    str* s = str_new();
+
+    str_append(s, "Hello there!");
+
+    assert_true(str_truncate(s, 5));
+    assert_string_equal(str_cstr(s), "Hello");
+    assert_true(str_truncate(s, 10));
+    assert_string_equal(str_cstr(s), "Hello");
+
+    /* the capacity is kept */
+    char const* data = str_cstr(s);
+
+    assert_true(str_truncate(s, 0));
+    str_append(s, "Hi there!");
+    assert_string_equal(str_cstr(s), "Hi there!");
+    assert_ptr_equal(str_cstr(s), data);
+
+    str_del(s);
+}
+
+static void str_fill_test(void** state) {
+    (void) state;
+
+    str* s = str_from("ab");
+
+    assert_true(str_fill(s, '-', 5));
+    assert_string_equal(str_cstr(s), "ab-----");
+    assert_true(str_fill(s, '-', 0));
+    assert_string_equal(str_cstr(s), "ab-----");
+
+    str_del(s);
+}
+
+static void str_pad_test(void** state) {
+    (void) state;
+
+    str* s = str_from("42");
+
+    assert_true(str_pad_left(s, 5, '0'));
+    assert_string_equal(str_cstr(s), "00042");
+    assert_true(str_pad_left(s, 3, '0'));
+    assert_string_equal(str_cstr(s), "00042");
+
+    assert_true(str_pad_right(s, 8, '.'));
+    assert_string_equal(str_cstr(s), "00042...");
+    assert_true(str_pad_right(s, 8, '.'));
+    assert_string_equal(str_cstr(s), "00042...");
+
+    str_del(s);
+
+    s = str_from("mid");
+
+    assert_true(str_center(s, 8, '*'));
+    assert_string_equal(str_cstr(s), "**mid***");
+    assert_true(str_center(s, 10, ' '));
+    assert_string_equal(str_cstr(s), " **mid*** ");
+    assert_true(str_center(s, 4, ' '));
+    assert_string_equal(str_cstr(s), " **mid*** ");
+
+    str_del(s);
+
+    s = str_new();
+
+    assert_true(str_center(s, 3, '#'));
+    assert_string_equal(str_cstr(s), "###");
+
+    str_del(s);
+}
+
+static void str_repeat_test(void** state) {
+    (void) state;
+
+    str* s = str_repeat(str_view_of("ab"), 5);
+
+    assert_string_equal(str_cstr(s), "ababababab");
+    str_del(s);
+
+    s = str_repeat(str_view_of("-"), 1000);
+    assert_int_equal(str_len(s), 1000);
+    assert_int_equal(strspn(str_cstr(s), "-"), 1000);
+    str_del(s);
+
+    s = str_repeat(str_view_of("abc"), 0);
+    assert_string_equal(str_cstr(s), "");
+    str_del(s);
+
+    s = str_repeat(str_view_of(""), 100);
+    assert_string_equal(str_cstr(s), "");
+    str_del(s);
+
+    assert_null(str_repeat(str_view_of("ab"), SIZE_MAX / 2 + 1));
+}
+
+static void str_insert_test(void** state) {
+    (void) state;
+
+    str* s = str_from("held");
+
+    assert_true(str_insert(s, 0, str_view_of("we ")));
+    assert_string_equal(str_cstr(s), "we held");
+    assert_true(str_insert(s, 4, str_view_of("e")));
+    assert_string_equal(str_cstr(s), "we heeld");
+    assert_true(str_insert(s, str_len(s), str_view_of("!")));
+    assert_string_equal(str_cstr(s), "we heeld!");
+    assert_true(str_insert(s, 2, str_view_of("")));
+    assert_false(str_insert(s, 100, str_view_of("x")));
+    assert_string_equal(str_cstr(s), "we heeld!");
+
+    str_del(s);
+
+    /* views into the str itself, before, across and after pos */
+    struct {
+        size_t pos;
+        size_t start;
+        size_t len;
+        char const* expected;
+    } const cases[] = {
+        { 4, 0, 3, "abcdabcefgh" },
+        { 4, 2, 4, "abcdcdefefgh" },
+        { 4, 5, 3, "abcdfghefgh" },
+        { 0, 0, 8, "abcdefghabcdefgh" },
+        { 8, 0, 8, "abcdefghabcdefgh" },
+    };
+
+    for (size_t i = 0; i < sizeof cases / sizeof *cases; ++i) {
+        s = str_from("abcdefgh");
+
+        str_view v = { str_cstr(s) + cases[i].start, cases[i].len };
+
+        assert_true(str_insert(s, cases[i].pos, v));
+        assert_string_equal(str_cstr(s), cases[i].expected);
+
+        str_del(s);
+    }
+}
+
+static void str_append_str_full_test(void** state) {
+    (void) state;
+
+    /* exactly fills a new 8 byte str, so the \0 needs more room */
+    str* s = str_from_view(str_view_of("Hello"));
+    str* more = str_from("!!!");
+
+    assert_true(str_append_str(s, more));
+    assert_string_equal(str_cstr(s), "Hello!!!");
+
+    str_del(s);
+    str_del(more);
+}
+
+static void str_append_str_self_test(void** state) {
+    (void) state;
+
+    str* s = str_from("abc");
+
+    assert_true(str_append_str(s, s));
+    assert_string_equal(str_cstr(s), "abcabc");
+
+    str_del(s);
+}
+
 static void str_reverse_test(void** state) {
     (void) state;
 
@@ -189,6 +376,7 @@ static void str_remove_middle_test(void** state) {
     str_append(s, "Good, good, bad, good...");
 
     str_remove(s, 12, 17);
+    assert_int_equal(str_view_from_str(s).data[19], 0);
     assert_string_equal(str_cstr(s), "Good, good, good...");
     assert(str_len(s) == 19);
     assert_null(str_cstr(s)[str_len(s)]);
@@ -389,6 +577,98 @@ static void str_equal_ne_test(void** state) {
     str_del(s2);
 }
 
+static void str_compare_test(void** state) {
+    (void) state;
+
+    str* s1 = str_new();
+    str* s2 = str_new();
+
+    /* unlike str_cmp, the \0 counts */
+    str_append_view(s1, (str_view) { "hello there!\0hidden text!", 25 });
+    str_append(s2, "hello there!");
+
+    assert_true(str_compare(str_view_of(s1), str_view_of(s2)) > 0);
+    assert_true(str_compare(str_view_of(s2), str_view_of(s1)) < 0);
+    assert_int_equal(str_compare(str_view_of(s1), str_view_of(s1)), 0);
+    assert_int_equal(str_compare(str_view_of(""), str_view_of("")), 0);
+    assert_true(str_compare(str_view_of(""), str_view_of("a")) < 0);
+    /* bytes are unsigned */
+    assert_true(str_compare(str_view_of("\xe9"), str_view_of("z")) > 0);
+
+    /* differences at every position around the 16 and 32 byte blocks */
+    char a[100];
+    char b[100];
+
+    memset(a, 'x', sizeof a);
+
+    for (size_t len = 0; len <= sizeof a; ++len) {
+        for (size_t i = 0; i < len; ++i) {
+            memcpy(b, a, sizeof b);
+            b[i] = 'y';
+
+            str_view va = { a, len };
+            str_view vb = { b, len };
+
+            assert_true(str_compare(va, vb) < 0);
+            assert_true(str_compare(vb, va) > 0);
+            assert_int_equal(str_mismatch(va, vb), i);
+            assert_int_equal(str_common_prefix_len(va, vb), i);
+        }
+
+        str_view va = { a, len };
+
+        assert_int_equal(str_mismatch(va, va), STR_NPOS);
+        assert_int_equal(str_common_prefix_len(va, va), len);
+    }
+
+    str_del(s1);
+    str_del(s2);
+}
+
+static void str_mismatch_test(void** state) {
+    (void) state;
+
+    assert_int_equal(str_mismatch(str_view_of("abc"), str_view_of("abd")),
+            2);
+    assert_int_equal(str_mismatch(str_view_of("ab"), str_view_of("abc")), 2);
+    assert_int_equal(str_mismatch(str_view_of("abc"), str_view_of("ab")), 2);
+    assert_int_equal(str_mismatch(str_view_of(""), str_view_of("")),
+            STR_NPOS);
+    assert_int_equal(str_mismatch(str_view_of(""), str_view_of("a")), 0);
+
+    assert_int_equal(str_common_prefix_len(str_view_of("interstellar"),
+                str_view_of("internet")), 5);
+    assert_int_equal(str_common_prefix_len(str_view_of("ab"),
+                str_view_of("abc")), 2);
+    assert_int_equal(str_common_prefix_len((str_view) { (void*) 0, 0 },
+                str_view_of("abc")), 0);
+}
+
+static void str_starts_ends_with_test(void** state) {
+    (void) state;
+
+    str* s = str_from("prefix.body.suffix");
+
+    assert_true(str_starts_with(str_view_of(s), str_view_of("prefix.")));
+    assert_true(str_starts_with(str_view_of(s), str_view_of(s)));
+    assert_true(str_starts_with(str_view_of(s), str_view_of("")));
+    assert_false(str_starts_with(str_view_of(s), str_view_of("suffix")));
+    assert_false(str_starts_with(str_view_of("pre"), str_view_of("prefix")));
+
+    assert_true(str_ends_with(str_view_of(s), str_view_of(".suffix")));
+    assert_true(str_ends_with(str_view_of(s), str_view_of(s)));
+    assert_true(str_ends_with(str_view_of(s), str_view_of("")));
+    assert_false(str_ends_with(str_view_of(s), str_view_of("prefix")));
+    assert_false(str_ends_with(str_view_of("fix"), str_view_of("suffix")));
+
+    assert_true(str_starts_with((str_view) { (void*) 0, 0 },
+                str_view_of("")));
+    assert_false(str_ends_with((str_view) { (void*) 0, 0 },
+                str_view_of("x")));
+
+    str_del(s);
+}
+
 static void str_from_char_literal_test(void** state) {
     (void) state;
 
@@ -474,6 +754,259 @@ static void str_from_str_empty_test(void** state) {
     str_del(s);
 }
 
+static void str_view_of_test(void** state) {
+    (void) state;
+
+    str* s = str_from("view me");
+    char const* cstr = "and me";
+
+    str_view a = str_view_of(s);
+    str_view b = str_view_of(cstr);
+    str_view c = str_view_of(a);
+    str_view d = str_view_of((str*) 0);
+
+    assert_ptr_equal(a.data, str_cstr(s));
+    assert_int_equal(a.len, 7);
+    assert_ptr_equal(b.data, cstr);
+    assert_int_equal(b.len, 6);
+    assert_ptr_equal(c.data, a.data);
+    assert_int_equal(c.len, a.len);
+    assert_int_equal(d.len, 0);
+
+    str_del(s);
+}
+
+static void str_append_view_test(void** state) {
+    (void) state;
+
+    str* s = str_from("abc");
+    str_view v = { "de\0f", 4 };
+
+    str_append(s, v);
+
+    assert_int_equal(str_len(s), 7);
+    assert_memory_equal(str_cstr(s), "abcde\0f", 7);
+
+    str* f = str_from(v);
+
+    assert_int_equal(str_len(f), 4);
+    assert_memory_equal(str_cstr(f), "de\0f", 4);
+
+    str_del(f);
+    str_del(s);
+}
+
+static void str_append_many_test(void** state) {
+    (void) state;
+
+    str* s = str_from("<");
+    str* a = str_from("alpha");
+    str_view b = { "beta", 4 };
+
+    /* str objects, C strings and views mixed */
+    assert_true(str_append_many(s, a, ", ", b, ">"));
+
+    assert_string_equal(str_cstr(s), "<alpha, beta>");
+
+    /* appending a str to itself */
+    assert_true(str_append_many(s, s, s));
+
+    assert_string_equal(str_cstr(s),
+            "<alpha, beta><alpha, beta><alpha, beta>");
+
+    assert_true(str_append_many(s, "|"));
+    assert_true(str_append_many(s, "1", "2", "3", "4", "5", "6", "7", "8",
+                "9", "a", "b", "c", "d", "e", "f", "g"));
+    assert_string_equal(str_cstr(s) + str_len(s) - 17, "|123456789abcdefg");
+
+    str_view views[] = { str_view_of("x"), str_view_of(a) };
+
+    assert_true(str_append_views(s, views, 2));
+    assert_true(str_append_views(s, (void*) 0, 0));
+    assert_string_equal(str_cstr(s) + str_len(s) - 6, "xalpha");
+
+    str_del(a);
+    str_del(s);
+}
+
+static void str_append_growth_test(void** state) {
+    (void) state;
+
+    str_stats before;
+    str_stats after;
+    str* s = str_new();
+
+    str_stats_snapshot(&before);
+
+    for (int i = 0; i < 200000; ++i) {
+        assert_true(str_append_view(s, str_view_of("ab")));
+    }
+
+    str_stats_snapshot(&after);
+    assert_int_equal(str_len(s), 400000);
+
+#ifdef STR_STATS
+    /* the capacity doubles instead of fitting every append */
+    assert_true(after.reallocations - before.reallocations < 64);
+#endif /* STR_STATS */
+
+    str_del(s);
+}
+
+static void str_join_test(void** state) {
+    (void) state;
+
+    str* strs[3] = { str_from("a"), str_from("bb"), str_from("ccc") };
+    char const* cstrs[3] = { "x", "yy", "zzz" };
+    str_view views[2] = { { "1", 1 }, { "2", 1 } };
+
+    str* joined_strs = str_join(strs, 3, ", ");
+    str* joined_cstrs = str_join(cstrs, 3, strs[0]);
+    str* joined_views = str_join(views, 2, views[0]);
+    str* joined_one = str_join(cstrs, 1, "-");
+    str* joined_none = str_join(cstrs, 0, "-");
+
+    /* the usual type of an array of C strings */
+    char x[] = "x";
+    char y[] = "y";
+    char* mutable_cstrs[2] = { x, y };
+    char* const const_cstrs[2] = { y, x };
+    str* joined_mutable = str_join(mutable_cstrs, 2, "+");
+    str* joined_const = str_join(const_cstrs, 2, "+");
+
+    assert_string_equal(str_cstr(joined_mutable), "x+y");
+    assert_string_equal(str_cstr(joined_const), "y+x");
+
+    str_del(joined_mutable);
+    str_del(joined_const);
+
+    assert_string_equal(str_cstr(joined_strs), "a, bb, ccc");
+    assert_string_equal(str_cstr(joined_cstrs), "xayyazzz");
+    assert_string_equal(str_cstr(joined_views), "112");
+    assert_string_equal(str_cstr(joined_one), "x");
+    assert_string_equal(str_cstr(joined_none), "");
+
+    str_del(joined_strs);
+    str_del(joined_cstrs);
+    str_del(joined_views);
+    str_del(joined_one);
+    str_del(joined_none);
+
+    for (int i = 0; i < 3; ++i) {
+        str_del(strs[i]);
+    }
+}
+
+#ifdef STR_STATS
+static void* stats_worker(void* arg) {
+    (void) arg;
+
+    for (int i = 0; i < 10; ++i) {
+        str_del(str_from("worker"));
+    }
+
+    return (void*) 0;
+}
+#endif /* STR_STATS */
+
+static void str_stats_test(void** state) {
+    (void) state;
+
+    str_stats before;
+    str_stats after;
+
+    bool enabled = str_stats_snapshot(&before);
+
+    str* s = str_from("abc");
+    str_append(s, "defgh");
+    str_del(s);
+
+    assert_int_equal(str_stats_snapshot(&after), enabled);
+
+#ifdef STR_STATS
+    assert_int_equal(after.ops[STR_STATS_FROM] - before.ops[STR_STATS_FROM], 1);
+    assert_int_equal(after.ops[STR_STATS_APPEND]
+            - before.ops[STR_STATS_APPEND], 1);
+    assert_int_equal(after.ops[STR_STATS_DEL] - before.ops[STR_STATS_DEL], 1);
+    assert_int_equal(after.allocations - before.allocations,
+            after.frees - before.frees);
+    assert_int_equal(after.bytes_live, before.bytes_live);
+    assert_int_equal(after.bytes_used, before.bytes_used);
+
+    /* "abcdefgh" has 8 characters, which fall in [2^3, 2^4) */
+    assert_int_equal(after.sizes[4] - before.sizes[4], 1);
+
+    /* counters of exited threads are kept */
+    pthread_t thread;
+    pthread_create(&thread, (void*) 0, stats_worker, (void*) 0);
+    pthread_join(thread, (void*) 0);
+
+    str_stats_snapshot(&before);
+
+    assert_int_equal(before.ops[STR_STATS_DEL] - after.ops[STR_STATS_DEL], 10);
+#else
+    assert_int_equal(after.allocations, 0);
+#endif /* STR_STATS */
+
+    str* text = str_new();
+    str* json = str_new();
+
+    assert_true(str_stats_dump_text(&after, text));
+    assert_true(str_stats_dump_json(&after, json));
+
+    assert_int_equal(str_cstr(json)[0], '{');
+    assert_int_equal(str_cstr(json)[str_len(json) - 1], '}');
+    assert_int_not_equal(str_find(text, str_view_of("append"), 0), STR_NPOS);
+
+    str_del(text);
+    str_del(json);
+}
+
+static str* const FILE_SCOPE_LITERAL = STR_LIT("file scope");
+
+static void str_literal_test(void** state) {
+    (void) state;
+
+    str* method = STR_LIT("GET");
+    str* get = str_from("GET");
+
+    assert_int_equal(str_len(method), 3);
+    assert_string_equal(str_cstr(method), "GET");
+    assert_true(str_equal(method, get));
+    assert_int_equal(str_cmp(method, get), 0);
+    assert_int_equal(str_len(FILE_SCOPE_LITERAL), 10);
+
+    str* request = str_new();
+
+    str_append(request, method);
+    str_append(request, STR_LIT(" /index.html"));
+
+    assert_string_equal(str_cstr(request), "GET /index.html");
+    assert_int_equal(str_find(request, str_view_of(STR_LIT("/")), 0), 4);
+    assert_int_equal(str_count(STR_LIT("a,b,c"), str_view_of(",")), 2);
+
+    str* clone = str_clone(method);
+
+    assert_true(str_append(clone, 'S'));
+    assert_string_equal(str_cstr(clone), "GETS");
+
+    /* literals are immutable */
+    assert_false(str_append(method, 'S'));
+    assert_false(str_append(method, "S"));
+    assert_false(str_reserve(method, 1));
+    assert_false(str_clear(method));
+    assert_false(str_remove(method, 0, 1));
+
+    str_reverse(method);
+
+    assert_string_equal(str_cstr(method), "GET");
+
+    str_del(method);
+    str_del(clone);
+    str_del(request);
+    str_del(get);
+}
+
 int main(void) {
     struct CMUnitTest const tests[] = {
         cmocka_unit_test(str_new_del_test),
@@ -487,6 +1020,14 @@ int main(void) {
         cmocka_unit_test(str_append_cstr_empty_test),
         cmocka_unit_test(str_append_str_empty_test),
         cmocka_unit_test(str_clear_test),
+        cmocka_unit_test(str_truncate_test),
+        cmocka_unit_test(str_append_char_full_test),
+        cmocka_unit_test(str_fill_test),
+        cmocka_unit_test(str_pad_test),
+        cmocka_unit_test(str_repeat_test),
+        cmocka_unit_test(str_insert_test),
+        cmocka_unit_test(str_append_str_full_test),
+        cmocka_unit_test(str_append_str_self_test),
         cmocka_unit_test(str_reverse_test),
         cmocka_unit_test(str_remove_beginning_test),
         cmocka_unit_test(str_remove_middle_test),
@@ -501,6 +1042,9 @@ int main(void) {
         cmocka_unit_test(str_cmp_ne_test),
         cmocka_unit_test(str_equal_eq_test),
         cmocka_unit_test(str_equal_ne_test),
+        cmocka_unit_test(str_compare_test),
+        cmocka_unit_test(str_mismatch_test),
+        cmocka_unit_test(str_starts_ends_with_test),
         cmocka_unit_test(str_from_char_literal_test),
         cmocka_unit_test(str_from_cstr_literal_test),
         cmocka_unit_test(str_from_str_test),
@@ -508,6 +1052,13 @@ int main(void) {
         cmocka_unit_test(str_from_cstr_empty_test),
         cmocka_unit_test(str_from_str_null_test),
         cmocka_unit_test(str_from_str_empty_test),
+        cmocka_unit_test(str_view_of_test),
+        cmocka_unit_test(str_append_view_test),
+        cmocka_unit_test(str_append_many_test),
+        cmocka_unit_test(str_append_growth_test),
+        cmocka_unit_test(str_join_test),
+        cmocka_unit_test(str_stats_test),
+        cmocka_unit_test(str_literal_test),
     };
 
 
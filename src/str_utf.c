@@ -0,0 +1,569 @@
+#include <string.h>
+
+#include "str_utf.h"
+#include "str_simd.h"
+
+/* output is staged in a stack buffer and appended a chunk at a time */
+#define CHUNK 4096
+
+#define INVALID UINT32_MAX
+
+/* -- Private Interface -- */
+
+static bool surrogate(uint32_t cp) {
+    return cp >= 0xd800 && cp <= 0xdfff;
+}
+
+static bool high_surrogate(uint32_t cp) {
+    return cp >= 0xd800 && cp <= 0xdbff;
+}
+
+static bool low_surrogate(uint32_t cp) {
+    return cp >= 0xdc00 && cp <= 0xdfff;
+}
+
+/* -- ASCII Kernels -- */
+
+/* these work on whole blocks of ASCII and return how far they got,
+ * SSE2 is part of x86-64 so they need no check, elsewhere the scan
+ * goes a word at a time and the conversions are left to the callers */
+
+static size_t ascii_len(char const* s, size_t n) {
+    size_t i = 0;
+
+#ifdef STR_SIMD_X86
+    for (; i + 16 <= n; i += 16) {
+        if (_mm_movemask_epi8(_mm_loadu_si128((__m128i const*) (s + i)))) {
+            break;
+        }
+    }
+#else
+    for (; i + 8 <= n; i += 8) {
+        uint64_t w;
+
+        memcpy(&w, s + i, 8);
+
+        if (w & 0x8080808080808080u) {
+            break;
+        }
+    }
+#endif /* STR_SIMD_X86 */
+
+    return i;
+}
+
+static size_t ascii_to_utf16(uint16_t* out, char const* s, size_t n) {
+    size_t i = 0;
+
+#ifdef STR_SIMD_X86
+    __m128i const zero = _mm_setzero_si128();
+
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((__m128i const*) (s + i));
+
+        if (_mm_movemask_epi8(v)) {
+            break;
+        }
+
+        _mm_storeu_si128((__m128i*) (out + i), _mm_unpacklo_epi8(v, zero));
+        _mm_storeu_si128((__m128i*) (out + i + 8),
+                _mm_unpackhi_epi8(v, zero));
+    }
+#else
+    (void) out;
+    (void) s;
+    (void) n;
+#endif /* STR_SIMD_X86 */
+
+    return i;
+}
+
+static size_t ascii_to_utf32(uint32_t* out, char const* s, size_t n) {
+    size_t i = 0;
+
+#ifdef STR_SIMD_X86
+    __m128i const zero = _mm_setzero_si128();
+
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((__m128i const*) (s + i));
+
+        if (_mm_movemask_epi8(v)) {
+            break;
+        }
+
+        __m128i lo = _mm_unpacklo_epi8(v, zero);
+        __m128i hi = _mm_unpackhi_epi8(v, zero);
+
+        _mm_storeu_si128((__m128i*) (out + i), _mm_unpacklo_epi16(lo, zero));
+        _mm_storeu_si128((__m128i*) (out + i + 4),
+                _mm_unpackhi_epi16(lo, zero));
+        _mm_storeu_si128((__m128i*) (out + i + 8),
+                _mm_unpacklo_epi16(hi, zero));
+        _mm_storeu_si128((__m128i*) (out + i + 12),
+                _mm_unpackhi_epi16(hi, zero));
+    }
+#else
+    (void) out;
+    (void) s;
+    (void) n;
+#endif /* STR_SIMD_X86 */
+
+    return i;
+}
+
+#ifdef STR_SIMD_X86
+
+/* true if the 8 code units of v are ASCII */
+static bool ascii16(__m128i v) {
+    return _mm_movemask_epi8(_mm_cmpeq_epi16(
+                _mm_and_si128(v, _mm_set1_epi16(-0x80)),
+                _mm_setzero_si128())) == 0xffff;
+}
+
+/* true if the 4 code points of v are ASCII */
+static bool ascii32(__m128i v) {
+    return _mm_movemask_epi8(_mm_cmpeq_epi32(
+                _mm_and_si128(v, _mm_set1_epi32(-0x80)),
+                _mm_setzero_si128())) == 0xffff;
+}
+
+#endif /* STR_SIMD_X86 */
+
+static size_t utf16_ascii_len(uint16_t const* s, size_t n) {
+    size_t i = 0;
+
+#ifdef STR_SIMD_X86
+    for (; i + 8 <= n; i += 8) {
+        if (!ascii16(_mm_loadu_si128((__m128i const*) (s + i)))) {
+            break;
+        }
+    }
+#else
+    (void) s;
+    (void) n;
+#endif /* STR_SIMD_X86 */
+
+    return i;
+}
+
+static size_t utf16_to_ascii(char* out, uint16_t const* s, size_t n) {
+    size_t i = 0;
+
+#ifdef STR_SIMD_X86
+    for (; i + 16 <= n; i += 16) {
+        __m128i a = _mm_loadu_si128((__m128i const*) (s + i));
+        __m128i b = _mm_loadu_si128((__m128i const*) (s + i + 8));
+
+        if (!ascii16(a) || !ascii16(b)) {
+            break;
+        }
+
+        _mm_storeu_si128((__m128i*) (out + i), _mm_packus_epi16(a, b));
+    }
+#else
+    (void) out;
+    (void) s;
+    (void) n;
+#endif /* STR_SIMD_X86 */
+
+    return i;
+}
+
+static size_t utf32_ascii_len(uint32_t const* s, size_t n) {
+    size_t i = 0;
+
+#ifdef STR_SIMD_X86
+    for (; i + 4 <= n; i += 4) {
+        if (!ascii32(_mm_loadu_si128((__m128i const*) (s + i)))) {
+            break;
+        }
+    }
+#else
+    (void) s;
+    (void) n;
+#endif /* STR_SIMD_X86 */
+
+    return i;
+}
+
+static size_t utf32_to_ascii(char* out, uint32_t const* s, size_t n) {
+    size_t i = 0;
+
+#ifdef STR_SIMD_X86
+    for (; i + 16 <= n; i += 16) {
+        __m128i a = _mm_loadu_si128((__m128i const*) (s + i));
+        __m128i b = _mm_loadu_si128((__m128i const*) (s + i + 4));
+        __m128i c = _mm_loadu_si128((__m128i const*) (s + i + 8));
+        __m128i d = _mm_loadu_si128((__m128i const*) (s + i + 12));
+
+        if (!ascii32(a) || !ascii32(b) || !ascii32(c) || !ascii32(d)) {
+            break;
+        }
+
+        _mm_storeu_si128((__m128i*) (out + i), _mm_packus_epi16(
+                    _mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+    }
+#else
+    (void) out;
+    (void) s;
+    (void) n;
+#endif /* STR_SIMD_X86 */
+
+    return i;
+}
+
+/* -- UTF-8 -- */
+
+/* decodes the code point at i and moves i past it, or returns
+ * INVALID */
+static uint32_t decode(str_view v, size_t* i) {
+    unsigned char const* s = (unsigned char const*) v.data + *i;
+    size_t left = v.len - *i;
+    uint32_t cp = s[0];
+    size_t n;
+    uint32_t min;
+
+    if (cp < 0x80) {
+        *i += 1;
+        return cp;
+    } else if ((cp & 0xe0) == 0xc0) {
+        n = 2;
+        min = 0x80;
+        cp &= 0x1f;
+    } else if ((cp & 0xf0) == 0xe0) {
+        n = 3;
+        min = 0x800;
+        cp &= 0x0f;
+    } else if ((cp & 0xf8) == 0xf0) {
+        n = 4;
+        min = 0x10000;
+        cp &= 0x07;
+    } else {
+        return INVALID;
+    }
+
+    if (left < n) {
+        return INVALID;
+    }
+
+    for (size_t k = 1; k < n; ++k) {
+        if ((s[k] & 0xc0) != 0x80) {
+            return INVALID;
+        }
+
+        cp = cp << 6 | (s[k] & 0x3f);
+    }
+
+    /* overlong forms, surrogates and past the last plane */
+    if (cp < min || surrogate(cp) || cp > 0x10ffff) {
+        return INVALID;
+    }
+
+    *i += n;
+
+    return cp;
+}
+
+static size_t encode(char* out, uint32_t cp) {
+    if (cp < 0x80) {
+        out[0] = (char) cp;
+        return 1;
+    }
+
+    if (cp < 0x800) {
+        out[0] = (char) (0xc0 | cp >> 6);
+        out[1] = (char) (0x80 | (cp & 0x3f));
+        return 2;
+    }
+
+    if (cp < 0x10000) {
+        out[0] = (char) (0xe0 | cp >> 12);
+        out[1] = (char) (0x80 | (cp >> 6 & 0x3f));
+        out[2] = (char) (0x80 | (cp & 0x3f));
+        return 3;
+    }
+
+    out[0] = (char) (0xf0 | cp >> 18);
+    out[1] = (char) (0x80 | (cp >> 12 & 0x3f));
+    out[2] = (char) (0x80 | (cp >> 6 & 0x3f));
+    out[3] = (char) (0x80 | (cp & 0x3f));
+
+    return 4;
+}
+
+static size_t encoded_len(uint32_t cp) {
+    return cp < 0x80 ? 1 : cp < 0x800 ? 2 : cp < 0x10000 ? 3 : 4;
+}
+
+/* returns number of UTF-16 units, or code points if not utf16, of v,
+ * or STR_NPOS if it isn't valid */
+static size_t units(str_view v, bool utf16) {
+    if (!v.data && v.len) {
+        return STR_NPOS;
+    }
+
+    size_t n = 0;
+
+    for (size_t i = 0; i < v.len;) {
+        size_t ascii = ascii_len(v.data + i, v.len - i);
+
+        i += ascii;
+        n += ascii;
+
+        if (i == v.len) {
+            break;
+        }
+
+        uint32_t cp = decode(v, &i);
+
+        if (cp == INVALID) {
+            return STR_NPOS;
+        }
+
+        n += utf16 && cp >= 0x10000 ? 2 : 1;
+    }
+
+    return n;
+}
+
+/* appends len bytes of UTF-8 from n code points, which next reads
+ * and moves past, and to_ascii converts in runs */
+static bool append(str* self, size_t len, void const* s, size_t n,
+        uint32_t (*next)(void const* s, size_t* i),
+        size_t (*to_ascii)(char* out, void const* s, size_t i, size_t n)) {
+    if (!str_reserve(self, len)) {
+        return false;
+    }
+
+    char buf[CHUNK];
+    size_t used = 0;
+
+    for (size_t i = 0; i < n;) {
+        size_t ascii = to_ascii(buf + used, s, i,
+                n - i < CHUNK - used ? n - i : CHUNK - used);
+
+        used += ascii;
+        i += ascii;
+
+        /* room for the longest sequence */
+        if (used > CHUNK - 4) {
+            if (!str_append_view(self, (str_view) { buf, used })) {
+                return false;
+            }
+
+            used = 0;
+        }
+
+        if (i < n) {
+            used += encode(buf + used, next(s, &i));
+        }
+    }
+
+    return str_append_view(self, (str_view) { buf, used });
+}
+
+static uint32_t next16(void const* s, size_t* i) {
+    uint16_t const* u = s;
+    uint32_t cp = u[(*i)++];
+
+    /* pairs were checked up front */
+    if (high_surrogate(cp)) {
+        cp = 0x10000 + ((cp - 0xd800) << 10) + (u[(*i)++] - 0xdc00u);
+    }
+
+    return cp;
+}
+
+static size_t ascii16_run(char* out, void const* s, size_t i, size_t n) {
+    return utf16_to_ascii(out, (uint16_t const*) s + i, n);
+}
+
+static uint32_t next32(void const* s, size_t* i) {
+    return ((uint32_t const*) s)[(*i)++];
+}
+
+static size_t ascii32_run(char* out, void const* s, size_t i, size_t n) {
+    return utf32_to_ascii(out, (uint32_t const*) s + i, n);
+}
+
+/* -- Public Interface Implementation -- */
+
+bool str_utf8_valid(str_view v) {
+    return units(v, false) != STR_NPOS;
+}
+
+size_t str_utf16_len(str_view v) {
+    return units(v, true);
+}
+
+size_t str_to_utf16(str_view v, uint16_t* out, size_t n) {
+    if ((!v.data && v.len) || (!out && n)) {
+        return STR_NPOS;
+    }
+
+    size_t k = 0;
+
+    for (size_t i = 0; i < v.len;) {
+        if (k < n) {
+            size_t left = v.len - i < n - k ? v.len - i : n - k;
+            size_t ascii = ascii_to_utf16(out + k, v.data + i, left);
+
+            i += ascii;
+            k += ascii;
+
+            if (i == v.len) {
+                break;
+            }
+        }
+
+        uint32_t cp = decode(v, &i);
+
+        if (cp == INVALID || n - k < (cp >= 0x10000 ? 2u : 1u)) {
+            return STR_NPOS;
+        }
+
+        if (cp >= 0x10000) {
+            out[k++] = (uint16_t) (0xd800 + ((cp - 0x10000) >> 10));
+            out[k++] = (uint16_t) (0xdc00 + (cp & 0x3ff));
+        } else {
+            out[k++] = (uint16_t) cp;
+        }
+    }
+
+    return k;
+}
+
+bool str_append_utf16(str* self, uint16_t const* s, size_t n) {
+    if (!self || (!s && n)) {
+        return false;
+    }
+
+    size_t len = 0;
+
+    /* measures and validates */
+    for (size_t i = 0; i < n; ++i) {
+        size_t ascii = utf16_ascii_len(s + i, n - i);
+
+        i += ascii;
+        len += ascii;
+
+        if (i == n) {
+            break;
+        }
+
+        if (high_surrogate(s[i])) {
+            if (i + 1 == n || !low_surrogate(s[i + 1])) {
+                return false;
+            }
+
+            i++;
+            len += 4;
+        } else if (low_surrogate(s[i])) {
+            return false;
+        } else {
+            len += encoded_len(s[i]);
+        }
+    }
+
+    size_t before = str_len(self);
+
+    if (!append(self, len, s, n, next16, ascii16_run)) {
+        str_remove(self, before, str_len(self));
+        return false;
+    }
+
+    return true;
+}
+
+str* str_from_utf16(uint16_t const* s, size_t n) {
+    str* self = str_new();
+
+    if (!str_append_utf16(self, s, n)) {
+        str_del(self);
+        return (void*) 0;
+    }
+
+    return self;
+}
+
+size_t str_utf32_len(str_view v) {
+    return units(v, false);
+}
+
+size_t str_to_utf32(str_view v, uint32_t* out, size_t n) {
+    if ((!v.data && v.len) || (!out && n)) {
+        return STR_NPOS;
+    }
+
+    size_t k = 0;
+
+    for (size_t i = 0; i < v.len;) {
+        if (k < n) {
+            size_t left = v.len - i < n - k ? v.len - i : n - k;
+            size_t ascii = ascii_to_utf32(out + k, v.data + i, left);
+
+            i += ascii;
+            k += ascii;
+
+            if (i == v.len) {
+                break;
+            }
+        }
+
+        uint32_t cp = decode(v, &i);
+
+        if (cp == INVALID || k == n) {
+            return STR_NPOS;
+        }
+
+        out[k++] = cp;
+    }
+
+    return k;
+}
+
+bool str_append_utf32(str* self, uint32_t const* s, size_t n) {
+    if (!self || (!s && n)) {
+        return false;
+    }
+
+    size_t len = 0;
+
+    /* measures and validates */
+    for (size_t i = 0; i < n; ++i) {
+        size_t ascii = utf32_ascii_len(s + i, n - i);
+
+        i += ascii;
+        len += ascii;
+
+        if (i == n) {
+            break;
+        }
+
+        if (surrogate(s[i]) || s[i] > 0x10ffff) {
+            return false;
+        }
+
+        len += encoded_len(s[i]);
+    }
+
+    size_t before = str_len(self);
+
+    if (!append(self, len, s, n, next32, ascii32_run)) {
+        str_remove(self, before, str_len(self));
+        return false;
+    }
+
+    return true;
+}
+
+str* str_from_utf32(uint32_t const* s, size_t n) {
+    str* self = str_new();
+
+    if (!str_append_utf32(self, s, n)) {
+        str_del(self);
+        return (void*) 0;
+    }
+
+    return self;
+}
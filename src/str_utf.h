@@ -0,0 +1,129 @@
+/** str's Unicode Transcoding
+ * @file str_utf.h
+ *
+ * Conversions between the UTF-8 of str and UTF-16 or UTF-32 in native
+ * byte order, validating their input. Runs of ASCII, the common case,
+ * are converted 16 bytes at a time. */
+#ifndef STR_UTF_H
+#define STR_UTF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "str.h"
+
+/** Checks whether view is valid UTF-8.
+ * @note       Overlong forms, surrogates and code points past
+ *             U+10FFFF are invalid.
+ *
+ * @param v    A view.
+ *
+ * @return     true if v is valid. */
+bool str_utf8_valid(str_view v);
+
+/** Returns length of view in UTF-16.
+ * @param v    A view over UTF-8.
+ *
+ * @return     Number of code units, or STR_NPOS if v isn't valid
+ *             UTF-8.
+ *
+ * @see str_to_utf16 */
+size_t str_utf16_len(str_view v);
+
+/** Converts view from UTF-8 to UTF-16.
+ * @note       str_utf16_len gives the length out needs.
+ *
+ * @param v    A view over UTF-8.
+ * @param out  A pointer to an array of n code units, may be null if n
+ *             is 0.
+ * @param n    Length of out.
+ *
+ * @return     Number of code units written, or STR_NPOS if v isn't
+ *             valid UTF-8 or out is too short.
+ *
+ * @see str_utf16_len str_from_utf16 */
+size_t str_to_utf16(str_view v, uint16_t* out, size_t n);
+
+/** Appends UTF-16 to str as UTF-8.
+ * @note       It reserves the exact length up front, so it allocates
+ *             at most once.
+ *
+ * @param self A pointer to a str object.
+ * @param s    A pointer to an array of n code units.
+ * @param n    Number of code units.
+ *
+ * @return     true if successful, false if s holds unpaired
+ *             surrogates, in which case self is left unchanged.
+ *
+ * @see str_from_utf16 */
+bool str_append_utf16(str* self, uint16_t const* s, size_t n);
+
+/** Creates str from UTF-16.
+ * @warning    The user has to free the object after usage with
+ *             str_del.
+ *
+ * @param s    A pointer to an array of n code units.
+ * @param n    Number of code units.
+ *
+ * @return     A pointer to a str object or null if s holds unpaired
+ *             surrogates.
+ *
+ * @see str_append_utf16 str_to_utf16 str_del */
+str* str_from_utf16(uint16_t const* s, size_t n);
+
+/** Returns length of view in UTF-32, i.e. its number of code points.
+ * @param v    A view over UTF-8.
+ *
+ * @return     Number of code points, or STR_NPOS if v isn't valid
+ *             UTF-8.
+ *
+ * @see str_to_utf32 */
+size_t str_utf32_len(str_view v);
+
+/** Converts view from UTF-8 to UTF-32.
+ * @param v    A view over UTF-8.
+ * @param out  A pointer to an array of n code points, may be null if n
+ *             is 0.
+ * @param n    Length of out.
+ *
+ * @return     Number of code points written, or STR_NPOS if v isn't
+ *             valid UTF-8 or out is too short.
+ *
+ * @see str_utf32_len str_from_utf32 */
+size_t str_to_utf32(str_view v, uint32_t* out, size_t n);
+
+/** Appends UTF-32 to str as UTF-8.
+ * @param self A pointer to a str object.
+ * @param s    A pointer to an array of n code points.
+ * @param n    Number of code points.
+ *
+ * @return     true if successful, false if s holds surrogates or
+ *             values past U+10FFFF, in which case self is left
+ *             unchanged.
+ *
+ * @see str_from_utf32 */
+bool str_append_utf32(str* self, uint32_t const* s, size_t n);
+
+/** Creates str from UTF-32.
+ * @warning    The user has to free the object after usage with
+ *             str_del.
+ *
+ * @param s    A pointer to an array of n code points.
+ * @param n    Number of code points.
+ *
+ * @return     A pointer to a str object or null if s holds surrogates
+ *             or values past U+10FFFF.
+ *
+ * @see str_append_utf32 str_to_utf32 str_del */
+str* str_from_utf32(uint32_t const* s, size_t n);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* STR_UTF_H */
@@ -0,0 +1,207 @@
+#include <assert.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cmocka.h>
+
+#include "str.h"
+#include "str_utf.h"
+
+/* "aé€😀" */
+static char const utf8[] = "a\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80";
+static uint16_t const utf16[] = { 0x61, 0xe9, 0x20ac, 0xd83d, 0xde00 };
+static uint32_t const utf32[] = { 0x61, 0xe9, 0x20ac, 0x1f600 };
+
+/* random code points, long ASCII runs now and then */
+static size_t random_utf32(uint32_t* out, size_t max) {
+    size_t n = 0;
+
+    while (n < max) {
+        if (rand() % 4 == 0) {
+            for (int k = rand() % 80; k > 0 && n < max; --k) {
+                out[n++] = 0x20 + (uint32_t) (rand() % 0x5f);
+            }
+
+            continue;
+        }
+
+        uint32_t cp;
+
+        switch (rand() % 4) {
+        case 0: cp = (uint32_t) rand() % 0x80; break;
+        case 1: cp = 0x80 + (uint32_t) rand() % 0x780; break;
+        case 2: cp = 0x800 + (uint32_t) rand() % 0xf800; break;
+        default: cp = 0x10000 + (uint32_t) rand() % 0x100000; break;
+        }
+
+        if (cp >= 0xd800 && cp <= 0xdfff) {
+            continue;
+        }
+
+        out[n++] = cp;
+    }
+
+    return n;
+}
+
+static void str_utf16_test(void** state) {
+    (void) state;
+
+    str_view v = str_view_of(utf8);
+    uint16_t out[8];
+
+    assert_int_equal(str_utf16_len(v), 5);
+    assert_int_equal(str_to_utf16(v, out, 8), 5);
+    assert_memory_equal(out, utf16, sizeof utf16);
+    /* too short, by a whole pair or half of one */
+    assert_int_equal(str_to_utf16(v, out, 3), STR_NPOS);
+    assert_int_equal(str_to_utf16(v, out, 4), STR_NPOS);
+    assert_int_equal(str_to_utf16(str_view_of(""), (void*) 0, 0), 0);
+
+    str* s = str_from_utf16(utf16, 5);
+
+    assert_string_equal(str_cstr(s), utf8);
+
+    uint16_t const unpaired[][2] = {
+        { 0xd83d, 0x61 }, { 0xde00, 0x61 }, { 0x61, 0xd83d },
+    };
+
+    for (size_t i = 0; i < sizeof unpaired / sizeof *unpaired; ++i) {
+        assert_false(str_append_utf16(s, unpaired[i], 2));
+        assert_string_equal(str_cstr(s), utf8);
+        assert_null(str_from_utf16(unpaired[i], 2));
+    }
+
+    str_del(s);
+}
+
+static void str_utf32_test(void** state) {
+    (void) state;
+
+    str_view v = str_view_of(utf8);
+    uint32_t out[8];
+
+    assert_int_equal(str_utf32_len(v), 4);
+    assert_int_equal(str_to_utf32(v, out, 8), 4);
+    assert_memory_equal(out, utf32, sizeof utf32);
+    assert_int_equal(str_to_utf32(v, out, 3), STR_NPOS);
+
+    str* s = str_from_utf32(utf32, 4);
+
+    assert_string_equal(str_cstr(s), utf8);
+
+    uint32_t const invalid[] = { 0xd800, 0xdfff, 0x110000, UINT32_MAX };
+
+    for (size_t i = 0; i < sizeof invalid / sizeof *invalid; ++i) {
+        assert_false(str_append_utf32(s, &invalid[i], 1));
+        assert_string_equal(str_cstr(s), utf8);
+        assert_null(str_from_utf32(&invalid[i], 1));
+    }
+
+    str_del(s);
+}
+
+static void str_utf8_valid_test(void** state) {
+    (void) state;
+
+    char const* valid[] = {
+        "", "ascii", "\xc2\x80", "\xdf\xbf", "\xe0\xa0\x80", "\xed\x9f\xbf",
+        "\xee\x80\x80", "\xf0\x90\x80\x80", "\xf4\x8f\xbf\xbf",
+    };
+    char const* invalid[] = {
+        /* stray continuation and bytes never used */
+        "\x80", "\xbf", "\xfe", "\xff", "\xf8\x88\x80\x80\x80",
+        /* overlong */
+        "\xc0\x80", "\xc1\xbf", "\xe0\x9f\xbf", "\xf0\x8f\xbf\xbf",
+        /* surrogates */
+        "\xed\xa0\x80", "\xed\xbf\xbf",
+        /* past U+10FFFF */
+        "\xf4\x90\x80\x80", "\xf5\x80\x80\x80",
+        /* truncated */
+        "\xc3", "\xe2\x82", "\xf0\x9f\x98", "\xe2\x82x",
+    };
+
+    for (size_t i = 0; i < sizeof valid / sizeof *valid; ++i) {
+        assert_true(str_utf8_valid(str_view_of(valid[i])));
+    }
+
+    for (size_t i = 0; i < sizeof invalid / sizeof *invalid; ++i) {
+        str_view v = str_view_of(invalid[i]);
+        uint16_t u16[8];
+        uint32_t u32[8];
+
+        assert_false(str_utf8_valid(v));
+        assert_int_equal(str_utf16_len(v), STR_NPOS);
+        assert_int_equal(str_utf32_len(v), STR_NPOS);
+        assert_int_equal(str_to_utf16(v, u16, 8), STR_NPOS);
+        assert_int_equal(str_to_utf32(v, u32, 8), STR_NPOS);
+    }
+
+    /* invalid after a long ASCII run */
+    char run[100];
+
+    memset(run, 'x', sizeof run);
+    run[90] = '\xff';
+
+    assert_false(str_utf8_valid((str_view) { run, sizeof run }));
+}
+
+static void str_utf_round_trip_test(void** state) {
+    (void) state;
+
+    enum { MAX = 3000 };
+    uint32_t* cps = malloc(MAX * sizeof *cps);
+    uint32_t* u32 = malloc(MAX * sizeof *u32);
+    uint16_t* u16 = malloc(2 * MAX * sizeof *u16);
+
+    srand(40);
+
+    for (int round = 0; round < 300; ++round) {
+        size_t max = round < 200 ? 40 : MAX;
+        size_t n = random_utf32(cps, (size_t) rand() % max);
+        str* s = str_from_utf32(cps, n);
+
+        assert_non_null(s);
+        assert_true(str_utf8_valid(str_view_of(s)));
+        assert_int_equal(str_utf32_len(str_view_of(s)), n);
+        assert_int_equal(str_to_utf32(str_view_of(s), u32, n), n);
+        assert_memory_equal(u32, cps, n * sizeof *cps);
+
+        size_t len = str_utf16_len(str_view_of(s));
+
+        assert_int_equal(str_to_utf16(str_view_of(s), u16, 2 * MAX), len);
+
+        if (len) {
+            assert_int_equal(str_to_utf16(str_view_of(s), u16, len - 1),
+                    STR_NPOS);
+        }
+
+        str* back = str_from_utf16(u16, len);
+
+        assert_true(str_equal(back, s));
+
+        str_del(s);
+        str_del(back);
+    }
+
+    free(cps);
+    free(u32);
+    free(u16);
+}
+
+
+int main(void) {
+    struct CMUnitTest const tests[] = {
+        cmocka_unit_test(str_utf16_test),
+        cmocka_unit_test(str_utf32_test),
+        cmocka_unit_test(str_utf8_valid_test),
+        cmocka_unit_test(str_utf_round_trip_test),
+    };
+
+
+    return cmocka_run_group_tests(tests, (void*) 0, (void*) 0);
+}